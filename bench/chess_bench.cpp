@@ -0,0 +1,189 @@
+// Google Benchmark microbenchmarks of the rules engine.
+// Usage: chess_bench [--benchmark_filter=REGEX] [--benchmark_out=FILE --benchmark_out_format=json]
+// (the run_chess_bench build target does the latter into chess_bench.json).
+#include "Game.h"
+#include "GameTree.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+// Typical middlegame positions with plenty of pieces and both sides castled or about to.
+const char* const kMiddlegames[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "2rq1rk1/pp1bppbp/2np1np1/8/3NP3/1BN1BP2/PPPQ2PP/2KR3R b - - 0 11",
+};
+const char* const kCheckmate = "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3";
+const char* const kStalemate = "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1";
+
+std::vector<Game> middlegames(benchmark::State& state) {
+    std::vector<Game> games(std::size(kMiddlegames));
+    for (size_t i = 0; i < games.size(); ++i) {
+        if (!games[i].setFen(kMiddlegames[i])) state.SkipWithError("bad FEN");
+    }
+    return games;
+}
+
+void BM_GetPieceAt(benchmark::State& state) {
+    Game game;
+    game.setFen(kMiddlegames[0]);
+    const Board& board = game.getBoard();
+    for (auto _ : state) {
+        int occupied = 0;
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 8; ++x) occupied += board.getPieceAt(x, y) != nullptr;
+        }
+        benchmark::DoNotOptimize(occupied);
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_GetPieceAt);
+
+// Every piece of the given type on the middlegame boards against every target square.
+void BM_IsValidMove(benchmark::State& state) {
+    auto type = static_cast<PieceType>(state.range(0));
+    std::vector<Game> games = middlegames(state);
+    const char* names[] = {"king", "queen", "rook", "bishop", "knight", "pawn"};
+    state.SetLabel(names[state.range(0)]);
+    int64_t checks = 0;
+    for (auto _ : state) {
+        int valid = 0;
+        checks = 0;
+        for (const Game& game : games) {
+            const Board& board = game.getBoard();
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    const auto& piece = board.getPieceAt(x, y);
+                    if (!piece || piece->getType() != type) continue;
+                    for (int ty = 0; ty < 8; ++ty) {
+                        for (int tx = 0; tx < 8; ++tx) valid += board.isValidMove(piece, tx, ty);
+                    }
+                    checks += 64;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(valid);
+    }
+    state.SetItemsProcessed(state.iterations() * checks);
+}
+BENCHMARK(BM_IsValidMove)->DenseRange(static_cast<int>(PieceType::King), static_cast<int>(PieceType::Pawn));
+
+// Each legal move of the middlegame positions made and taken back.
+void BM_MakeUndoMove(benchmark::State& state) {
+    std::vector<Game> games = middlegames(state);
+    std::vector<std::vector<MoveCoords>> moves;
+    int64_t perIteration = 0;
+    for (Game& game : games) {
+        moves.push_back(game.getLegalMoves());
+        perIteration += static_cast<int64_t>(moves.back().size());
+    }
+    for (auto _ : state) {
+        for (size_t i = 0; i < games.size(); ++i) {
+            for (const MoveCoords& mv : moves[i]) {
+                games[i].makeMove(mv.fromX, mv.fromY, mv.toX, mv.toY, mv.promotion.value_or(PieceType::Queen));
+                games[i].undoMove();
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * perIteration);
+}
+BENCHMARK(BM_MakeUndoMove);
+
+void BM_IsInCheck(benchmark::State& state) {
+    std::vector<Game> games = middlegames(state);
+    for (auto _ : state) {
+        for (const Game& game : games) {
+            benchmark::DoNotOptimize(game.isInCheck(Color::White));
+            benchmark::DoNotOptimize(game.isInCheck(Color::Black));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(games.size()) * 2);
+}
+BENCHMARK(BM_IsInCheck);
+
+// isCheckmate/isStalemate answer from the status cache once it is filled, so every timed call
+// must see a fresh position: a batch of games is reset outside the timed region, which also spreads
+// the pause/resume cost over the batch.
+template <typename Query>
+void timeFreshStatus(benchmark::State& state, const char* fen, Query query) {
+    PositionSetup setup;
+    if (!Game::parseFen(fen, setup)) {
+        state.SkipWithError("bad FEN");
+        return;
+    }
+    std::vector<Game> games(64);
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (Game& game : games) game.setPosition(setup);
+        state.ResumeTiming();
+        for (Game& game : games) benchmark::DoNotOptimize(query(game));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(games.size()));
+}
+
+// Arg 0: a middlegame position (the usual case, not terminal); 1: a position where the answer is yes.
+void BM_IsCheckmate(benchmark::State& state) {
+    timeFreshStatus(state, state.range(0) ? kCheckmate : kMiddlegames[1], [](Game& game) { return game.isCheckmate(); });
+}
+BENCHMARK(BM_IsCheckmate)->Arg(0)->Arg(1);
+
+void BM_IsStalemate(benchmark::State& state) {
+    timeFreshStatus(state, state.range(0) ? kStalemate : kMiddlegames[1], [](Game& game) { return game.isStalemate(); });
+}
+BENCHMARK(BM_IsStalemate)->Arg(0)->Arg(1);
+
+// Save and reload of a 40-ply game, per save format.
+void BM_SaveLoadRoundTrip(benchmark::State& state) {
+    auto format = static_cast<SaveFormat>(state.range(0));
+    const char* extensions[] = {"", ".json", ".fen", ".bin"};
+    std::string path = "chess_bench_save" + std::string(extensions[state.range(0)]);
+    state.SetLabel(extensions[state.range(0)] + 1);
+
+    Game game;
+    game.start();
+    for (int ply = 0; ply < 40; ++ply) {
+        auto moves = game.getLegalMoves();
+        if (moves.empty()) break;
+        const MoveCoords& mv = moves[static_cast<size_t>(ply * 7) % moves.size()];
+        game.makeMove(mv.fromX, mv.fromY, mv.toX, mv.toY, mv.promotion.value_or(PieceType::Queen));
+    }
+    Game loaded;
+    for (auto _ : state) {
+        game.saveToFile(path, format);
+        loaded.loadFromFile(path, format);
+    }
+    if (loaded.fen() != game.fen()) state.SkipWithError("round trip changed the position");
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_SaveLoadRoundTrip)
+    ->Arg(static_cast<int>(SaveFormat::Json))
+    ->Arg(static_cast<int>(SaveFormat::Fen))
+    ->Arg(static_cast<int>(SaveFormat::Binary));
+// Scrubbing through a 300-ply game: jumps to pseudo-random plies, per checkpoint interval.
+void BM_GameTreeGoToPly(benchmark::State& state) {
+    Game game;
+    game.start();
+    for (int ply = 0; ply < 300; ++ply) {
+        auto moves = game.getLegalMoves();
+        if (moves.empty()) break;
+        const MoveCoords& mv = moves[static_cast<size_t>(ply * 7) % moves.size()];
+        game.makeMove(mv.fromX, mv.fromY, mv.toX, mv.toY, mv.promotion.value_or(PieceType::Queen));
+    }
+    GameTree tree(static_cast<int>(state.range(0)));
+    tree.playLine(game.getMoveHistory());
+    int length = tree.lineLength();
+    state.SetLabel(std::to_string(length) + " plies");
+    uint32_t seed = 12345;
+    for (auto _ : state) {
+        seed = seed * 1664525u + 1013904223u;
+        tree.goToPly(static_cast<int>((seed >> 8) % static_cast<uint32_t>(length + 1)));
+        benchmark::DoNotOptimize(tree.current());
+    }
+}
+BENCHMARK(BM_GameTreeGoToPly)->Arg(8)->Arg(16)->Arg(32)->Arg(1 << 20);
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,80 @@
+// Round-trip latency and throughput of UciEngine against the mock engine.
+// Usage: engine_bench [engine-path] [iterations]
+#include "UciEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef MOCK_UCI_ENGINE_PATH
+#define MOCK_UCI_ENGINE_PATH "mock_uci_engine"
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+    return samples[index];
+}
+
+void report(const std::string& name, const std::vector<double>& micros, double totalSeconds, long long lines) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+              << " p50 " << std::setw(9) << percentile(micros, 0.50) << " us"
+              << "  p99 " << std::setw(9) << percentile(micros, 0.99) << " us"
+              << "  " << std::setw(10) << static_cast<double>(micros.size()) / totalSeconds << " req/s";
+    if (lines > 0) {
+        std::cout << "  " << std::setw(12) << static_cast<double>(lines) / totalSeconds << " lines/s";
+    }
+    std::cout << '\n';
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string path = (argc > 1) ? argv[1] : MOCK_UCI_ENGINE_PATH;
+    int iterations = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 2000;
+
+    UciEngine engine;
+    if (!engine.start(path, 20)) {
+        std::cerr << "Failed to start engine at: " << path << "\n";
+        return 1;
+    }
+
+    {
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        auto begin = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            auto t0 = Clock::now();
+            engine.isReady();
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+        double total = std::chrono::duration<double>(Clock::now() - begin).count();
+        report("isready round trip", samples, total, 0);
+    }
+
+    const std::vector<std::string> moves = {"e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "g8f6"};
+    for (int infoLines : {0, 100, 1000}) {
+        engine.setOption("InfoLines", std::to_string(infoLines));
+        int searches = std::max(1, infoLines >= 1000 ? iterations / 10 : iterations / 2);
+        std::vector<double> samples;
+        samples.reserve(searches);
+        auto begin = Clock::now();
+        for (int i = 0; i < searches; ++i) {
+            auto t0 = Clock::now();
+            engine.bestMove(moves, 0);
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+        double total = std::chrono::duration<double>(Clock::now() - begin).count();
+        report("bestmove, " + std::to_string(infoLines) + " info lines", samples, total,
+               static_cast<long long>(infoLines + 1) * searches);
+    }
+
+    engine.stop();
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "Annotator.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <sstream>
+#include <thread>
+#include "EnginePlayer.h"
+#include "Pgn.h"
+
+namespace {
+constexpr int kMateValue = 10000;
+
+int toCentipawns(const AnalysisResult& result) {
+    if (result.lines.empty()) return 0;
+    const PvLine& line = result.lines.front();
+    if (!line.mate) return line.score;
+    if (line.score == 0) return -kMateValue; // side to move is mated
+    return line.score > 0 ? kMateValue - line.score : -kMateValue - line.score;
+}
+
+void setUp(Game& game, const std::string& startFen) {
+    if (startFen.empty() || !game.setFen(startFen)) game.start();
+}
+
+void play(Game& game, const MoveCoords& mv) {
+    game.makeMove(mv.fromX, mv.fromY, mv.toX, mv.toY, mv.promotion.value_or(PieceType::Queen));
+}
+
+std::string formatEval(int cp) {
+    std::ostringstream out;
+    if (std::abs(cp) >= kMateValue - 500) {
+        int moves = kMateValue - std::abs(cp);
+        out << (cp > 0 ? "#" : "#-");
+        if (moves > 0) out << moves;
+    } else {
+        out.setf(std::ios::fixed);
+        out.precision(2);
+        out << (cp >= 0 ? "+" : "") << cp / 100.0;
+    }
+    return out.str();
+}
+} // namespace
+
+const char* toString(MoveQuality quality) {
+    switch (quality) {
+        case MoveQuality::Best: return "best";
+        case MoveQuality::Good: return "good";
+        case MoveQuality::Inaccuracy: return "inaccuracy";
+        case MoveQuality::Mistake: return "mistake";
+        case MoveQuality::Blunder: return "blunder";
+    }
+    return "";
+}
+
+std::vector<PlyAnnotation> Annotator::annotate(EnginePool& pool, const std::string& startFen,
+                                               const std::vector<MoveCoords>& moves, const SearchLimits& limits) const {
+    std::vector<std::future<AnalysisResult>> pending;
+    std::vector<std::string> prefix;
+    pending.reserve(moves.size() + 1);
+    for (size_t ply = 0; ply <= moves.size(); ++ply) {
+        AnalysisRequest request{startFen, prefix, limits};
+        request.limits.multiPv = 1;
+        pending.push_back(pool.submit(std::move(request)));
+        if (ply < moves.size()) prefix.push_back(toUci(moves[ply]));
+    }
+    std::vector<AnalysisResult> evals;
+    evals.reserve(pending.size());
+    for (auto& future : pending) evals.push_back(future.get());
+    return classify(startFen, moves, evals);
+}
+
+std::vector<PlyAnnotation> Annotator::annotateNative(int threads, const std::string& startFen,
+                                                     const std::vector<MoveCoords>& moves,
+                                                     const SearchLimits& limits) const {
+    std::vector<AnalysisResult> evals(moves.size() + 1);
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        EngineSpec spec;
+        spec.limits = limits;
+        EnginePlayer player(spec);
+        for (size_t ply = next++; ply < evals.size(); ply = next++) {
+            Game game;
+            setUp(game, startFen);
+            for (size_t i = 0; i < ply; ++i) play(game, moves[i]);
+            evals[ply] = player.think(game, startFen, {});
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < std::max(1, threads); ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    return classify(startFen, moves, evals);
+}
+
+std::vector<PlyAnnotation> Annotator::classify(const std::string& startFen, const std::vector<MoveCoords>& moves,
+                                               const std::vector<AnalysisResult>& evals) const {
+    std::vector<PlyAnnotation> annotations;
+    annotations.reserve(moves.size());
+    Game game;
+    setUp(game, startFen);
+    for (size_t ply = 0; ply < moves.size(); ++ply) {
+        PlyAnnotation note;
+        note.move = moves[ply];
+        note.san = toSan(game, moves[ply]);
+        note.bestMove = evals[ply].bestMove;
+        if (auto best = parseUci(note.bestMove)) note.bestSan = toSan(game, *best);
+        note.evalBefore = toCentipawns(evals[ply]);
+        play(game, moves[ply]);
+        // Engines report nothing useful for a finished game, so score mate/stalemate directly.
+        if (game.isCheckmate()) {
+            note.evalAfter = kMateValue;
+        } else if (game.isStalemate()) {
+            note.evalAfter = 0;
+        } else {
+            note.evalAfter = -toCentipawns(evals[ply + 1]);
+        }
+        note.loss = std::max(0, note.evalBefore - note.evalAfter);
+
+        if (toUci(note.move) == note.bestMove) {
+            note.quality = MoveQuality::Best;
+        } else if (note.loss >= thresholds.blunder) {
+            note.quality = MoveQuality::Blunder;
+        } else if (note.loss >= thresholds.mistake) {
+            note.quality = MoveQuality::Mistake;
+        } else if (note.loss >= thresholds.inaccuracy) {
+            note.quality = MoveQuality::Inaccuracy;
+        } else {
+            note.quality = MoveQuality::Good;
+        }
+        annotations.push_back(std::move(note));
+    }
+    return annotations;
+}
+
+void Annotator::writePgn(std::ostream& out, const Game& game, const std::string& startFen,
+                         const std::vector<PlyAnnotation>& annotations, const std::string& result) {
+    PgnGame pgn;
+    pgn.result = result;
+    pgn.tags = {
+        {"Event", "Annotated game"},
+        {"Site", "?"},
+        {"Date", "????.??.??"},
+        {"Round", "-"},
+        {"White", game.getPlayerName(Color::White)},
+        {"Black", game.getPlayerName(Color::Black)},
+        {"Result", result},
+    };
+    Game start;
+    setUp(start, startFen);
+    Game initial;
+    initial.start();
+    if (start.fen() != initial.fen()) {
+        pgn.tags.emplace_back("SetUp", "1");
+        pgn.tags.emplace_back("FEN", start.fen());
+    }
+    pgn.tags.emplace_back("Annotator", "2Q1K");
+    pgn.blackMovesFirst = !start.isWhiteTurn();
+    pgn.firstMoveNumber = start.getMoveCount() / 2 + 1;
+
+    bool whiteMoves = start.isWhiteTurn();
+    for (const auto& note : annotations) {
+        pgn.sanMoves.push_back(note.san);
+        std::string text;
+        switch (note.quality) {
+            case MoveQuality::Inaccuracy: text = "$6 "; break;
+            case MoveQuality::Mistake: text = "$2 "; break;
+            case MoveQuality::Blunder: text = "$4 "; break;
+            default: break;
+        }
+        // PGN evals are conventionally from White's side.
+        text += "{" + formatEval(whiteMoves ? note.evalAfter : -note.evalAfter);
+        if (note.quality >= MoveQuality::Inaccuracy && !note.bestSan.empty()) {
+            text += ", " + std::string(toString(note.quality)) + ", best was " + note.bestSan;
+        }
+        text += "}";
+        pgn.moveAnnotations.push_back(text);
+        whiteMoves = !whiteMoves;
+    }
+    ::writePgn(out, pgn);
+}
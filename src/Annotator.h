@@ -0,0 +1,51 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "EnginePool.h"
+#include "Game.h"
+
+enum class MoveQuality { Best, Good, Inaccuracy, Mistake, Blunder };
+
+// Eval drop (centipawns, from the mover's point of view) at which a move gets each label.
+struct AnnotationThresholds {
+    int inaccuracy = 50;
+    int mistake = 100;
+    int blunder = 300;
+};
+
+struct PlyAnnotation {
+    MoveCoords move;
+    std::string san;
+    std::string bestMove; // engine's choice in the position before the move (UCI)
+    std::string bestSan;
+    int evalBefore = 0;   // mover's point of view, mates mapped to +/-(10000 - moves)
+    int evalAfter = 0;
+    int loss = 0;
+    MoveQuality quality = MoveQuality::Good;
+};
+
+// Evaluates every position of a finished game and labels each move by how much it dropped the eval.
+// Positions are independent, so they are searched concurrently: either over a UCI engine pool or
+// by `threads` native searchers.
+class Annotator {
+public:
+    explicit Annotator(AnnotationThresholds thresholds = {}) : thresholds(thresholds) {}
+
+    std::vector<PlyAnnotation> annotate(EnginePool& pool, const std::string& startFen,
+                                        const std::vector<MoveCoords>& moves, const SearchLimits& limits) const;
+    std::vector<PlyAnnotation> annotateNative(int threads, const std::string& startFen,
+                                              const std::vector<MoveCoords>& moves, const SearchLimits& limits) const;
+
+    // Writes the game as PGN with NAGs (?! ? ??) and eval/best-move comments.
+    static void writePgn(std::ostream& out, const Game& game, const std::string& startFen,
+                         const std::vector<PlyAnnotation>& annotations, const std::string& result = "*");
+
+private:
+    std::vector<PlyAnnotation> classify(const std::string& startFen, const std::vector<MoveCoords>& moves,
+                                        const std::vector<AnalysisResult>& evals) const;
+
+    AnnotationThresholds thresholds;
+};
+
+const char* toString(MoveQuality quality);
@@ -0,0 +1,189 @@
+#include "BinarySave.h"
+#include <array>
+#include <cstring>
+#include <fstream>
+#include "MappedFile.h"
+
+namespace {
+constexpr char kMagic[4] = {'2', 'Q', 'K', 'B'};
+constexpr size_t kHeaderSize = 16;
+constexpr char kPieceLetters[] = "PNBRQK";
+
+void put16(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+uint32_t get16(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8;
+}
+
+uint32_t get32(const uint8_t* p) {
+    return get16(p) | get16(p + 2) << 16;
+}
+
+void putName(std::vector<uint8_t>& out, const std::string& name) {
+    size_t length = std::min<size_t>(name.size(), 255);
+    out.push_back(static_cast<uint8_t>(length));
+    out.insert(out.end(), name.begin(), name.begin() + static_cast<std::ptrdiff_t>(length));
+}
+
+std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}
+} // namespace
+
+uint32_t crc32(const void* data, size_t size) {
+    static const std::array<uint32_t, 256> table = makeCrcTable();
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+bool packPosition(const PositionSetup& setup, uint8_t* out) {
+    std::memset(out, 0, kPackedPositionSize);
+    uint64_t occupancy = 0;
+    int count = 0;
+    for (int square = 0; square < 64; ++square) {
+        char symbol = setup.squares[square / 8][square % 8];
+        if (symbol == '.') continue;
+        bool black = symbol >= 'a';
+        const char* letter = std::strchr(kPieceLetters, black ? symbol - 'a' + 'A' : symbol);
+        if (!letter || !*letter || count == 32) return false;
+        uint8_t code = static_cast<uint8_t>((letter - kPieceLetters + 1) | (black ? 8 : 0));
+        out[8 + count / 2] |= static_cast<uint8_t>(count % 2 ? code << 4 : code);
+        occupancy |= uint64_t{1} << square;
+        ++count;
+    }
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<uint8_t>(occupancy >> (8 * i));
+    out[24] = static_cast<uint8_t>((setup.whiteToMove ? 0 : 1) | (setup.castling & 15) << 1);
+    out[25] = static_cast<uint8_t>(setup.enPassantFile + 1);
+    out[26] = static_cast<uint8_t>(std::min(setup.halfmoveClock, 255));
+    int fullmove = std::min(std::max(setup.fullmoveNumber, 1), 0xFFFF);
+    out[28] = static_cast<uint8_t>(fullmove);
+    out[29] = static_cast<uint8_t>(fullmove >> 8);
+    return true;
+}
+
+bool unpackPosition(const uint8_t* in, PositionSetup& setup) {
+    PositionSetup result;
+    uint64_t occupancy = 0;
+    for (int i = 0; i < 8; ++i) occupancy |= uint64_t{in[i]} << (8 * i);
+    int count = 0;
+    for (int square = 0; square < 64; ++square) {
+        char& symbol = result.squares[square / 8][square % 8];
+        symbol = '.';
+        if (!(occupancy >> square & 1)) continue;
+        if (count == 32) return false;
+        uint8_t code = (count % 2 ? in[8 + count / 2] >> 4 : in[8 + count / 2]) & 15;
+        int index = (code & 7) - 1;
+        if (index < 0 || index > 5) return false;
+        symbol = (code & 8) ? static_cast<char>(kPieceLetters[index] - 'A' + 'a') : kPieceLetters[index];
+        ++count;
+    }
+    result.whiteToMove = !(in[24] & 1);
+    result.castling = (in[24] >> 1) & 15;
+    result.enPassantFile = static_cast<int>(in[25]) - 1;
+    if (result.enPassantFile > 7) return false;
+    result.halfmoveClock = in[26];
+    result.fullmoveNumber = static_cast<int>(get16(in + 28));
+    setup = result;
+    return true;
+}
+
+std::vector<uint8_t> encodeBinarySave(const Game& game) {
+    PositionSetup start;
+    if (!Game::parseFen(game.getStartFen(), start)) return {};
+    std::vector<MoveCoords> moves = game.getMoveHistory();
+
+    std::vector<uint8_t> out(kHeaderSize + 2 * kPackedPositionSize);
+    if (!packPosition(start, out.data() + kHeaderSize) ||
+        !packPosition(game.getPosition(), out.data() + kHeaderSize + kPackedPositionSize)) {
+        return {};
+    }
+    putName(out, game.getPlayerName(Color::White));
+    putName(out, game.getPlayerName(Color::Black));
+    put32(out, static_cast<uint32_t>(moves.size()));
+    for (const auto& move : moves) put16(out, packMove(move));
+
+    size_t payloadSize = out.size() - kHeaderSize;
+    std::vector<uint8_t> header;
+    header.insert(header.end(), kMagic, kMagic + 4);
+    put16(header, kBinarySaveVersion);
+    put16(header, kHeaderSize);
+    put32(header, static_cast<uint32_t>(payloadSize));
+    put32(header, crc32(out.data() + kHeaderSize, payloadSize));
+    std::memcpy(out.data(), header.data(), kHeaderSize);
+    return out;
+}
+
+bool decodeBinarySave(Game& game, const uint8_t* data, size_t size) {
+    if (size < kHeaderSize || std::memcmp(data, kMagic, 4) != 0) return false;
+    if (get16(data + 4) != kBinarySaveVersion) return false;
+    size_t headerSize = get16(data + 6);
+    size_t payloadSize = get32(data + 8);
+    if (headerSize < kHeaderSize || headerSize > size || payloadSize > size - headerSize) return false;
+    const uint8_t* payload = data + headerSize;
+    if (crc32(payload, payloadSize) != get32(data + 12)) return false;
+
+    const uint8_t* p = payload;
+    const uint8_t* end = payload + payloadSize;
+    PositionSetup current;
+    if (payloadSize < 2 * kPackedPositionSize || !unpackPosition(p + kPackedPositionSize, current)) return false;
+    p += 2 * kPackedPositionSize;
+
+    std::string names[2];
+    for (auto& name : names) {
+        if (p >= end || static_cast<size_t>(end - p) < 1u + *p) return false;
+        name.assign(reinterpret_cast<const char*>(p + 1), *p);
+        p += 1 + *p;
+    }
+    if (end - p < 4 || static_cast<size_t>(end - p - 4) / 2 < get32(p)) return false;
+    size_t moveCount = get32(p);
+    p += 4;
+
+    PositionSetup start;
+    bool replayable = unpackPosition(payload, start);
+    std::vector<MoveCoords> moves;
+    if (replayable) {
+        moves.reserve(moveCount);
+        for (size_t i = 0; i < moveCount; ++i) moves.push_back(unpackMove(static_cast<uint16_t>(get16(p + 2 * i))));
+    }
+
+    // Replay the record to restore undo history; if it does not reproduce the saved position,
+    // keep just the position.
+    uint8_t replayed[kPackedPositionSize];
+    if (!replayable || !game.replayFrom(start, moves) || !packPosition(game.getPosition(), replayed) ||
+        std::memcmp(replayed, payload + kPackedPositionSize, kPackedPositionSize) != 0) {
+        game.setPosition(current);
+    }
+    game.setPlayerName(Color::White, names[0]);
+    game.setPlayerName(Color::Black, names[1]);
+    return true;
+}
+
+bool writeBinarySave(const Game& game, const std::string& path) {
+    std::vector<uint8_t> bytes = encodeBinarySave(game);
+    if (bytes.empty()) return false;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+bool readBinarySave(Game& game, const std::string& path) {
+    MappedFile file;
+    if (!file.open(path, MappedFile::Mode::ReadOnly)) return false;
+    return decodeBinarySave(game, file.data(), file.size());
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Game.h"
+
+// Compact binary save format. All integers are little endian.
+//
+//   header   magic "2QKB", u16 version, u16 header size, u32 payload size, u32 CRC-32 of the payload
+//   payload  start position (32 bytes), current position (32 bytes),
+//            white name, black name (u8 length + bytes each), u32 move count, u16 packed moves
+//
+// A packed position is an occupancy bitboard (a1 = bit 0), one nibble per occupied square in
+// square order (1-6 = PNBRQK, +8 for black), then side/castling, en passant file, halfmove clock
+// and fullmove number. Positions with more than 32 pieces cannot be packed.
+constexpr size_t kPackedPositionSize = 32;
+constexpr uint16_t kBinarySaveVersion = 1;
+
+bool packPosition(const PositionSetup& setup, uint8_t* out);
+bool unpackPosition(const uint8_t* in, PositionSetup& setup);
+uint32_t crc32(const void* data, size_t size);
+
+// In-memory encoding; empty on failure.
+std::vector<uint8_t> encodeBinarySave(const Game& game);
+// Decodes straight from `data` (e.g. a mapped file). Leaves the game untouched on failure.
+bool decodeBinarySave(Game& game, const uint8_t* data, size_t size);
+
+bool writeBinarySave(const Game& game, const std::string& path);
+// Maps the file read-only and decodes it in place.
+bool readBinarySave(Game& game, const std::string& path);
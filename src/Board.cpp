@@ -38,14 +38,9 @@ void Board::initialize() {
     }
 }
 
-std::shared_ptr<Piece> Board::getPieceAt(int x, int y) const {
-    if (!isInsideBoard(x, y)) return nullptr;
-    return board[y][x];
-}
-
 void Board::setPieceAt(int x, int y, std::shared_ptr<Piece> piece) {
     if (!isInsideBoard(x, y)) return;
-    board[y][x] = piece;
+    board[y][x] = std::move(piece);
 }
 
 void Board::movePiece(int fromX, int fromY, int toX, int toY) {
@@ -71,3 +66,15 @@ bool Board::isValidMove(std::shared_ptr<Piece> piece, int toX, int toY) const {
 bool Board::isInsideBoard(int x, int y) const {
     return x >= 0 && x < 8 && y >= 0 && y < 8;
 }
+
+bool Board::hasInsufficientMaterial() const {
+    int minors = 0;
+    for (const auto& row : board) {
+        for (const auto& piece : row) {
+            if (!piece || piece->getType() == PieceType::King) continue;
+            if (piece->getType() != PieceType::Bishop && piece->getType() != PieceType::Knight) return false;
+            ++minors;
+        }
+    }
+    return minors <= 1;
+}
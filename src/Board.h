@@ -9,10 +9,17 @@ public:
 
     void initialize();
 
-    std::shared_ptr<Piece> getPieceAt(int x, int y) const;
+    // Inline and by reference so that board scans do not pay for calls or reference counting.
+    const std::shared_ptr<Piece>& getPieceAt(int x, int y) const {
+        static const std::shared_ptr<Piece> none;
+        if (x < 0 || x >= 8 || y < 0 || y >= 8) return none;
+        return board[y][x];
+    }
     void setPieceAt(int x, int y, std::shared_ptr<Piece> piece);
     void movePiece(int fromX, int fromY, int toX, int toY);
     bool isValidMove(std::shared_ptr<Piece> piece, int toX, int toY) const;
+    // Only kings and at most one minor piece left, so neither side can mate.
+    bool hasInsufficientMaterial() const;
 
 private:
     std::vector<std::vector<std::shared_ptr<Piece>>> board;
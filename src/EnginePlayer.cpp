@@ -0,0 +1,80 @@
+#include "EnginePlayer.h"
+#include <cstdlib>
+
+std::optional<EngineSpec> EngineSpec::parse(std::string_view text) {
+    EngineSpec spec;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == ',')) ++pos;
+        size_t end = pos;
+        while (end < text.size() && text[end] != ' ' && text[end] != ',') ++end;
+        std::string_view item = text.substr(pos, end - pos);
+        pos = end;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        if (eq == std::string_view::npos) return std::nullopt;
+        std::string key(item.substr(0, eq));
+        std::string value(item.substr(eq + 1));
+        try {
+            if (key == "name") spec.name = value;
+            else if (key == "cmd") spec.command = value;
+            else if (key == "skill") spec.skill = std::stoi(value);
+            else if (key == "depth") spec.limits.depth = std::stoi(value);
+            else if (key == "nodes") spec.limits.nodes = std::stoll(value);
+            else if (key == "movetime") spec.limits.movetimeMs = std::stoi(value);
+            else return std::nullopt;
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+    if (spec.limits.depth == 0 && spec.limits.nodes == 0 && spec.limits.movetimeMs == 0) {
+        if (spec.isNative()) {
+            spec.limits.depth = 2;
+        } else {
+            spec.limits.movetimeMs = 100;
+        }
+    }
+    if (spec.name.empty()) spec.name = spec.isNative() ? "native" : spec.command;
+    return spec;
+}
+
+EnginePlayer::EnginePlayer(EngineSpec spec) : engineSpec(std::move(spec)) {}
+
+bool EnginePlayer::start() {
+    if (engineSpec.isNative()) return true;
+    engine = std::make_unique<UciEngine>();
+    return engine->start(engineSpec.command, engineSpec.skill);
+}
+
+void EnginePlayer::newGame() {
+    if (engine && engine->isRunning()) {
+        engine->send("ucinewgame\n");
+    }
+}
+
+AnalysisResult EnginePlayer::think(Game& game, const std::string& startFen, const std::vector<std::string>& uciMoves) {
+    if (engine) {
+        return engine->analyse(startFen, uciMoves, engineSpec.limits);
+    }
+
+    AnalysisResult result;
+    SearchResult found = searcher.search(game, engineSpec.limits);
+    result.nodes = found.nodes;
+    if (!found.best) return result;
+
+    result.bestMove = toUci(*found.best);
+    PvLine line;
+    line.depth = found.depth;
+    line.nodes = found.nodes;
+    line.pv.push_back(result.bestMove);
+    if (std::abs(found.score) >= Searcher::kMateScore - 1000) {
+        int plies = Searcher::kMateScore - std::abs(found.score);
+        line.mate = true;
+        line.score = (found.score > 0 ? 1 : -1) * (plies + 1) / 2;
+    } else {
+        line.score = found.score;
+    }
+    result.lines.push_back(std::move(line));
+    return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Game.h"
+#include "Search.h"
+#include "UciEngine.h"
+
+// How to produce moves: the built-in Searcher ("native") or a UCI engine executable.
+struct EngineSpec {
+    std::string name;
+    std::string command = "native";
+    int skill = 20;
+    SearchLimits limits;
+
+    bool isNative() const { return command == "native"; }
+    // Parses "key=value" pairs separated by spaces or commas, e.g.
+    // "name=sf5 cmd=/usr/games/stockfish skill=5 movetime=100" or "cmd=native depth=3".
+    static std::optional<EngineSpec> parse(std::string_view text);
+};
+
+// One player seat backed by an EngineSpec; not thread-safe, use one per worker thread.
+class EnginePlayer {
+public:
+    explicit EnginePlayer(EngineSpec spec);
+
+    bool start();
+    void newGame();
+    // `game` holds the current position, reached from `startFen` (empty for the start position)
+    // by `uciMoves`. The native searcher uses `game` directly and leaves it unchanged.
+    AnalysisResult think(Game& game, const std::string& startFen, const std::vector<std::string>& uciMoves);
+
+    const EngineSpec& spec() const { return engineSpec; }
+
+private:
+    EngineSpec engineSpec;
+    std::unique_ptr<UciEngine> engine;
+    Searcher searcher;
+};
@@ -0,0 +1,74 @@
+#include "EnginePool.h"
+#include <algorithm>
+
+EnginePool::EnginePool(const std::string& enginePath, int size, const Options& options, int skillLevel)
+    : enginePath(enginePath), engineOptions(options), skillLevel(skillLevel),
+      jobs(static_cast<size_t>(size > 0 ? size : 1) * 2) {
+    for (int i = 0; i < size; ++i) {
+        auto engine = std::make_unique<UciEngine>();
+        if (!startEngine(*engine)) continue;
+        engines.push_back(std::move(engine));
+    }
+    for (auto& engine : engines) {
+        workers.emplace_back([this, raw = engine.get()] { workerLoop(*raw); });
+    }
+}
+
+EnginePool::~EnginePool() {
+    shutdown();
+}
+
+void EnginePool::setCache(EvalCache* evalCache, int minDepth) {
+    cache = evalCache;
+    cacheMinDepth = minDepth;
+    for (auto& engine : engines) engine->setCache(evalCache, minDepth);
+}
+
+std::future<AnalysisResult> EnginePool::submit(AnalysisRequest request) {
+    // Hits are answered here without queueing; the engines write finished searches back.
+    if (cache && cache->isOpen() && request.limits.multiPv <= 1) {
+        if (auto key = analysisKey(request.fen, request.moves)) {
+            if (auto hit = cachedAnalysis(*cache, *key, std::max(cacheMinDepth, request.limits.depth))) {
+                std::promise<AnalysisResult> ready;
+                ready.set_value(std::move(*hit));
+                return ready.get_future();
+            }
+        }
+    }
+
+    Job job{std::move(request), std::promise<AnalysisResult>()};
+    auto future = job.promise.get_future();
+    if (engines.empty() || !jobs.push(std::move(job))) {
+        std::promise<AnalysisResult> failed;
+        failed.set_value(AnalysisResult{});
+        return failed.get_future();
+    }
+    return future;
+}
+
+void EnginePool::shutdown() {
+    jobs.close();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    workers.clear();
+    for (auto& engine : engines) {
+        engine->stop();
+    }
+}
+
+bool EnginePool::startEngine(UciEngine& engine) const {
+    if (!engine.start(enginePath, skillLevel)) return false;
+    for (const auto& option : engineOptions) {
+        engine.setOption(option.first, option.second);
+    }
+    return engine.isReady();
+}
+
+void EnginePool::workerLoop(UciEngine& engine) {
+    while (auto job = jobs.pop()) {
+        // If the restart fails too, the request gets an empty result and the next one tries again.
+        if (!engine.isRunning()) startEngine(engine);
+        job->promise.set_value(engine.analyse(job->request.fen, job->request.moves, job->request.limits));
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "BoundedQueue.h"
+#include "EvalCache.h"
+#include "UciEngine.h"
+
+struct AnalysisRequest {
+    std::string fen; // empty for the standard start position
+    std::vector<std::string> moves;
+    SearchLimits limits;
+};
+
+// A fixed set of UCI engine processes, each served by its own worker thread.
+// Requests are queued (bounded, so submit() applies back-pressure) and answered through futures.
+// An engine that crashed or was killed for overrunning a search deadline (SearchLimits::timeoutMs)
+// is restarted with the same options before its worker takes the next request.
+class EnginePool {
+public:
+    using Options = std::vector<std::pair<std::string, std::string>>;
+
+    EnginePool(const std::string& enginePath, int size, const Options& options = {}, int skillLevel = 20);
+    ~EnginePool();
+    EnginePool(const EnginePool&) = delete;
+    EnginePool& operator=(const EnginePool&) = delete;
+
+    // Number of engines that actually started.
+    int size() const { return static_cast<int>(engines.size()); }
+
+    // Single-PV requests are answered from `cache` when it holds a search at least `minDepth`
+    // (and at least the requested depth) deep, before they are queued; every engine of the pool
+    // uses the cache too (UciEngine::setCache). The cache must outlive the pool.
+    void setCache(EvalCache* cache, int minDepth = 1);
+
+    std::future<AnalysisResult> submit(AnalysisRequest request);
+    // Finishes queued requests, then stops the engines.
+    void shutdown();
+
+private:
+    struct Job {
+        AnalysisRequest request;
+        std::promise<AnalysisResult> promise;
+    };
+
+    bool startEngine(UciEngine& engine) const;
+    void workerLoop(UciEngine& engine);
+
+    std::string enginePath;
+    Options engineOptions;
+    int skillLevel;
+    BoundedQueue<Job> jobs;
+    std::vector<std::unique_ptr<UciEngine>> engines;
+    std::vector<std::thread> workers;
+    EvalCache* cache = nullptr;
+    int cacheMinDepth = 1;
+};
@@ -0,0 +1,112 @@
+#include "Epd.h"
+#include <cctype>
+
+namespace {
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+std::string_view nextField(std::string_view& rest) {
+    rest = trim(rest);
+    size_t end = 0;
+    while (end < rest.size() && !std::isspace(static_cast<unsigned char>(rest[end]))) ++end;
+    std::string_view field = rest.substr(0, end);
+    rest.remove_prefix(end);
+    return field;
+}
+
+bool isNumber(std::string_view text) {
+    if (text.empty()) return false;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+    }
+    return true;
+}
+} // namespace
+
+std::string EpdRecord::id() const {
+    auto it = operations.find("id");
+    return it == operations.end() ? std::string() : it->second;
+}
+
+std::vector<std::string> EpdRecord::operandList(const std::string& opcode) const {
+    std::vector<std::string> items;
+    auto it = operations.find(opcode);
+    if (it == operations.end()) return items;
+    std::string_view rest(it->second);
+    while (true) {
+        std::string_view field = nextField(rest);
+        if (field.empty()) break;
+        items.emplace_back(field);
+    }
+    return items;
+}
+
+std::optional<EpdRecord> parseEpd(std::string_view line) {
+    line = trim(line);
+    if (line.empty() || line.front() == '#') return std::nullopt;
+
+    std::string_view rest = line;
+    std::string_view fields[4];
+    for (auto& field : fields) {
+        field = nextField(rest);
+        if (field.empty()) return std::nullopt;
+    }
+
+    EpdRecord record;
+    std::string halfmove = "0";
+    std::string fullmove = "1";
+
+    // Plain FEN: the two move counters follow directly.
+    std::string_view probe = rest;
+    std::string_view first = nextField(probe);
+    std::string_view second = nextField(probe);
+    if (isNumber(first) && isNumber(second)) {
+        halfmove = std::string(first);
+        fullmove = std::string(second);
+        rest = probe;
+    }
+
+    // Operations: "opcode operand...;" with optional double-quoted operands.
+    rest = trim(rest);
+    while (!rest.empty()) {
+        std::string_view opcode = nextField(rest);
+        if (opcode.empty()) break;
+        if (opcode.back() == ';') {
+            opcode.remove_suffix(1);
+            record.operations[std::string(opcode)] = std::string();
+            continue;
+        }
+        std::string operand;
+        rest = trim(rest);
+        bool inQuotes = false;
+        size_t i = 0;
+        for (; i < rest.size(); ++i) {
+            char c = rest[i];
+            if (c == '"') {
+                inQuotes = !inQuotes;
+                continue;
+            }
+            if (c == ';' && !inQuotes) break;
+            operand.push_back(c);
+        }
+        rest.remove_prefix(i < rest.size() ? i + 1 : i);
+        record.operations[std::string(opcode)] = std::string(trim(operand));
+        rest = trim(rest);
+    }
+
+    auto hmvc = record.operations.find("hmvc");
+    if (hmvc != record.operations.end() && isNumber(hmvc->second)) halfmove = hmvc->second;
+    auto fmvn = record.operations.find("fmvn");
+    if (fmvn != record.operations.end() && isNumber(fmvn->second)) fullmove = fmvn->second;
+
+    record.fen.reserve(line.size());
+    for (const auto& field : fields) {
+        record.fen.append(field);
+        record.fen.push_back(' ');
+    }
+    record.fen += halfmove + " " + fullmove;
+    return record;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One line of an EPD file. Plain FEN lines are accepted too.
+struct EpdRecord {
+    std::string fen;                              // full six-field FEN (hmvc/fmvn taken from the line or opcodes)
+    std::map<std::string, std::string> operations; // opcode -> operand text, quotes removed
+
+    std::string id() const;
+    // Space separated operand of `opcode` split into tokens, e.g. the SAN moves of "bm".
+    std::vector<std::string> operandList(const std::string& opcode) const;
+};
+
+// Returns nullopt for blank lines, comments ('#') and lines with fewer than four FEN fields.
+std::optional<EpdRecord> parseEpd(std::string_view line);
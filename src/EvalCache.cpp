@@ -0,0 +1,247 @@
+#include "EvalCache.h"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <random>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr char kMagic[8] = {'2', 'Q', '1', 'K', 'E', 'V', 'C', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t bucketCount;
+    std::atomic<uint32_t> generation;
+    unsigned char reserved[36];
+};
+static_assert(sizeof(Header) == 64, "cache header must stay 64 bytes");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared-memory counters must be lock free");
+
+constexpr uint8_t kUsed = 1;
+constexpr uint8_t kMate = 2;
+} // namespace
+
+struct EvalCache::Entry {
+    std::atomic<uint32_t> sequence; // odd while a writer owns the entry
+    uint16_t generation;
+    int16_t depth;
+    uint64_t key;
+    int32_t score;
+    uint8_t flags;
+    uint8_t pvLength;
+    uint16_t reserved;
+    uint16_t pv[kMaxPvLength];
+};
+
+namespace {
+// Exclusive advisory lock on the cache file, held while a process sizes or initializes it. The
+// file is created (empty) if missing but never truncated or removed here.
+class InitLock {
+public:
+    explicit InitLock(const std::string& path) {
+#ifdef _WIN32
+        handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        OVERLAPPED whole{};
+        locked = handle != INVALID_HANDLE_VALUE && LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &whole);
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        locked = fd >= 0 && flock(fd, LOCK_EX) == 0;
+#endif
+    }
+    ~InitLock() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle); // also drops the lock
+#else
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+    InitLock(const InitLock&) = delete;
+    InitLock& operator=(const InitLock&) = delete;
+
+    bool held() const { return locked; }
+    // False if `path` was replaced by another file while we waited for the lock.
+    bool stillAt(const std::string& path) const {
+#ifdef _WIN32
+        (void)path;
+        return true;
+#else
+        struct stat ours{}, named{};
+        return fstat(fd, &ours) == 0 && stat(path.c_str(), &named) == 0 && ours.st_dev == named.st_dev &&
+               ours.st_ino == named.st_ino;
+#endif
+    }
+
+private:
+    bool locked = false;
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+// Bucket count of a usable cache file of `size` bytes, or 0.
+uint64_t validBuckets(const std::string& path, uintmax_t size, size_t entrySize, size_t bucketSize) {
+    if (size < sizeof(Header)) return 0;
+    Header header;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(Header))) return 0;
+    uint64_t buckets = header.bucketCount;
+    bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+                 header.entrySize == entrySize && buckets != 0 && (buckets & (buckets - 1)) == 0 &&
+                 size == sizeof(Header) + buckets * bucketSize * entrySize;
+    return valid ? buckets : 0;
+}
+} // namespace
+
+bool EvalCache::open(const std::string& path, size_t maxBytes) {
+    static_assert(sizeof(Entry) == 64, "cache entries must stay 64 bytes");
+    close();
+    size_t buckets = 1;
+    while (sizeof(Header) + buckets * 2 * kBucketSize * sizeof(Entry) <= maxBytes) buckets *= 2;
+
+    // Other processes may have the file mapped, so it is never truncated or unlinked while in use:
+    // a valid file is adopted as it is, and a foreign one is replaced by renaming a fresh file over it.
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        InitLock lock(path);
+        if (!lock.held()) return false;
+        if (!lock.stillAt(path)) continue;
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(path, ec);
+        if (ec) return false;
+
+        uint64_t existing = validBuckets(path, size, sizeof(Entry), kBucketSize);
+        if (existing == 0 && size != 0) {
+            std::string temp = path + ".init" + std::to_string(std::random_device{}());
+            EvalCache fresh;
+            bool created = fresh.create(temp, buckets);
+            fresh.close();
+            if (created) std::filesystem::rename(temp, path, ec);
+            if (!created || ec) {
+                std::filesystem::remove(temp, ec);
+                return false;
+            }
+            continue; // lock and adopt the new file
+        }
+        if (existing != 0) {
+            if (!file.open(path, MappedFile::Mode::ReadWrite)) return false;
+            bucketCount = static_cast<size_t>(existing);
+        } else if (!create(path, buckets)) {
+            return false;
+        }
+        auto* header = reinterpret_cast<Header*>(file.data());
+        generation = static_cast<uint16_t>(header->generation.fetch_add(1) + 1);
+        return true;
+    }
+    return false;
+}
+
+// Maps `path` (empty or missing) at full size and writes the header.
+bool EvalCache::create(const std::string& path, size_t buckets) {
+    if (!file.open(path, MappedFile::Mode::ReadWrite, sizeof(Header) + buckets * kBucketSize * sizeof(Entry))) {
+        return false;
+    }
+    // A freshly extended file reads as zeros: every entry is empty with an even sequence.
+    auto* header = reinterpret_cast<Header*>(file.data());
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->version = kVersion;
+    header->entrySize = sizeof(Entry);
+    header->bucketCount = buckets;
+    new (&header->generation) std::atomic<uint32_t>(0);
+    bucketCount = buckets;
+    return true;
+}
+
+void EvalCache::close() {
+    file.close();
+    bucketCount = 0;
+}
+
+EvalCache::Entry* EvalCache::entryAt(size_t index) const {
+    auto* base = const_cast<unsigned char*>(file.data()) + sizeof(Header);
+    return reinterpret_cast<Entry*>(base) + index;
+}
+
+std::optional<CachedEval> EvalCache::probe(uint64_t key) const {
+    if (!isOpen()) return std::nullopt;
+    size_t first = static_cast<size_t>(key & (bucketCount - 1)) * kBucketSize;
+    for (size_t i = 0; i < kBucketSize; ++i) {
+        Entry* entry = entryAt(first + i);
+        uint32_t before = entry->sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+
+        Entry copy;
+        std::memcpy(static_cast<void*>(&copy), entry, sizeof(Entry));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry->sequence.load(std::memory_order_relaxed) != before) continue;
+        if (!(copy.flags & kUsed) || copy.key != key) continue;
+
+        CachedEval eval;
+        eval.depth = copy.depth;
+        eval.mate = (copy.flags & kMate) != 0;
+        eval.score = copy.score;
+        for (int m = 0; m < copy.pvLength && m < kMaxPvLength; ++m) {
+            eval.pv.push_back(unpackMove(copy.pv[m]));
+        }
+        return eval;
+    }
+    return std::nullopt;
+}
+
+void EvalCache::store(uint64_t key, const CachedEval& eval) {
+    if (!isOpen()) return;
+    size_t first = static_cast<size_t>(key & (bucketCount - 1)) * kBucketSize;
+
+    // Same key, else an empty slot, else the entry with the lowest depth after aging.
+    Entry* victim = nullptr;
+    int victimWorth = 0;
+    for (size_t i = 0; i < kBucketSize; ++i) {
+        Entry* entry = entryAt(first + i);
+        if ((entry->flags & kUsed) && entry->key == key) {
+            if (entry->generation == generation && entry->depth > eval.depth) return;
+            victim = entry;
+            break;
+        }
+        int age = static_cast<uint16_t>(generation - entry->generation);
+        int worth = (entry->flags & kUsed) ? entry->depth - 4 * age : -1000000;
+        if (!victim || worth < victimWorth) {
+            victim = entry;
+            victimWorth = worth;
+        }
+    }
+
+    uint32_t sequence = victim->sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) ||
+        !victim->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire)) {
+        return; // another writer owns this entry; dropping a cache write is harmless
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    victim->generation = generation;
+    victim->depth = static_cast<int16_t>(eval.depth);
+    victim->key = key;
+    victim->score = eval.score;
+    victim->flags = static_cast<uint8_t>(kUsed | (eval.mate ? kMate : 0));
+    size_t length = eval.pv.size() < static_cast<size_t>(kMaxPvLength) ? eval.pv.size() : kMaxPvLength;
+    victim->pvLength = static_cast<uint8_t>(length);
+    for (size_t m = 0; m < length; ++m) {
+        victim->pv[m] = packMove(eval.pv[m]);
+    }
+
+    victim->sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Move.h"
+
+struct CachedEval {
+    int depth = 0;
+    bool mate = false;
+    int score = 0; // same convention as PvLine::score
+    std::vector<MoveCoords> pv; // pv.front() is the best move
+};
+
+// Persistent evaluation cache: a memory-mapped, set-associative table keyed by position hash.
+// Each bucket holds four 64-byte entries; a full bucket replaces its shallowest / oldest entry.
+// Entries are guarded by per-entry sequence counters, so any number of threads or processes can
+// probe and store concurrently; a reader never sees a half-written entry.
+class EvalCache {
+public:
+    static constexpr int kMaxPvLength = 20;
+
+    // Opens the cache file, creating it sized to at most `maxBytes` if it is missing. An existing
+    // cache keeps its size (whatever `maxBytes` says) so that every process sharing it agrees;
+    // a file that is not a cache of this version is replaced.
+    bool open(const std::string& path, size_t maxBytes);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    std::optional<CachedEval> probe(uint64_t key) const;
+    void store(uint64_t key, const CachedEval& eval);
+
+    size_t capacity() const { return bucketCount * kBucketSize; }
+
+private:
+    static constexpr size_t kBucketSize = 4;
+
+    struct Entry;
+    Entry* entryAt(size_t index) const;
+    bool create(const std::string& path, size_t buckets);
+
+    MappedFile file;
+    size_t bucketCount = 0;
+    uint16_t generation = 0;
+};
@@ -1,9 +1,16 @@
 #include "Game.h"
+#include "BinarySave.h"
+#include "JsonSave.h"
+#include "Metrics.h"
+#include "UciEngine.h"
+#include "Zobrist.h"
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <iomanip>
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 
 using json = nlohmann::json;
 
@@ -20,161 +27,230 @@ void Game::start() {
     currentPlayer = Color::White;
     moveHistory.clear();
     moveCount = 0;
+    halfmoveClock = 0;
     enPassantTarget.reset();
+    startFen = fen();
+    positionHashes.assign(1, getPositionHash());
+    resetStatus();
+    publish();
 }
 
-void Game::makeMove(int fromX, int fromY, int toX, int toY, PieceType promotionChoice) {
-    auto piece = board.getPieceAt(fromX, fromY);
-    if (!piece) return;
+const char* moveStatusMessage(MoveStatus status) {
+    switch (status) {
+    case MoveStatus::Ok: return "ok";
+    case MoveStatus::OffBoard: return "square off the board";
+    case MoveStatus::NoPiece: return "no piece on the source square";
+    case MoveStatus::NotYourTurn: return "not your turn";
+    case MoveStatus::IllegalMove: return "illegal move";
+    case MoveStatus::LeavesKingInCheck: return "king would be in check";
+    }
+    return "unknown";
+}
 
-    if (piece->getColor() != (whiteTurn ? Color::White : Color::Black))
-        return;
+MoveStatus Game::makeMove(int fromX, int fromY, int toX, int toY, PieceType promotionChoice) {
+    CHESS_METRIC_SCOPE(MetricOp::MakeMove);
+    return playMove(fromX, fromY, toX, toY, promotionChoice);
+}
+
+MoveStatus Game::playMove(int fromX, int fromY, int toX, int toY, PieceType promotionChoice) {
+    auto inside = [](int v) { return v >= 0 && v < 8; };
+    if (!inside(fromX) || !inside(fromY) || !inside(toX) || !inside(toY)) return MoveStatus::OffBoard;
+    const auto& piece = board.getPieceAt(fromX, fromY);
+    if (!piece) return MoveStatus::NoPiece;
+    if (piece->getColor() != currentPlayer) return MoveStatus::NotYourTurn;
+
+    if (const LegalMoveCache* known = knownMoves()) {
+        if (!((known->targets[fromY * 8 + fromX] >> (toY * 8 + toX)) & 1)) {
+            return board.isValidMove(piece, toX, toY) ? MoveStatus::LeavesKingInCheck : MoveStatus::IllegalMove;
+        }
+        applyMove(MoveCoords{fromX, fromY, toX, toY, promotionChoice});
+        publish();
+        return MoveStatus::Ok;
+    }
 
     Color moverColor = piece->getColor();
     int dx = toX - fromX;
     int dy = toY - fromY;
 
-    // Castling handling.
     if (piece->getType() == PieceType::King && std::abs(dx) == 2 && dy == 0) {
-        bool kingSide = dx > 0;
-        if (!canCastle(moverColor, kingSide)) return;
-
-        Move mv(piece.get(), fromX, fromY, toX, toY, nullptr);
-        mv.castling = true;
-        mv.hadEnPassantTargetBefore = enPassantTarget.has_value();
-        if (enPassantTarget) {
-            mv.prevEnPassantX = enPassantTarget->first;
-            mv.prevEnPassantY = enPassantTarget->second;
-        }
-        mv.pieceMovedBefore = piece->hasMoved();
-
-        int rookFromX = kingSide ? 7 : 0;
-        int rookFromY = (moverColor == Color::White) ? 0 : 7;
-        int rookToX = kingSide ? 5 : 3;
-        int rookToY = rookFromY;
-
-        auto rook = board.getPieceAt(rookFromX, rookFromY);
-
-        board.movePiece(fromX, fromY, toX, toY);
-        board.movePiece(rookFromX, rookFromY, rookToX, rookToY);
-
-        bool leavesInCheck = isInCheck(moverColor);
-        if (leavesInCheck) {
-            board.movePiece(toX, toY, fromX, fromY);
-            board.movePiece(rookToX, rookToY, rookFromX, rookFromY);
-            return;
+        if (fromX != 4 || !canCastle(moverColor, dx > 0)) return MoveStatus::IllegalMove;
+    } else {
+        bool isEnPassantCapture = false;
+        if (piece->getType() == PieceType::Pawn &&
+            std::abs(dx) == 1 &&
+            dy == ((moverColor == Color::White) ? 1 : -1) &&
+            !board.getPieceAt(toX, toY) && enPassantTarget &&
+            enPassantTarget->first == toX && enPassantTarget->second == toY) {
+            const auto& captured = board.getPieceAt(toX, fromY);
+            if (!captured || captured->getType() != PieceType::Pawn || captured->getColor() == moverColor) {
+                return MoveStatus::IllegalMove;
+            }
+            isEnPassantCapture = true;
         }
-
-        mv.rookFromX = rookFromX;
-        mv.rookFromY = rookFromY;
-        mv.rookToX = rookToX;
-        mv.rookToY = rookToY;
-
-        piece->markMoved();
-        if (rook) rook->markMoved();
-        enPassantTarget.reset();
-
-        moveHistory.push_back(mv);
-        whiteTurn = !whiteTurn;
-        currentPlayer = whiteTurn ? Color::White : Color::Black;
-        moveCount++;
-        return;
+        if (!isEnPassantCapture && !board.isValidMove(piece, toX, toY))
+            return MoveStatus::IllegalMove;
     }
 
-    // En passant handling.
-    bool isEnPassantCapture = false;
-    std::shared_ptr<Piece> capturedPiece = board.getPieceAt(toX, toY);
-    int captureX = toX, captureY = toY;
-
-    if (piece->getType() == PieceType::Pawn &&
-        std::abs(dx) == 1 &&
-        dy == ((moverColor == Color::White) ? 1 : -1) &&
-        !capturedPiece && enPassantTarget &&
-        enPassantTarget->first == toX && enPassantTarget->second == toY) {
-        isEnPassantCapture = true;
-        captureX = toX;
-        captureY = fromY;
-        capturedPiece = board.getPieceAt(captureX, captureY);
-        if (!capturedPiece || capturedPiece->getType() != PieceType::Pawn || capturedPiece->getColor() == moverColor) {
-            return;
-        }
+    applyMove(MoveCoords{fromX, fromY, toX, toY, promotionChoice});
+    if (isInCheck(moverColor)) {
+        retractMove();
+        return MoveStatus::LeavesKingInCheck;
     }
+    publish();
+    return MoveStatus::Ok;
+}
 
-    if (!isEnPassantCapture && !board.isValidMove(piece, toX, toY))
-        return;
+// Plays a move without any legality checks; the caller guarantees it is at least pseudo-legal.
+void Game::applyMove(const MoveCoords& move) {
+    int fromX = move.fromX, fromY = move.fromY, toX = move.toX, toY = move.toY;
+    auto piece = board.getPieceAt(fromX, fromY);
+    Color moverColor = piece->getColor();
+    int dx = toX - fromX;
+    int dy = toY - fromY;
+
+    // A diagonal pawn move onto an empty square is en passant; the captured pawn stands beside it.
+    int captureY = toY;
+    if (piece->getType() == PieceType::Pawn && dx != 0 && !board.getPieceAt(toX, toY)) captureY = fromY;
 
-    Move mv(piece.get(), fromX, fromY, toX, toY, capturedPiece);
+    Move mv(piece.get(), fromX, fromY, toX, toY, board.getPieceAt(toX, captureY));
     mv.hadEnPassantTargetBefore = enPassantTarget.has_value();
     if (enPassantTarget) {
         mv.prevEnPassantX = enPassantTarget->first;
         mv.prevEnPassantY = enPassantTarget->second;
     }
     mv.pieceMovedBefore = piece->hasMoved();
+    mv.prevHalfmoveClock = halfmoveClock;
+    bool resetsClock = piece->getType() == PieceType::Pawn || mv.getCapturedPiece();
 
-    if (isEnPassantCapture) {
-        board.setPieceAt(captureX, captureY, nullptr);
-        mv.enPassant = true;
-        mv.enPassantCapturedX = captureX;
-        mv.enPassantCapturedY = captureY;
-    }
-
-    board.movePiece(fromX, fromY, toX, toY);
-
-    bool promoted = false;
-    if (piece->getType() == PieceType::Pawn &&
-        ((moverColor == Color::White && toY == 7) || (moverColor == Color::Black && toY == 0))) {
-        PieceType chosen = promotionChoice;
-        switch (chosen) {
-            case PieceType::Queen:
-            case PieceType::Rook:
-            case PieceType::Bishop:
-            case PieceType::Knight:
-                break;
-            default:
-                chosen = PieceType::Queen;
-                break;
+    if (piece->getType() == PieceType::King && std::abs(dx) == 2 && dy == 0) {
+        mv.castling = true;
+        mv.rookFromX = dx > 0 ? 7 : 0;
+        mv.rookFromY = fromY;
+        mv.rookToX = dx > 0 ? 5 : 3;
+        mv.rookToY = fromY;
+        board.movePiece(fromX, fromY, toX, toY);
+        board.movePiece(mv.rookFromX, mv.rookFromY, mv.rookToX, mv.rookToY);
+        if (const auto& rook = board.getPieceAt(mv.rookToX, mv.rookToY)) rook->markMoved();
+    } else {
+        if (captureY != toY) {
+            mv.enPassant = true;
+            mv.enPassantCapturedX = toX;
+            mv.enPassantCapturedY = captureY;
+            board.setPieceAt(toX, captureY, nullptr);
         }
-        auto promotedPiece = Piece::create(chosen, moverColor, toX, toY);
-        promotedPiece->markMoved();
-        mv.promotion = true;
-        mv.promotedFrom = board.getPieceAt(toX, toY);
-        board.setPieceAt(toX, toY, promotedPiece);
-        promoted = true;
-    }
 
-    if (isInCheck(moverColor)) {
-        if (promoted) {
-            board.setPieceAt(toX, toY, mv.promotedFrom);
-        }
-        board.movePiece(toX, toY, fromX, fromY);
-        if (capturedPiece) {
-            board.setPieceAt(captureX, captureY, capturedPiece);
-            capturedPiece->setPosition(captureX, captureY);
-        }
-        if (mv.hadEnPassantTargetBefore) {
-            enPassantTarget = std::make_optional(std::make_pair(mv.prevEnPassantX, mv.prevEnPassantY));
-        } else {
-            enPassantTarget.reset();
+        board.movePiece(fromX, fromY, toX, toY);
+
+        if (piece->getType() == PieceType::Pawn &&
+            ((moverColor == Color::White && toY == 7) || (moverColor == Color::Black && toY == 0))) {
+            PieceType chosen = move.promotion.value_or(PieceType::Queen);
+            switch (chosen) {
+                case PieceType::Queen:
+                case PieceType::Rook:
+                case PieceType::Bishop:
+                case PieceType::Knight:
+                    break;
+                default:
+                    chosen = PieceType::Queen;
+                    break;
+            }
+            auto promotedPiece = Piece::create(chosen, moverColor, toX, toY);
+            promotedPiece->markMoved();
+            mv.promotion = true;
+            mv.promotedFrom = piece;
+            mv.promotedTo = chosen;
+            board.setPieceAt(toX, toY, promotedPiece);
         }
-        return;
     }
 
     piece->markMoved();
-
     enPassantTarget.reset();
     if (piece->getType() == PieceType::Pawn && std::abs(dy) == 2) {
-        int passedY = (fromY + toY) / 2;
-        enPassantTarget = std::make_pair(toX, passedY);
+        enPassantTarget = std::make_pair(toX, (fromY + toY) / 2);
     }
+    halfmoveClock = resetsClock ? 0 : halfmoveClock + 1;
 
+    mv.serial = ++lastSerial;
     moveHistory.push_back(mv);
     whiteTurn = !whiteTurn;
     currentPlayer = whiteTurn ? Color::White : Color::Black;
     moveCount++;
+    positionHashes.push_back(getPositionHash());
+    invalidateStatus();
+}
+
+bool Game::replayFrom(const PositionSetup& start, const std::vector<MoveCoords>& moves) {
+    setPosition(start);
+    return applyMovesUnchecked(moves);
+}
+
+bool Game::applyMovesUnchecked(const MoveCoords* moves, size_t count) {
+    moveHistory.reserve(moveHistory.size() + count);
+    positionHashes.reserve(positionHashes.size() + count);
+    auto fits = [this](const MoveCoords& move) {
+        auto inside = [](int v) { return v >= 0 && v < 8; };
+        if (!inside(move.fromX) || !inside(move.fromY) || !inside(move.toX) || !inside(move.toY)) return false;
+        const auto& piece = board.getPieceAt(move.fromX, move.fromY);
+        if (!piece || piece->getColor() != currentPlayer) return false;
+        const auto& target = board.getPieceAt(move.toX, move.toY);
+        return !target || (target->getColor() != currentPlayer && target->getType() != PieceType::King);
+    };
+    // Recorded moves were legal when played; only guard against records that do not fit the board.
+    bool complete = true;
+    for (size_t i = 0; i < count && complete; ++i) {
+        complete = fits(moves[i]);
+        if (complete) applyMove(moves[i]);
+    }
+    // Also after a bad move: the ones before it stay played.
+    publish();
+    return complete;
+}
+
+bool Game::applyMovesUnchecked(const std::vector<MoveCoords>& moves) {
+    return applyMovesUnchecked(moves.data(), moves.size());
+}
+
+size_t Game::applyMoves(const std::string_view* uciMoves, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        auto move = parseUci(uciMoves[i]);
+        if (!move || makeMove(move->fromX, move->fromY, move->toX, move->toY,
+                              move->promotion.value_or(PieceType::Queen)) != MoveStatus::Ok) {
+            return i;
+        }
+    }
+    return count;
+}
+
+size_t Game::applyMoves(const std::vector<std::string>& uciMoves) {
+    std::vector<std::string_view> views(uciMoves.begin(), uciMoves.end());
+    return applyMoves(views.data(), views.size());
+}
+
+int Game::getRepetitionCount() const {
+    // Only positions since the last irreversible move can repeat, and only with the same side to move.
+    if (positionHashes.empty()) return 1;
+    int count = 0;
+    int lookback = std::min<int>(halfmoveClock, static_cast<int>(positionHashes.size()) - 1);
+    uint64_t current = positionHashes.back();
+    for (int back = 0; back <= lookback; back += 2) {
+        if (positionHashes[positionHashes.size() - 1 - static_cast<size_t>(back)] == current) ++count;
+    }
+    return count;
 }
 
 void Game::undoMove() {
+    CHESS_METRIC_SCOPE(MetricOp::UndoMove);
+    takeBackMove();
+}
+
+void Game::takeBackMove() {
     if (moveHistory.empty()) return;
+    retractMove();
+    publish();
+}
+
+// Takes back the last move without publishing, e.g. a trial move that turned out illegal.
+void Game::retractMove() {
     Move last = moveHistory.back();
     whiteTurn = !whiteTurn;
     currentPlayer = whiteTurn ? Color::White : Color::Black;
@@ -209,20 +285,127 @@ void Game::undoMove() {
         if (movedPiece) movedPiece->setMoved(last.pieceMovedBefore);
     }
 
+    halfmoveClock = last.prevHalfmoveClock;
     moveHistory.pop_back();
+    if (positionHashes.size() > 1) positionHashes.pop_back();
     if (moveCount > 0) moveCount--;
 }
 
-bool Game::hasLegalMove(Color color) {
+void Game::setSnapshotPublishing(bool enabled) {
+    publishing = enabled;
+    if (enabled) {
+        publish();
+    } else {
+        published.store(nullptr);
+    }
+}
+
+std::shared_ptr<const GameSnapshot> Game::snapshot() const {
+    return published.load();
+}
+
+// Builds the snapshot completely before the swap, so readers see either the old position or the
+// new one. Readers still holding the old snapshot keep it alive until they let go.
+void Game::publish() {
+    if (!publishing || positionHashes.empty()) return; // nothing set up yet
+    auto next = std::make_shared<GameSnapshot>();
+    next->position = getPosition();
+    next->fen = fen();
+    next->status = getStatus();
+    next->hash = positionHashes.back();
+    next->ply = static_cast<int>(moveHistory.size());
+    if (!moveHistory.empty()) {
+        const Move& last = moveHistory.back();
+        next->lastMove = MoveCoords{last.getFromX(), last.getFromY(), last.getToX(), last.getToY(), std::nullopt};
+        if (last.promotion) next->lastMove->promotion = last.promotedTo;
+    }
+    published.store(std::move(next));
+}
+
+Game::StatusCache& Game::status() {
+    size_t ply = moveHistory.size();
+    if (statusStack.size() <= ply) statusStack.resize(ply + 1);
+    return statusStack[ply];
+}
+
+void Game::invalidateStatus() {
+    status() = StatusCache();
+    legalLists[moveHistory.size() % 2].ply = kNoPly;
+}
+
+// For a new position without history: drops what is cached for earlier plies.
+void Game::resetStatus() {
+    statusStack.clear();
+    for (auto& list : legalLists) list.ply = kNoPly;
+    invalidateStatus();
+}
+
+const Game::LegalMoveCache* Game::knownMoves() const {
+    const LegalMoveCache& list = legalLists[moveHistory.size() % 2];
+    return list.ply == moveHistory.size() ? &list : nullptr;
+}
+
+bool Game::sideToMoveInCheck() {
+    StatusCache& current = status();
+    if (current.inCheck < 0) current.inCheck = isInCheck(currentPlayer);
+    return current.inCheck != 0;
+}
+
+// Stops at the first legal move unless the full list has already been generated.
+bool Game::hasLegalMove() {
+    StatusCache& current = status();
+    if (current.hasLegalMove < 0) current.hasLegalMove = collectLegalMoves(currentPlayer, nullptr);
+    return current.hasLegalMove != 0;
+}
+
+const std::vector<MoveCoords>& Game::legalMoveList() {
+    size_t ply = moveHistory.size();
+    LegalMoveCache& list = legalLists[ply % 2];
+    if (list.ply != ply) {
+        list.moves.clear();
+        status().hasLegalMove = collectLegalMoves(currentPlayer, &list.moves);
+        std::fill(std::begin(list.targets), std::end(list.targets), 0);
+        for (const auto& move : list.moves) {
+            list.targets[move.fromY * 8 + move.fromX] |= uint64_t{1} << (move.toY * 8 + move.toX);
+        }
+        list.ply = ply;
+    }
+    return list.moves;
+}
+
+std::vector<MoveCoords> Game::getLegalMoves() {
+    return legalMoveList();
+}
+
+uint64_t Game::legalTargets(int x, int y) {
+    if (x < 0 || x >= 8 || y < 0 || y >= 8) return 0;
+    legalMoveList();
+    return knownMoves()->targets[y * 8 + x];
+}
+
+GameStatus Game::getStatus() {
+    bool inCheck = sideToMoveInCheck();
+    if (!hasLegalMove()) return inCheck ? GameStatus::Checkmate : GameStatus::Stalemate;
+    return inCheck ? GameStatus::Check : GameStatus::Ongoing;
+}
+
+// Walks every pseudo-legal move of `color` and keeps the ones that do not leave the king in check.
+// With a null `out` it stops at the first legal move found.
+bool Game::collectLegalMoves(Color color, std::vector<MoveCoords>* out) {
     int direction = (color == Color::White) ? 1 : -1;
+    int promoRank = (color == Color::White) ? 7 : 0;
+    bool found = false;
     for (int y = 0; y < 8; ++y) {
         for (int x = 0; x < 8; ++x) {
             auto piece = board.getPieceAt(x, y);
             if (!piece || piece->getColor() != color) continue;
 
             if (piece->getType() == PieceType::King) {
-                if (canCastle(color, true) || canCastle(color, false)) {
-                    return true;
+                for (bool kingSide : {true, false}) {
+                    if (!canCastle(color, kingSide)) continue;
+                    if (!out) return true;
+                    out->push_back(MoveCoords{x, y, kingSide ? 6 : 2, y, std::nullopt});
+                    found = true;
                 }
             }
 
@@ -246,7 +429,10 @@ bool Game::hasLegalMove(Color color) {
                         board.setPieceAt(toX, y, captured);
                         captured->setPosition(toX, y);
 
-                        if (!leavesInCheck) return true;
+                        if (leavesInCheck) continue;
+                        if (!out) return true;
+                        out->push_back(MoveCoords{x, y, toX, toY, std::nullopt});
+                        found = true;
                         continue;
                     }
 
@@ -257,8 +443,7 @@ bool Game::hasLegalMove(Color color) {
 
                     bool promoted = false;
                     std::shared_ptr<Piece> originalMoved = board.getPieceAt(toX, toY);
-                    if (piece->getType() == PieceType::Pawn &&
-                        ((color == Color::White && toY == 7) || (color == Color::Black && toY == 0))) {
+                    if (piece->getType() == PieceType::Pawn && toY == promoRank) {
                         auto promotedPiece = Piece::create(PieceType::Queen, color, toX, toY);
                         board.setPieceAt(toX, toY, promotedPiece);
                         promoted = true;
@@ -274,24 +459,31 @@ bool Game::hasLegalMove(Color color) {
                         board.setPieceAt(toX, toY, captured);
                         captured->setPosition(toX, toY);
                     }
-                    if (!leavesInCheck) return true;
+                    if (leavesInCheck) continue;
+                    if (!out) return true;
+                    if (promoted) {
+                        for (PieceType promo : {PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight}) {
+                            out->push_back(MoveCoords{x, y, toX, toY, promo});
+                        }
+                    } else {
+                        out->push_back(MoveCoords{x, y, toX, toY, std::nullopt});
+                    }
+                    found = true;
                 }
             }
         }
     }
-    return false;
+    return found;
 }
 
 bool Game::isCheckmate() {
-    Color toMove = currentPlayer;
-    if (!isInCheck(toMove)) return false;
-    return !hasLegalMove(toMove);
+    CHESS_METRIC_SCOPE(MetricOp::IsCheckmate);
+    return sideToMoveInCheck() && !hasLegalMove();
 }
 
 bool Game::isStalemate() {
-    Color toMove = currentPlayer;
-    if (isInCheck(toMove)) return false;
-    return !hasLegalMove(toMove);
+    CHESS_METRIC_SCOPE(MetricOp::IsStalemate);
+    return !sideToMoveInCheck() && !hasLegalMove();
 }
 
 bool Game::isSquareAttacked(int x, int y, Color byColor) const {
@@ -397,11 +589,320 @@ bool Game::isInCheck(Color color) const {
     return isSquareAttacked(kingX, kingY, (color == Color::White) ? Color::Black : Color::White);
 }
 
-void Game::saveToFile(const std::string& filename) {
+bool Game::setFen(std::string_view fen) {
+    PositionSetup setup;
+    if (!parseFen(fen, setup)) return false;
+    setPosition(setup);
+    return true;
+}
+
+bool Game::parseFen(std::string_view fen, PositionSetup& setup) {
+    size_t pos = 0;
+    auto nextField = [&]() {
+        while (pos < fen.size() && fen[pos] == ' ') ++pos;
+        size_t start = pos;
+        while (pos < fen.size() && fen[pos] != ' ') ++pos;
+        return fen.substr(start, pos - start);
+    };
+
+    std::string_view placement = nextField();
+    std::string_view side = nextField();
+    std::string_view castling = nextField();
+    std::string_view ep = nextField();
+    std::string_view halfmove = nextField();
+    std::string_view fullmove = nextField();
+
+    setup = PositionSetup();
+    int x = 0, y = 7;
+    for (char c : placement) {
+        if (c == '/') {
+            if (x != 8 || y == 0) return false;
+            x = 0;
+            --y;
+        } else if (c >= '1' && c <= '8') {
+            for (int n = c - '0'; n > 0; --n) {
+                if (x >= 8) return false;
+                setup.squares[y][x++] = '.';
+            }
+        } else if (c != '\0' && std::strchr("pnbrqkPNBRQK", c)) {
+            if (x >= 8) return false;
+            setup.squares[y][x++] = c;
+        } else {
+            return false;
+        }
+    }
+    if (x != 8 || y != 0) return false;
+    if (side != "w" && side != "b") return false;
+    setup.whiteToMove = side == "w";
+
+    for (char c : castling) {
+        switch (c) {
+            case 'K': setup.castling |= 1; break;
+            case 'Q': setup.castling |= 2; break;
+            case 'k': setup.castling |= 4; break;
+            case 'q': setup.castling |= 8; break;
+            default: break;
+        }
+    }
+    if (!ep.empty() && ep != "-") {
+        if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || (ep[1] != '3' && ep[1] != '6')) return false;
+        setup.enPassantFile = ep[0] - 'a';
+    }
+    auto parseCounter = [](std::string_view digits, int& value) {
+        value = 0;
+        for (char c : digits) {
+            if (c < '0' || c > '9' || value > 100000) return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    };
+    return parseCounter(halfmove, setup.halfmoveClock) && parseCounter(fullmove, setup.fullmoveNumber);
+}
+
+PositionSetup Game::getPosition() const {
+    PositionSetup setup;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            const auto& piece = board.getPieceAt(x, y);
+            setup.squares[y][x] = piece ? piece->getSymbol() : '.';
+        }
+    }
+    setup.whiteToMove = whiteTurn;
+    setup.castling = castlingRights();
+    setup.enPassantFile = enPassantTarget ? enPassantTarget->first : -1;
+    setup.halfmoveClock = halfmoveClock;
+    setup.fullmoveNumber = moveCount / 2 + 1;
+    return setup;
+}
+
+void Game::setPosition(const PositionSetup& setup) {
+    auto hasRight = [&](int right) { return (setup.castling & right) != 0; };
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            char symbol = setup.squares[row][col];
+            if (symbol == '.') {
+                if (board.getPieceAt(col, row)) board.setPieceAt(col, row, nullptr);
+                continue;
+            }
+            Piece* piece = board.getPieceAt(col, row).get();
+            if (!piece || piece->getSymbol() != symbol) {
+                board.setPieceAt(col, row, Piece::createFromSymbol(symbol, col, row));
+                piece = board.getPieceAt(col, row).get();
+            }
+            // Only kings, rooks and pawns care about the moved flag.
+            bool moved = false;
+            bool white = piece->getColor() == Color::White;
+            int homeRank = white ? 0 : 7;
+            int kingSide = white ? 1 : 4;
+            int queenSide = white ? 2 : 8;
+            switch (piece->getType()) {
+                case PieceType::King:
+                    moved = !(row == homeRank && col == 4 && (hasRight(kingSide) || hasRight(queenSide)));
+                    break;
+                case PieceType::Rook:
+                    moved = !(row == homeRank && ((col == 7 && hasRight(kingSide)) || (col == 0 && hasRight(queenSide))));
+                    break;
+                case PieceType::Pawn:
+                    moved = row != (white ? 1 : 6);
+                    break;
+                default:
+                    break;
+            }
+            piece->setMoved(moved);
+        }
+    }
+
+    whiteTurn = setup.whiteToMove;
+    currentPlayer = whiteTurn ? Color::White : Color::Black;
+    moveCount = std::max(0, (std::max(1, setup.fullmoveNumber) - 1) * 2 + (whiteTurn ? 0 : 1));
+    halfmoveClock = setup.halfmoveClock;
+    if (setup.enPassantFile >= 0 && setup.enPassantFile < 8) {
+        enPassantTarget = std::make_pair(setup.enPassantFile, whiteTurn ? 5 : 2);
+    } else {
+        enPassantTarget.reset();
+    }
+    moveHistory.clear();
+    char buffer[kMaxFenLength];
+    startFen.assign(buffer, writeFen(buffer));
+    positionHashes.assign(1, getPositionHash());
+    resetStatus();
+    publish();
+}
+
+std::string Game::fen() const {
+    char buffer[kMaxFenLength];
+    return std::string(buffer, writeFen(buffer));
+}
+
+size_t Game::writeFen(char* out) const {
+    char* p = out;
+    auto writeNumber = [&](int value) {
+        char digits[12];
+        int n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0 && n < 11);
+        while (n > 0) *p++ = digits[--n];
+    };
+
+    for (int y = 7; y >= 0; --y) {
+        int empty = 0;
+        for (int x = 0; x < 8; ++x) {
+            const auto& piece = board.getPieceAt(x, y);
+            if (!piece) {
+                ++empty;
+                continue;
+            }
+            if (empty) *p++ = static_cast<char>('0' + empty);
+            empty = 0;
+            *p++ = piece->getSymbol();
+        }
+        if (empty) *p++ = static_cast<char>('0' + empty);
+        if (y > 0) *p++ = '/';
+    }
+    *p++ = ' ';
+    *p++ = whiteTurn ? 'w' : 'b';
+    *p++ = ' ';
+
+    int rights = castlingRights();
+    if (rights & 1) *p++ = 'K';
+    if (rights & 2) *p++ = 'Q';
+    if (rights & 4) *p++ = 'k';
+    if (rights & 8) *p++ = 'q';
+    if (rights == 0) *p++ = '-';
+
+    *p++ = ' ';
+    if (enPassantTarget) {
+        *p++ = static_cast<char>('a' + enPassantTarget->first);
+        *p++ = static_cast<char>('1' + enPassantTarget->second);
+    } else {
+        *p++ = '-';
+    }
+    *p++ = ' ';
+    writeNumber(halfmoveClock);
+    *p++ = ' ';
+    writeNumber(moveCount / 2 + 1);
+    return static_cast<size_t>(p - out);
+}
+
+int Game::getHalfmoveClock() const {
+    return halfmoveClock;
+}
+
+std::string Game::getStartFen() const {
+    return startFen;
+}
+
+std::vector<MoveCoords> Game::getMoveHistory() const {
+    std::vector<MoveCoords> moves;
+    moves.reserve(moveHistory.size());
+    for (size_t i = 0; i < moveHistory.size(); ++i) moves.push_back(getHistoryMove(i));
+    return moves;
+}
+
+size_t Game::getHistoryLength() const {
+    return moveHistory.size();
+}
+
+MoveCoords Game::getHistoryMove(size_t index) const {
+    const Move& mv = moveHistory[index];
+    MoveCoords coords{mv.getFromX(), mv.getFromY(), mv.getToX(), mv.getToY(), std::nullopt};
+    if (mv.promotion) coords.promotion = mv.promotedTo;
+    return coords;
+}
+
+uint64_t Game::getMoveSerial(size_t index) const {
+    return moveHistory[index].serial;
+}
+
+int Game::castlingRights() const {
+    auto unmoved = [&](int x, int y, PieceType type, Color color) {
+        const auto& piece = board.getPieceAt(x, y);
+        return piece && piece->getType() == type && piece->getColor() == color && !piece->hasMoved();
+    };
+    int rights = 0;
+    if (unmoved(4, 0, PieceType::King, Color::White)) {
+        if (unmoved(7, 0, PieceType::Rook, Color::White)) rights |= 1;
+        if (unmoved(0, 0, PieceType::Rook, Color::White)) rights |= 2;
+    }
+    if (unmoved(4, 7, PieceType::King, Color::Black)) {
+        if (unmoved(7, 7, PieceType::Rook, Color::Black)) rights |= 4;
+        if (unmoved(0, 7, PieceType::Rook, Color::Black)) rights |= 8;
+    }
+    return rights;
+}
+
+uint64_t Game::getPositionHash() const {
+    uint64_t hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            auto piece = board.getPieceAt(x, y);
+            if (piece) hash ^= zobrist::piece(piece->getType(), piece->getColor(), x, y);
+        }
+    }
+    if (!whiteTurn) hash ^= zobrist::blackToMove();
+    hash ^= zobrist::castling(castlingRights());
+    if (enPassantTarget) {
+        // Only hash the en passant file when a pawn of the side to move could actually capture.
+        int capturerY = enPassantTarget->second + (whiteTurn ? -1 : 1);
+        for (int dx : {-1, 1}) {
+            auto pawn = board.getPieceAt(enPassantTarget->first + dx, capturerY);
+            if (pawn && pawn->getType() == PieceType::Pawn && pawn->getColor() == currentPlayer) {
+                hash ^= zobrist::enPassantFile(enPassantTarget->first);
+                break;
+            }
+        }
+    }
+    return hash;
+}
+
+namespace {
+bool hasExtension(const std::string& filename, const char* ext) {
+    size_t len = std::strlen(ext);
+    return filename.size() >= len && filename.compare(filename.size() - len, len, ext) == 0;
+}
+
+SaveFormat resolveFormat(const std::string& filename, SaveFormat format) {
+    if (format != SaveFormat::Auto) return format;
+    if (hasExtension(filename, ".fen")) return SaveFormat::Fen;
+    if (hasExtension(filename, ".bin")) return SaveFormat::Binary;
+    return SaveFormat::Json;
+}
+} // namespace
+
+bool Game::saveToFile(const std::string& filename, SaveFormat format) {
+    CHESS_METRIC_SCOPE(MetricOp::SaveToFile);
+    format = resolveFormat(filename, format);
+    if (format == SaveFormat::Binary) {
+        if (writeBinarySave(*this, filename)) return true;
+        std::cerr << "Could not write binary save: " << filename << "\n";
+        return false;
+    }
+    if (format == SaveFormat::Fen) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Could not open file for writing: " << filename << "\n";
+            return false;
+        }
+        file << fen() << '\n';
+        file.close();
+        if (file) return true;
+        std::cerr << "Could not write file: " << filename << "\n";
+        return false;
+    }
+
     json j;
 
     j["turn"] = (currentPlayer == Color::White) ? "white" : "black";
     j["move_count"] = moveCount;
+    j["halfmove_clock"] = halfmoveClock;
+    j["fen"] = fen();
+    j["start_fen"] = startFen;
+    std::vector<std::string> moves;
+    moves.reserve(moveHistory.size());
+    for (const auto& mv : getMoveHistory()) moves.push_back(toUci(mv));
+    j["moves"] = moves;
     j["white_name"] = white.getName();
     j["black_name"] = black.getName();
     if (enPassantTarget) {
@@ -434,48 +935,75 @@ void Game::saveToFile(const std::string& filename) {
     std::ofstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Could not open file for writing: " << filename << "\n";
-        return;
+        return false;
     }
     file << std::setw(4) << j;
+    file.close();
+    if (file) return true;
+    std::cerr << "Could not write file: " << filename << "\n";
+    return false;
 }
 
-void Game::loadFromFile(const std::string& filename) {
+void Game::loadFromFile(const std::string& filename, SaveFormat format) {
+    CHESS_METRIC_SCOPE(MetricOp::LoadFromFile);
+    format = resolveFormat(filename, format);
+    if (format == SaveFormat::Binary) {
+        if (!readBinarySave(*this, filename)) std::cerr << "Could not load binary save: " << filename << "\n";
+        return;
+    }
+
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Could not open file: " << filename << "\n";
         return;
     }
 
-    json j;
-    file >> j;
+    if (format == SaveFormat::Fen) {
+        std::string line;
+        std::getline(file, line);
+        if (!setFen(line)) std::cerr << "Invalid FEN in " << filename << "\n";
+        return;
+    }
+
+    JsonSaveRecord save;
+    if (!parseJsonSave(file, save) || !applyJsonSave(save)) {
+        std::cerr << "Could not load JSON save: " << filename << "\n";
+    }
+}
+
+bool Game::applyJsonSave(const JsonSaveRecord& save) {
+    if (save.hasWhiteName) white.setName(save.whiteName);
+    if (save.hasBlackName) black.setName(save.blackName);
+
+    // Prefer replaying the recorded game so that undo works after loading; fall back to the
+    // snapshot if the record is missing or does not lead to the saved position.
+    if (save.hasStartFen && save.hasMoves && save.hasFen && save.movesValid) {
+        PositionSetup start;
+        if (parseFen(save.startFen, start) && replayFrom(start, save.moves) && fen() == save.fen) return true;
+    }
+
+    // Saves without the board array only carry the FEN.
+    if (!save.hasBoard) return save.hasFen && setFen(save.fen);
+    if (!save.hasTurn) return false;
 
     moveHistory.clear();
-    std::string turnStr = j["turn"];
-    currentPlayer = (turnStr == "white") ? Color::White : Color::Black;
+    currentPlayer = (save.turn == "white") ? Color::White : Color::Black;
     whiteTurn = (currentPlayer == Color::White);
-    moveCount = j["move_count"];
-    if (j.contains("white_name")) white.setName(j["white_name"]);
-    if (j.contains("black_name")) black.setName(j["black_name"]);
-    if (j.contains("en_passant") && !j["en_passant"].is_null()) {
-        enPassantTarget = std::make_pair(j["en_passant"]["x"].get<int>(), j["en_passant"]["y"].get<int>());
+    moveCount = save.moveCount;
+    halfmoveClock = save.halfmoveClock;
+    if (save.enPassantX >= 0 && save.enPassantY >= 0) {
+        enPassantTarget = std::make_pair(save.enPassantX, save.enPassantY);
     } else {
         enPassantTarget.reset();
     }
 
-    auto boardData = j["board"];
-    bool hasMovedData = j.contains("moved");
-    json movedData;
-    if (hasMovedData) {
-        movedData = j["moved"];
-    }
-
     for (int y = 0; y < 8; ++y) {
         for (int x = 0; x < 8; ++x) {
-            std::string symbol = boardData[y][x];
-            if (symbol != ".") {
-                auto piece = Piece::createFromSymbol(symbol[0], x, y);
-                if (hasMovedData) {
-                    piece->setMoved(movedData[y][x]);
+            char symbol = save.board[y][x];
+            if (symbol != '.') {
+                auto piece = Piece::createFromSymbol(symbol, x, y);
+                if (save.hasMoved) {
+                    piece->setMoved(save.moved[y][x]);
                 }
                 board.setPieceAt(x, y, piece);
             } else {
@@ -483,4 +1011,9 @@ void Game::loadFromFile(const std::string& filename) {
             }
         }
     }
+    startFen = fen();
+    positionHashes.assign(1, getPositionHash());
+    resetStatus();
+    publish();
+    return true;
 }
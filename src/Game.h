@@ -5,16 +5,54 @@
 #include "Player.h"
 #include "Move.h"
 #include "Piece.h"
+#include "SnapshotCell.h"
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <string_view>
 #include <utility>
 
+// Plain description of a position, shared by the FEN and binary codecs.
+struct PositionSetup {
+    char squares[8][8] = {}; // [y][x], FEN piece letters or '.'
+    bool whiteToMove = true;
+    int castling = 0;        // 1 = K, 2 = Q, 4 = k, 8 = q
+    int enPassantFile = -1;
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+};
+
+enum class SaveFormat { Auto, Json, Fen, Binary };
+
+// Situation of the side to move.
+enum class GameStatus { Ongoing, Check, Checkmate, Stalemate };
+
+// Result of Game::makeMove; anything but Ok leaves the game unchanged.
+enum class MoveStatus { Ok, OffBoard, NoPiece, NotYourTurn, IllegalMove, LeavesKingInCheck };
+const char* moveStatusMessage(MoveStatus status);
+
+struct JsonSaveRecord;
+
+// Flat, immutable copy of a published position (see Game::snapshot). It shares nothing with the
+// live game, so any number of threads can read it while the owner keeps playing.
+struct GameSnapshot {
+    PositionSetup position;
+    std::string fen;
+    GameStatus status = GameStatus::Ongoing;
+    uint64_t hash = 0;
+    int ply = 0; // moves in the history
+    std::optional<MoveCoords> lastMove;
+};
+
 // A j��t�ck logik��j��t kezel�' oszt��ly
 class Game {
 public:
     Game();
 
     void start();
-    void makeMove(int fromX, int fromY, int toX, int toY, PieceType promotionChoice = PieceType::Queen);
+    // With the legal move list of the position already cached (getLegalMoves, legalTargets) this is
+    // a single lookup; otherwise the move is checked directly, as the list costs far more to build.
+    MoveStatus makeMove(int fromX, int fromY, int toX, int toY, PieceType promotionChoice = PieceType::Queen);
     void undoMove();
     bool isCheckmate();
     bool isStalemate();
@@ -26,10 +64,67 @@ public:
     void setPlayerName(Color color, const std::string& name);
     std::optional<std::pair<int, int>> getEnPassantTarget() const;
     bool isInCheck(Color color) const;
+    std::vector<MoveCoords> getLegalMoves();
+    // getStatus, isCheckmate, isStalemate and getLegalMoves answer from a per-position cache that
+    // is filled lazily (only as far as each query needs) and dropped whenever the position changes.
+    GameStatus getStatus();
+    // Destinations of the piece on (x, y) as a mask with bit y * 8 + x set per target square; 0 for
+    // an empty square or a piece of the side not to move.
+    uint64_t legalTargets(int x, int y);
+
+    // FEN import/export. setFen leaves the game untouched and returns false on malformed input.
+    // Both run in a single pass without temporary strings; pieces already on the right square are reused.
+    static constexpr size_t kMaxFenLength = 96;
+    bool setFen(std::string_view fen);
+    static bool parseFen(std::string_view fen, PositionSetup& setup);
+    std::string fen() const;
+    // Writes the FEN into `out` (at least kMaxFenLength bytes, not terminated) and returns its length.
+    size_t writeFen(char* out) const;
+    // Plies since the last capture or pawn move.
+    int getHalfmoveClock() const;
+    PositionSetup getPosition() const;
+    // Sets up the position without validation and starts a fresh move history from it.
+    void setPosition(const PositionSetup& setup);
+    // Rebuilds a recorded game: sets up `start` and replays `moves` without legality checks, restoring
+    // undo records and position hashes. Returns false on a move that does not fit the board.
+    bool replayFrom(const PositionSetup& start, const std::vector<MoveCoords>& moves);
+    // Plays UCI moves ("e2e4", "e7e8q") from the current position with full legality checks,
+    // stopping at the first one that does not parse or is illegal; returns how many were played.
+    size_t applyMoves(const std::string_view* uciMoves, size_t count);
+    size_t applyMoves(const std::vector<std::string>& uciMoves);
+    // Trusted fast path for sequences that were legal when recorded (saves, journals, engine PVs):
+    // only moves that do not fit the board are refused. Returns false at the first such move,
+    // leaving the moves before it played.
+    bool applyMovesUnchecked(const MoveCoords* moves, size_t count);
+    bool applyMovesUnchecked(const std::vector<MoveCoords>& moves);
+    // How often the current position occurred (including now) since the last irreversible move.
+    int getRepetitionCount() const;
+    // Zobrist hash of the position (placement, side to move, castling rights, capturable en passant).
+    uint64_t getPositionHash() const;
+    // Position the current move history starts from (set by start(), setFen() and loading).
+    std::string getStartFen() const;
+    std::vector<MoveCoords> getMoveHistory() const;
+    size_t getHistoryLength() const;
+    MoveCoords getHistoryMove(size_t index) const;
+    // Every move a Game plays gets a new serial, so a serial still found at `index` means the history
+    // up to there is unchanged; lets observers find what changed without comparing the whole history.
+    uint64_t getMoveSerial(size_t index) const;
+
+    // With publishing on, every change of position (moves, undo, setup, loading) swaps in a new
+    // snapshot atomically (see SnapshotCell.h). snapshot() takes no lock, only atomic counter updates,
+    // and may be called from any thread while the owner mutates the game; it returns null until a
+    // position has been set up with publishing on. Off by default, as building a snapshot costs a
+    // status check and a FEN per move.
+    void setSnapshotPublishing(bool enabled);
+    std::shared_ptr<const GameSnapshot> snapshot() const;
 
     // JSON ment�cs/bet�lt�cs
-    void saveToFile(const std::string& filename);
-    void loadFromFile(const std::string& filename);
+    // Auto picks the format from the extension: .fen, .bin (compact binary, see BinarySave.h), else JSON.
+    // Returns false (after reporting on stderr) when the file could not be written completely.
+    bool saveToFile(const std::string& filename, SaveFormat format = SaveFormat::Auto);
+    void loadFromFile(const std::string& filename, SaveFormat format = SaveFormat::Auto);
+    // Loads a parsed JSON save (see JsonSave.h); false if it holds neither a usable record nor a board.
+    bool applyJsonSave(const JsonSaveRecord& save);
 
 private:
     Board board;
@@ -39,10 +134,54 @@ private:
 
     bool whiteTurn;           // feh�cr van-e soron
     Color currentPlayer;      // aktu��lis j��t�ckos sz��ne
+    int halfmoveClock = 0;
     int moveCount;            // h��ny l�cp�cs t�rt�cnt eddig
     std::optional<std::pair<int, int>> enPassantTarget;
+    std::string startFen;
+    std::vector<uint64_t> positionHashes; // one per position since startFen, current last
+    uint64_t lastSerial = 0;
+
+    // What is known so far about a position; -1 means not computed yet.
+    struct StatusCache {
+        int8_t inCheck = -1;
+        int8_t hasLegalMove = -1;
+    };
+    // One entry per ply of the move history. undoMove restores the previous position exactly, so
+    // its entry stays valid.
+    std::vector<StatusCache> statusStack;
+    // Full legal move lists are kept only for the current ply and its parent (slot ply % 2), so
+    // sibling moves in a search still share the parent's list without a list per ply.
+    static constexpr size_t kNoPly = static_cast<size_t>(-1);
+    struct LegalMoveCache {
+        size_t ply = kNoPly;
+        std::vector<MoveCoords> moves;
+        uint64_t targets[64] = {}; // per from-square
+    };
+    LegalMoveCache legalLists[2];
+
+    bool publishing = false;
+    SnapshotCell<GameSnapshot> published;
+
+    // makeMove and undoMove without the metrics samples, which would cost a clock read per node
+    // in a search.
+    friend class Searcher;
+    MoveStatus playMove(int fromX, int fromY, int toX, int toY, PieceType promotionChoice);
+    void takeBackMove();
+
+    void publish();
+    void retractMove();
 
-    bool hasLegalMove(Color color);
+    void applyMove(const MoveCoords& move);
+    StatusCache& status();
+    void invalidateStatus();
+    void resetStatus();
+    const LegalMoveCache* knownMoves() const;
+    const std::vector<MoveCoords>& legalMoveList();
+    bool sideToMoveInCheck();
+    bool hasLegalMove();
+    bool collectLegalMoves(Color color, std::vector<MoveCoords>* out);
     bool canCastle(Color color, bool kingSide) const;
     bool isSquareAttacked(int x, int y, Color byColor) const;
+    // Bitmask of castling rights derived from unmoved kings/rooks: 1 = K, 2 = Q, 4 = k, 8 = q.
+    int castlingRights() const;
 };
@@ -0,0 +1,264 @@
+#include "GameDatabase.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace {
+constexpr char kMagic[8] = {'2', 'Q', '1', 'K', 'G', 'D', 'B', '\0'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t gameCount;
+    uint64_t postingCount;
+    uint64_t moveCount;
+    uint64_t postingsOffset;
+    uint64_t gamesOffset;
+    uint64_t movesOffset;
+    uint64_t stringsOffset;
+};
+static_assert(sizeof(Header) == 64, "database header must stay 64 bytes");
+static_assert(sizeof(gamedb::Posting) == 16, "postings must stay 16 bytes");
+static_assert(sizeof(gamedb::GameRecord) == 32, "game records must stay 32 bytes");
+
+GameResult parseResult(const std::string& text) {
+    if (text == "1-0") return GameResult::WhiteWins;
+    if (text == "0-1") return GameResult::BlackWins;
+    if (text == "1/2-1/2") return GameResult::Draw;
+    return GameResult::Unknown;
+}
+
+uint16_t parseElo(const std::string& text) {
+    int elo = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return 0;
+        elo = elo * 10 + (c - '0');
+        if (elo > 4000) return 0;
+    }
+    return static_cast<uint16_t>(elo);
+}
+
+size_t alignUp(size_t offset) {
+    return (offset + 15) & ~size_t{15};
+}
+
+bool postingLess(const gamedb::Posting& a, const gamedb::Posting& b) {
+    if (a.key != b.key) return a.key < b.key;
+    if (a.game != b.game) return a.game < b.game;
+    return a.ply < b.ply;
+}
+} // namespace
+
+uint32_t GameDatabaseBuilder::addString(const std::string& text) {
+    if (text.empty()) return 0;
+    uint32_t offset = static_cast<uint32_t>(strings.size());
+    strings += text;
+    strings.push_back('\0');
+    return offset;
+}
+
+bool GameDatabaseBuilder::addGame(const PgnGame& pgn) {
+    std::string white, black, fen, whiteElo, blackElo;
+    for (const auto& tag : pgn.tags) {
+        if (tag.first == "White") white = tag.second;
+        else if (tag.first == "Black") black = tag.second;
+        else if (tag.first == "FEN") fen = tag.second;
+        else if (tag.first == "WhiteElo") whiteElo = tag.second;
+        else if (tag.first == "BlackElo") blackElo = tag.second;
+    }
+    if (fen.empty()) {
+        game.start();
+    } else if (!game.setFen(fen)) {
+        return false;
+    }
+    if (pgn.sanMoves.size() > 0xFFFF) return false;
+
+    auto id = static_cast<uint32_t>(games.size());
+    size_t firstPosting = postings.size();
+    size_t firstMove = moves.size();
+    for (size_t ply = 0; ply < pgn.sanMoves.size(); ++ply) {
+        auto move = parseSan(game, pgn.sanMoves[ply]);
+        if (!move) {
+            postings.resize(firstPosting);
+            moves.resize(firstMove);
+            return false;
+        }
+        uint16_t packed = packMove(*move);
+        postings.push_back({game.getPositionHash(), id, static_cast<uint16_t>(ply), packed});
+        moves.push_back(packed);
+        game.makeMove(move->fromX, move->fromY, move->toX, move->toY, move->promotion.value_or(PieceType::Queen));
+    }
+    postings.push_back({game.getPositionHash(), id, static_cast<uint16_t>(pgn.sanMoves.size()), 0});
+
+    gamedb::GameRecord record{};
+    record.firstMove = firstMove;
+    record.whiteName = addString(white);
+    record.blackName = addString(black);
+    record.startFen = addString(fen);
+    record.plies = static_cast<uint16_t>(pgn.sanMoves.size());
+    record.whiteElo = parseElo(whiteElo);
+    record.blackElo = parseElo(blackElo);
+    record.result = static_cast<uint8_t>(parseResult(pgn.result));
+    games.push_back(record);
+    return true;
+}
+
+bool GameDatabaseBuilder::write(const std::string& path) {
+    std::sort(postings.begin(), postings.end(), postingLess);
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.gameCount = static_cast<uint32_t>(games.size());
+    header.postingCount = postings.size();
+    header.moveCount = moves.size();
+    header.postingsOffset = sizeof(Header);
+    header.gamesOffset = alignUp(header.postingsOffset + postings.size() * sizeof(gamedb::Posting));
+    header.movesOffset = alignUp(header.gamesOffset + games.size() * sizeof(gamedb::GameRecord));
+    header.stringsOffset = alignUp(header.movesOffset + moves.size() * sizeof(uint16_t));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    auto writeAt = [&](uint64_t offset, const void* data, size_t size) {
+        static const char zeros[16] = {};
+        auto position = static_cast<uint64_t>(out.tellp());
+        out.write(zeros, static_cast<std::streamsize>(offset - position));
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.postingsOffset, postings.data(), postings.size() * sizeof(gamedb::Posting));
+    writeAt(header.gamesOffset, games.data(), games.size() * sizeof(gamedb::GameRecord));
+    writeAt(header.movesOffset, moves.data(), moves.size() * sizeof(uint16_t));
+    writeAt(header.stringsOffset, strings.data(), strings.size());
+    return static_cast<bool>(out);
+}
+
+bool GameDatabase::open(const std::string& path) {
+    close();
+    if (!file.open(path, MappedFile::Mode::ReadOnly) || file.size() < sizeof(Header)) {
+        close();
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(Header));
+    size_t size = file.size();
+    bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+                 header.postingsOffset + header.postingCount * sizeof(gamedb::Posting) <= header.gamesOffset &&
+                 header.gamesOffset + uint64_t{header.gameCount} * sizeof(gamedb::GameRecord) <= header.movesOffset &&
+                 header.movesOffset + header.moveCount * sizeof(uint16_t) <= header.stringsOffset &&
+                 header.stringsOffset < size && file.data()[size - 1] == '\0';
+    if (!valid) close();
+    return valid;
+}
+
+void GameDatabase::close() {
+    file.close();
+}
+
+size_t GameDatabase::gameCount() const {
+    if (!isOpen()) return 0;
+    return reinterpret_cast<const Header*>(file.data())->gameCount;
+}
+
+size_t GameDatabase::positionCount() const {
+    if (!isOpen()) return 0;
+    return reinterpret_cast<const Header*>(file.data())->postingCount;
+}
+
+GameDatabase::Range GameDatabase::find(uint64_t key) const {
+    if (!isOpen()) return {};
+    const auto* header = reinterpret_cast<const Header*>(file.data());
+    const auto* begin = reinterpret_cast<const gamedb::Posting*>(file.data() + header->postingsOffset);
+    const auto* end = begin + header->postingCount;
+    auto first = std::lower_bound(begin, end, key, [](const gamedb::Posting& p, uint64_t k) { return p.key < k; });
+    auto last = std::upper_bound(first, end, key, [](uint64_t k, const gamedb::Posting& p) { return k < p.key; });
+    return {static_cast<size_t>(first - begin), static_cast<size_t>(last - begin)};
+}
+
+std::vector<MoveStats> GameDatabase::explore(Game& game) const {
+    Range range = find(game.getPositionHash());
+    if (range.begin == range.end) return {};
+    const auto* header = reinterpret_cast<const Header*>(file.data());
+    const auto* postings = reinterpret_cast<const gamedb::Posting*>(file.data() + header->postingsOffset);
+    const auto* records = reinterpret_cast<const gamedb::GameRecord*>(file.data() + header->gamesOffset);
+
+    struct Totals {
+        MoveStats stats;
+        uint64_t ratingSum = 0, rated = 0;
+    };
+    std::map<uint16_t, Totals> byMove;
+    bool whiteToMove = game.isWhiteTurn();
+    for (size_t i = range.begin; i < range.end; ++i) {
+        const auto& posting = postings[i];
+        if (posting.move == 0 || posting.game >= header->gameCount) continue;
+        const auto& record = records[posting.game];
+        Totals& totals = byMove[posting.move];
+        ++totals.stats.games;
+        switch (static_cast<GameResult>(record.result)) {
+            case GameResult::WhiteWins: ++totals.stats.whiteWins; break;
+            case GameResult::Draw: ++totals.stats.draws; break;
+            case GameResult::BlackWins: ++totals.stats.blackWins; break;
+            default: break;
+        }
+        uint16_t rating = whiteToMove ? record.whiteElo : record.blackElo;
+        if (rating) {
+            totals.ratingSum += rating;
+            ++totals.rated;
+        }
+    }
+
+    std::vector<MoveStats> result;
+    result.reserve(byMove.size());
+    for (auto& [packed, totals] : byMove) {
+        MoveStats stats = totals.stats;
+        stats.move = unpackMove(packed);
+        stats.san = toSan(game, stats.move);
+        if (stats.san.empty()) continue; // hash collision with another position
+        uint64_t decided = stats.whiteWins + stats.draws + stats.blackWins;
+        if (decided) {
+            double wins = static_cast<double>(whiteToMove ? stats.whiteWins : stats.blackWins);
+            stats.score = (wins + 0.5 * static_cast<double>(stats.draws)) / static_cast<double>(decided);
+        }
+        if (totals.rated) stats.averageRating = static_cast<int>(totals.ratingSum / totals.rated);
+        result.push_back(std::move(stats));
+    }
+    std::sort(result.begin(), result.end(), [](const MoveStats& a, const MoveStats& b) { return a.games > b.games; });
+    return result;
+}
+
+std::vector<GamePosting> GameDatabase::gamesAt(const Game& game, size_t limit) const {
+    Range range = find(game.getPositionHash());
+    const auto* header = reinterpret_cast<const Header*>(file.data());
+    std::vector<GamePosting> result;
+    for (size_t i = range.begin; i < range.end && result.size() < limit; ++i) {
+        const auto& posting = reinterpret_cast<const gamedb::Posting*>(file.data() + header->postingsOffset)[i];
+        result.push_back({posting.game, posting.ply});
+    }
+    return result;
+}
+
+std::optional<StoredGame> GameDatabase::loadGame(uint32_t id) const {
+    if (!isOpen()) return std::nullopt;
+    const auto* header = reinterpret_cast<const Header*>(file.data());
+    if (id >= header->gameCount) return std::nullopt;
+    const auto& record = reinterpret_cast<const gamedb::GameRecord*>(file.data() + header->gamesOffset)[id];
+    if (record.firstMove + record.plies > header->moveCount) return std::nullopt;
+
+    size_t stringsSize = file.size() - header->stringsOffset;
+    auto text = [&](uint32_t offset) -> std::string {
+        if (offset == 0 || offset >= stringsSize) return "";
+        return reinterpret_cast<const char*>(file.data() + header->stringsOffset + offset);
+    };
+    StoredGame game;
+    game.white = text(record.whiteName);
+    game.black = text(record.blackName);
+    game.startFen = text(record.startFen);
+    game.whiteElo = record.whiteElo;
+    game.blackElo = record.blackElo;
+    game.result = static_cast<GameResult>(record.result);
+    const auto* moves = reinterpret_cast<const uint16_t*>(file.data() + header->movesOffset) + record.firstMove;
+    game.moves.reserve(record.plies);
+    for (uint16_t i = 0; i < record.plies; ++i) game.moves.push_back(unpackMove(moves[i]));
+    return game;
+}
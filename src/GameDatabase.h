@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Game.h"
+#include "MappedFile.h"
+#include "Pgn.h"
+
+// Position-indexed game database.
+//
+// One file holds a header, a posting index sorted by position hash, a fixed-size record per game,
+// the games' moves as 16-bit packed moves, and a string blob (names, start FENs). Every position
+// of every game has a posting (hash, game, ply, move played next), so "which games reached this
+// position and what was played" is a binary search plus a scan over adjacent postings.
+// The file is mapped read-only; nothing is loaded up front.
+
+enum class GameResult : uint8_t { WhiteWins, Draw, BlackWins, Unknown };
+
+struct MoveStats {
+    MoveCoords move;
+    std::string san;
+    uint64_t games = 0;
+    uint64_t whiteWins = 0, draws = 0, blackWins = 0;
+    double score = 0;      // for the side to move, over games with a known result
+    int averageRating = 0; // of the player making the move, 0 if no game had a rating
+};
+
+struct GamePosting {
+    uint32_t game = 0;
+    uint16_t ply = 0;
+};
+
+struct StoredGame {
+    std::string white, black;
+    int whiteElo = 0, blackElo = 0;
+    GameResult result = GameResult::Unknown;
+    std::string startFen; // empty for the initial position
+    std::vector<MoveCoords> moves;
+};
+
+namespace gamedb {
+// On-disk layout (native byte order, little endian in practice).
+struct Posting {
+    uint64_t key;
+    uint32_t game;
+    uint16_t ply;
+    uint16_t move; // packed move played from this position, 0 where the game ended
+};
+
+struct GameRecord {
+    uint64_t firstMove; // index into the move section
+    uint32_t whiteName, blackName, startFen; // string blob offsets, 0 = empty
+    uint16_t plies;
+    uint16_t whiteElo, blackElo;
+    uint8_t result;
+    uint8_t reserved[5];
+};
+} // namespace gamedb
+
+// Collects games in memory and writes the database file.
+class GameDatabaseBuilder {
+public:
+    // Replays the game; returns false (and adds nothing) if a move cannot be resolved.
+    bool addGame(const PgnGame& pgn);
+    bool write(const std::string& path);
+
+    size_t gameCount() const { return games.size(); }
+
+private:
+    uint32_t addString(const std::string& text);
+
+    std::vector<gamedb::Posting> postings;
+    std::vector<gamedb::GameRecord> games;
+    std::vector<uint16_t> moves;
+    std::string strings = std::string(1, '\0');
+    Game game;
+};
+
+class GameDatabase {
+public:
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    size_t gameCount() const;
+    size_t positionCount() const;
+
+    // Moves played from the game's current position, most frequent first.
+    std::vector<MoveStats> explore(Game& game) const;
+    // Games that reached the position, with the ply at which they did (at most `limit`).
+    std::vector<GamePosting> gamesAt(const Game& game, size_t limit = 100) const;
+    std::optional<StoredGame> loadGame(uint32_t id) const;
+
+private:
+    struct Range {
+        size_t begin = 0, end = 0;
+    };
+    Range find(uint64_t key) const;
+
+    MappedFile file;
+};
@@ -0,0 +1,191 @@
+#include "GameSessionManager.h"
+#include "BinarySave.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+GameSessionManager::GameSessionManager(Options options)
+    : options(std::move(options)), shards(std::max<size_t>(1, this->options.shards)) {
+    residentPerShard = std::max<size_t>(1, (this->options.maxResident + shards.size() - 1) / shards.size());
+    poolPerShard = this->options.poolSize / shards.size();
+    if (!this->options.spillDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(this->options.spillDirectory, error);
+    }
+}
+
+GameSessionManager::~GameSessionManager() {
+    if (options.spillDirectory.empty()) return;
+    for (auto& shard : shards) {
+        for (auto& entry : shard.sessions) {
+            if (!entry.second.game) {
+                std::error_code error;
+                std::filesystem::remove(spillPath(entry.first), error);
+            }
+        }
+    }
+}
+
+std::string GameSessionManager::spillPath(SessionId id) const {
+    return (std::filesystem::path(options.spillDirectory) / (std::to_string(id) + ".bin")).string();
+}
+
+std::unique_ptr<Game> GameSessionManager::takeGame(Shard& shard) {
+    if (shard.pool.empty()) {
+        auto game = std::make_unique<Game>();
+        game->setSnapshotPublishing(true);
+        return game;
+    }
+    auto game = std::move(shard.pool.back());
+    shard.pool.pop_back();
+    return game;
+}
+
+void GameSessionManager::recycle(Shard& shard, std::unique_ptr<Game> game) {
+    if (shard.pool.size() < poolPerShard) shard.pool.push_back(std::move(game));
+}
+
+SessionId GameSessionManager::create() {
+    SessionId id = nextId++;
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Session& session = shard.sessions[id];
+    session.game = takeGame(shard);
+    session.game->start();
+    session.game->setPlayerName(Color::White, "White");
+    session.game->setPlayerName(Color::Black, "Black");
+    session.lastUsed = Clock::now();
+    shard.lru.push_front(id);
+    session.lruPosition = shard.lru.begin();
+    ++created;
+    trimResident(shard);
+    return id;
+}
+
+bool GameSessionManager::evict(Shard& shard, SessionId id, Session& session) {
+    std::vector<uint8_t> bytes = encodeBinarySave(*session.game);
+    if (bytes.empty()) return false;
+    if (options.spillDirectory.empty()) {
+        session.spilled = std::move(bytes);
+    } else {
+        std::FILE* file = std::fopen(spillPath(id).c_str(), "wb");
+        bool written = file && std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        if (file && std::fclose(file) != 0) written = false;
+        if (!written) return false;
+    }
+    session.lastSnapshot = session.game->snapshot();
+    shard.lru.erase(session.lruPosition);
+    recycle(shard, std::move(session.game));
+    ++shard.evictions;
+    return true;
+}
+
+bool GameSessionManager::restore(Shard& shard, SessionId id, Session& session) {
+    auto game = takeGame(shard);
+    bool loaded = options.spillDirectory.empty()
+                      ? decodeBinarySave(*game, session.spilled.data(), session.spilled.size())
+                      : readBinarySave(*game, spillPath(id));
+    if (!loaded) {
+        recycle(shard, std::move(game));
+        return false;
+    }
+    if (options.spillDirectory.empty()) {
+        std::vector<uint8_t>().swap(session.spilled);
+    } else {
+        std::error_code error;
+        std::filesystem::remove(spillPath(id), error);
+    }
+    session.game = std::move(game);
+    session.lastSnapshot.reset();
+    shard.lru.push_front(id);
+    session.lruPosition = shard.lru.begin();
+    ++shard.restores;
+    return true;
+}
+
+void GameSessionManager::trimResident(Shard& shard) {
+    // The most recently used session is never evicted, so the caller's game stays put.
+    while (shard.lru.size() > residentPerShard) {
+        SessionId victim = shard.lru.back();
+        if (!evict(shard, victim, shard.sessions[victim])) break;
+    }
+}
+
+bool GameSessionManager::withGame(SessionId id, const std::function<void(Game&)>& fn) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(id);
+    if (it == shard.sessions.end()) return false;
+    Session& session = it->second;
+    if (!session.game) {
+        if (!restore(shard, id, session)) return false;
+        trimResident(shard);
+    } else {
+        shard.lru.splice(shard.lru.begin(), shard.lru, session.lruPosition);
+    }
+    session.lastUsed = Clock::now();
+    fn(*session.game);
+    return true;
+}
+
+std::shared_ptr<const GameSnapshot> GameSessionManager::snapshot(SessionId id) const {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(id);
+    if (it == shard.sessions.end()) return nullptr;
+    return it->second.game ? it->second.game->snapshot() : it->second.lastSnapshot;
+}
+
+bool GameSessionManager::contains(SessionId id) const {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.count(id) != 0;
+}
+
+bool GameSessionManager::close(SessionId id) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(id);
+    if (it == shard.sessions.end()) return false;
+    if (it->second.game) {
+        shard.lru.erase(it->second.lruPosition);
+        recycle(shard, std::move(it->second.game));
+    } else if (!options.spillDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::remove(spillPath(id), error);
+    }
+    shard.sessions.erase(it);
+    ++closed;
+    return true;
+}
+
+size_t GameSessionManager::evictIdle(Clock::time_point now) {
+    size_t count = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        // The LRU list is ordered by last use, so idle sessions sit at its tail.
+        while (!shard.lru.empty()) {
+            SessionId id = shard.lru.back();
+            Session& session = shard.sessions[id];
+            if (now - session.lastUsed <= options.idleTimeout || !evict(shard, id, session)) break;
+            ++count;
+        }
+    }
+    return count;
+}
+
+SessionStats GameSessionManager::stats() const {
+    SessionStats result;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result.sessions += shard.sessions.size();
+        result.resident += shard.lru.size();
+        result.pooled += shard.pool.size();
+        result.evictions += shard.evictions;
+        result.restores += shard.restores;
+    }
+    result.evicted = result.sessions - result.resident;
+    result.created = created;
+    result.closed = closed;
+    return result;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Game.h"
+
+using SessionId = uint64_t;
+
+struct SessionManagerOptions {
+    size_t shards = 64;
+    // Games kept in memory; beyond this the least recently used ones are evicted.
+    size_t maxResident = 100000;
+    // evictIdle() evicts games untouched for this long.
+    std::chrono::seconds idleTimeout{300};
+    // Evicted games are written here as <id>.bin binary saves; empty keeps the encoded bytes in memory.
+    std::string spillDirectory;
+    // Spare Game objects kept for reuse by new or restored sessions.
+    size_t poolSize = 1024;
+};
+
+struct SessionStats {
+    size_t sessions = 0;
+    size_t resident = 0;
+    size_t evicted = 0;
+    size_t pooled = 0;
+    uint64_t created = 0;
+    uint64_t closed = 0;
+    uint64_t evictions = 0;
+    uint64_t restores = 0;
+};
+
+// Owns many games keyed by id. Sessions are spread over shards, each with its own lock, map and
+// LRU list, so lookups are O(1) and unrelated sessions rarely contend. Games that fall out of
+// the LRU window or sit idle are encoded in the binary save format and dropped from memory; the
+// next access restores them transparently.
+class GameSessionManager {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Options = SessionManagerOptions;
+
+    explicit GameSessionManager(Options options = {});
+    ~GameSessionManager();
+    GameSessionManager(const GameSessionManager&) = delete;
+    GameSessionManager& operator=(const GameSessionManager&) = delete;
+
+    // Starts a game from the initial position.
+    SessionId create();
+    // Runs `fn` on the session's game while holding its shard lock; false if there is no such
+    // session (or an evicted game could not be restored). Keep `fn` short: long work such as an
+    // engine search should run on a copy of the position outside the call.
+    bool withGame(SessionId id, const std::function<void(Game&)>& fn);
+    // The session's latest published position (games here always publish snapshots). Only the
+    // lookup takes the shard lock; the snapshot itself is read without one, and an evicted game
+    // is not restored for it. Null if there is no such session.
+    std::shared_ptr<const GameSnapshot> snapshot(SessionId id) const;
+    bool contains(SessionId id) const;
+    bool close(SessionId id);
+
+    // Evicts every resident game idle for longer than idleTimeout (as of `now`); returns how many.
+    size_t evictIdle(Clock::time_point now = Clock::now());
+    SessionStats stats() const;
+
+private:
+    struct Session {
+        std::unique_ptr<Game> game; // null while evicted
+        std::vector<uint8_t> spilled;
+        std::shared_ptr<const GameSnapshot> lastSnapshot; // kept while evicted
+        Clock::time_point lastUsed;
+        std::list<SessionId>::iterator lruPosition; // valid while resident
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<SessionId, Session> sessions;
+        std::list<SessionId> lru; // resident sessions, most recently used first
+        std::vector<std::unique_ptr<Game>> pool;
+        uint64_t evictions = 0;
+        uint64_t restores = 0;
+    };
+
+    Shard& shardFor(SessionId id) const { return shards[id % shards.size()]; }
+    std::unique_ptr<Game> takeGame(Shard& shard);
+    void recycle(Shard& shard, std::unique_ptr<Game> game);
+    bool evict(Shard& shard, SessionId id, Session& session);
+    bool restore(Shard& shard, SessionId id, Session& session);
+    void trimResident(Shard& shard);
+    std::string spillPath(SessionId id) const;
+
+    Options options;
+    size_t residentPerShard;
+    size_t poolPerShard;
+    mutable std::vector<Shard> shards;
+    std::atomic<SessionId> nextId{1};
+    std::atomic<uint64_t> created{0};
+    std::atomic<uint64_t> closed{0};
+};
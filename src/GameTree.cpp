@@ -0,0 +1,151 @@
+#include "GameTree.h"
+#include <algorithm>
+
+GameTree::GameTree(int checkpointInterval) : interval(std::max(1, checkpointInterval)) {
+    start();
+}
+
+void GameTree::start() {
+    live.start();
+    reset();
+}
+
+bool GameTree::setFen(std::string_view fen) {
+    if (!live.setFen(fen)) return false;
+    reset();
+    return true;
+}
+
+void GameTree::reset() {
+    nodes.assign(1, Node());
+    nodes[kRoot].checkpoint = live.getPosition();
+    cursor = kRoot;
+    base = kRoot;
+    steps = 0;
+}
+
+// Only pawn moves to the last rank keep a promotion piece, so equal moves compare equal.
+MoveCoords GameTree::normalize(const MoveCoords& move) const {
+    MoveCoords result = move;
+    const auto& piece = live.getBoard().getPieceAt(move.fromX, move.fromY);
+    bool promotes = piece && piece->getType() == PieceType::Pawn && (move.toY == 0 || move.toY == 7);
+    result.promotion = promotes ? std::optional<PieceType>(move.promotion.value_or(PieceType::Queen)) : std::nullopt;
+    return result;
+}
+
+MoveStatus GameTree::play(const MoveCoords& move) {
+    auto inside = [](int v) { return v >= 0 && v < 8; };
+    if (!inside(move.fromX) || !inside(move.fromY) || !inside(move.toX) || !inside(move.toY)) return MoveStatus::OffBoard;
+    MoveCoords played = normalize(move);
+    for (NodeId child : nodes[cursor].children) {
+        const MoveCoords& known = nodes[child].move;
+        if (known.fromX == played.fromX && known.fromY == played.fromY && known.toX == played.toX &&
+            known.toY == played.toY && known.promotion == played.promotion) {
+            goTo(child);
+            return MoveStatus::Ok;
+        }
+    }
+
+    MoveStatus result = live.makeMove(played.fromX, played.fromY, played.toX, played.toY,
+                                      played.promotion.value_or(PieceType::Queen));
+    if (result != MoveStatus::Ok) return result;
+    NodeId id = nodes.size();
+    Node node;
+    node.move = played;
+    node.parent = cursor;
+    node.ply = nodes[cursor].ply + 1;
+    if (node.ply % interval == 0) node.checkpoint = live.getPosition();
+    nodes.push_back(std::move(node));
+    nodes[cursor].children.push_back(id);
+    nodes[cursor].next = id;
+    cursor = id;
+    steps = 1;
+    return MoveStatus::Ok;
+}
+
+size_t GameTree::playLine(const std::vector<MoveCoords>& moves) {
+    for (size_t i = 0; i < moves.size(); ++i) {
+        if (play(moves[i]) != MoveStatus::Ok) return i;
+    }
+    return moves.size();
+}
+
+bool GameTree::undo() {
+    return cursor != kRoot && goTo(nodes[cursor].parent);
+}
+
+bool GameTree::redo() {
+    return nodes[cursor].next != kNone && goTo(nodes[cursor].next);
+}
+
+GameTree::NodeId GameTree::ancestorAt(NodeId node, int ply) const {
+    while (nodes[node].ply > ply) node = nodes[node].parent;
+    return node;
+}
+
+bool GameTree::goToPly(int ply) {
+    if (ply < 0) return false;
+    NodeId target = ancestorAt(cursor, ply);
+    while (nodes[target].ply < ply) {
+        target = nodes[target].next;
+        if (target == kNone) return false;
+    }
+    return goTo(target);
+}
+
+bool GameTree::goTo(NodeId target) {
+    if (target >= nodes.size()) return false;
+    steps = 0;
+    if (target == cursor) return true;
+
+    NodeId a = ancestorAt(cursor, nodes[target].ply);
+    NodeId b = ancestorAt(target, nodes[cursor].ply);
+    while (a != b) {
+        a = nodes[a].parent;
+        b = nodes[b].parent;
+    }
+    const Node& common = nodes[a];
+    // Undo only reaches back to where the live game's history starts.
+    bool canUndo = common.ply >= nodes[base].ply;
+    int undoCost = nodes[cursor].ply - common.ply + nodes[target].ply - common.ply;
+    NodeId checkpoint = ancestorAt(target, nodes[target].ply - nodes[target].ply % interval);
+    int restoreCost = 1 + nodes[target].ply - nodes[checkpoint].ply;
+
+    NodeId from = a;
+    if (canUndo && undoCost <= restoreCost) {
+        for (int i = nodes[cursor].ply; i > common.ply; --i) live.undoMove();
+        steps = nodes[cursor].ply - common.ply;
+    } else {
+        live.setPosition(*nodes[checkpoint].checkpoint);
+        base = checkpoint;
+        from = checkpoint;
+    }
+
+    std::vector<MoveCoords> forward(static_cast<size_t>(nodes[target].ply - nodes[from].ply));
+    for (NodeId node = target; node != from; node = nodes[node].parent) {
+        forward[static_cast<size_t>(nodes[node].ply - nodes[from].ply - 1)] = nodes[node].move;
+    }
+    live.applyMovesUnchecked(forward);
+    steps += static_cast<int>(forward.size());
+
+    // Redo from any node on the way now leads back here.
+    for (NodeId node = target; node != kRoot; node = nodes[node].parent) nodes[nodes[node].parent].next = node;
+    cursor = target;
+    return true;
+}
+
+int GameTree::lineLength() const {
+    NodeId node = cursor;
+    while (nodes[node].next != kNone) node = nodes[node].next;
+    return nodes[node].ply;
+}
+
+std::vector<MoveCoords> GameTree::line() const {
+    NodeId end = cursor;
+    while (nodes[end].next != kNone) end = nodes[end].next;
+    std::vector<MoveCoords> moves(static_cast<size_t>(nodes[end].ply));
+    for (NodeId node = end; node != kRoot; node = nodes[node].parent) {
+        moves[static_cast<size_t>(nodes[node].ply - 1)] = nodes[node].move;
+    }
+    return moves;
+}
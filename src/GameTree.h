@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "Game.h"
+
+// Navigable game record for review: every move ever played from the start position is kept as a
+// node of a variation tree, and the live Game can be moved to any node. Nodes whose ply is a
+// multiple of the checkpoint interval K store the position, so a jump anywhere costs at most K
+// moves replayed after a checkpoint restore, or fewer undo/replay steps when the target is near.
+//
+// The Game's own move history only reaches back to the last checkpoint restored, so its undo,
+// getMoveHistory and repetition count cover that stretch; line() gives the whole game.
+class GameTree {
+public:
+    using NodeId = size_t;
+    static constexpr NodeId kRoot = 0;
+    static constexpr NodeId kNone = static_cast<NodeId>(-1);
+
+    explicit GameTree(int checkpointInterval = 16);
+
+    // Both drop the whole tree and start over from the new position.
+    void start();
+    bool setFen(std::string_view fen);
+
+    // Plays a move from the current node: an existing child with the same move is followed,
+    // otherwise the move is checked like Game::makeMove and added as a new variation.
+    MoveStatus play(const MoveCoords& move);
+    // Plays moves until one is refused; returns how many were played.
+    size_t playLine(const std::vector<MoveCoords>& moves);
+
+    // Back to the parent / forward to the child visited last (the first one played by default).
+    bool undo();
+    bool redo();
+    // Jumps to ply `ply` of the current line: the path from the root to the current node,
+    // continued through the children redo would follow.
+    bool goToPly(int ply);
+    bool goTo(NodeId node);
+
+    const Game& game() const { return live; }
+    GameStatus status() { return live.getStatus(); }
+    NodeId current() const { return cursor; }
+    int ply() const { return nodes[cursor].ply; }
+    // Ply at which the current line ends.
+    int lineLength() const;
+    // Moves of the current line from the start position to its end.
+    std::vector<MoveCoords> line() const;
+
+    size_t size() const { return nodes.size(); }
+    NodeId parent(NodeId node) const { return nodes[node].parent; }
+    const std::vector<NodeId>& children(NodeId node) const { return nodes[node].children; }
+    // The move leading to `node`; meaningless for the root.
+    const MoveCoords& move(NodeId node) const { return nodes[node].move; }
+    // Moves made or taken back by the last navigation, not counting a checkpoint restore.
+    int lastSteps() const { return steps; }
+
+private:
+    struct Node {
+        MoveCoords move;
+        NodeId parent = kNone;
+        int ply = 0;
+        std::vector<NodeId> children;
+        NodeId next = kNone; // child redo follows
+        std::optional<PositionSetup> checkpoint;
+    };
+
+    void reset();
+    NodeId ancestorAt(NodeId node, int ply) const;
+    MoveCoords normalize(const MoveCoords& move) const;
+
+    int interval;
+    Game live;
+    std::vector<Node> nodes;
+    NodeId cursor = kRoot;
+    NodeId base = kRoot; // node the live game's move history starts from
+    int steps = 0;
+};
@@ -0,0 +1,163 @@
+#include "JsonSave.h"
+#include "UciEngine.h"
+#include <algorithm>
+#include <climits>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+// Tracks where in the document a value sits; only the keys of the save schema are recorded.
+class SaveSax : public nlohmann::json_sax<json> {
+public:
+    explicit SaveSax(JsonSaveRecord& record) : record(record) {}
+
+    bool null() override {
+        if (depth == 1 && topKey == "en_passant") record.enPassantX = record.enPassantY = -1;
+        return true;
+    }
+    bool boolean(bool value) override {
+        if (depth == 3 && topKey == "moved" && inBoard()) {
+            record.moved[row][column] = value;
+        }
+        return true;
+    }
+    bool number_integer(number_integer_t value) override { return integer(static_cast<long long>(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return integer(static_cast<long long>(value)); }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& value) override {
+        if (depth == 1) {
+            auto take = [&](std::string& field, bool& present) {
+                field.swap(value);
+                present = true;
+            };
+            if (topKey == "turn") take(record.turn, record.hasTurn);
+            else if (topKey == "fen") take(record.fen, record.hasFen);
+            else if (topKey == "start_fen") take(record.startFen, record.hasStartFen);
+            else if (topKey == "white_name") take(record.whiteName, record.hasWhiteName);
+            else if (topKey == "black_name") take(record.blackName, record.hasBlackName);
+        } else if (depth == 2 && topKey == "moves") {
+            auto move = parseUci(value);
+            if (move) record.moves.push_back(*move);
+            else record.movesValid = false;
+        } else if (depth == 3 && topKey == "board" && inBoard()) {
+            record.board[row][column] = value.empty() ? '.' : value[0];
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        ++depth;
+        return true;
+    }
+    bool key(string_t& value) override {
+        if (depth == 1) topKey = std::move(value);
+        else if (depth == 2) subKey = std::move(value);
+        return true;
+    }
+    bool end_object() override {
+        --depth;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        ++depth;
+        if (depth == 2) {
+            row = -1;
+            if (topKey == "moves") record.hasMoves = true;
+            else if (topKey == "board") record.hasBoard = true;
+            else if (topKey == "moved") record.hasMoved = true;
+        } else if (depth == 3) {
+            ++row;
+            column = -1;
+        }
+        return true;
+    }
+    bool end_array() override {
+        --depth;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override { return false; }
+
+private:
+    // Advances to the next cell of the current row and says whether it is on the board.
+    bool inBoard() {
+        ++column;
+        return row >= 0 && row < 8 && column >= 0 && column < 8;
+    }
+
+    bool integer(long long value) {
+        int clamped = static_cast<int>(std::clamp<long long>(value, INT_MIN, INT_MAX));
+        if (depth == 1) {
+            if (topKey == "move_count") record.moveCount = clamped;
+            else if (topKey == "halfmove_clock") record.halfmoveClock = clamped;
+        } else if (depth == 2 && topKey == "en_passant") {
+            if (subKey == "x") record.enPassantX = clamped;
+            else if (subKey == "y") record.enPassantY = clamped;
+        }
+        return true;
+    }
+
+    JsonSaveRecord& record;
+    int depth = 0;
+    int row = -1, column = -1;
+    std::string topKey, subKey;
+};
+} // namespace
+
+void JsonSaveRecord::clear() {
+    turn.clear();
+    fen.clear();
+    startFen.clear();
+    whiteName.clear();
+    blackName.clear();
+    hasTurn = hasFen = hasStartFen = hasMoves = false;
+    hasWhiteName = hasBlackName = hasBoard = hasMoved = false;
+    moves.clear();
+    movesValid = true;
+    moveCount = 0;
+    halfmoveClock = 0;
+    enPassantX = enPassantY = -1;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            board[y][x] = '.';
+            moved[y][x] = false;
+        }
+    }
+}
+
+bool parseJsonSave(std::string_view text, JsonSaveRecord& record) {
+    record.clear();
+    SaveSax sax(record);
+    return json::sax_parse(text.begin(), text.end(), &sax);
+}
+
+bool parseJsonSave(std::istream& in, JsonSaveRecord& record) {
+    record.clear();
+    SaveSax sax(record);
+    return json::sax_parse(in, &sax);
+}
+
+bool JsonSaveArchiveReader::next(JsonSaveRecord& record) {
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        if (parseJsonSave(line, record)) {
+            ++games;
+            return true;
+        }
+        ++failures;
+    }
+    return false;
+}
+
+bool JsonSaveArchiveReader::next(Game& game) {
+    while (next(scratch)) {
+        if (game.applyJsonSave(scratch)) return true;
+        --games;
+        ++failures;
+    }
+    return false;
+}
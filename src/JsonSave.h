@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Game.h"
+
+// The fields of a JSON save (see Game::saveToFile), filled by a SAX parser straight from the
+// text: no DOM is built, and reusing one record keeps its string and vector allocations.
+struct JsonSaveRecord {
+    std::string turn, fen, startFen, whiteName, blackName;
+    bool hasTurn = false, hasFen = false, hasStartFen = false, hasMoves = false;
+    bool hasWhiteName = false, hasBlackName = false, hasBoard = false, hasMoved = false;
+    std::vector<MoveCoords> moves;
+    bool movesValid = true; // false if any entry of "moves" was not a UCI move
+    int moveCount = 0;
+    int halfmoveClock = 0;
+    int enPassantX = -1, enPassantY = -1;
+    char board[8][8];  // [y][x], piece symbols or '.'
+    bool moved[8][8];
+
+    JsonSaveRecord() { clear(); }
+    void clear();
+};
+
+// Parse one save document; false on malformed JSON. Unknown keys are ignored.
+bool parseJsonSave(std::string_view text, JsonSaveRecord& record);
+bool parseJsonSave(std::istream& in, JsonSaveRecord& record);
+
+// Streams a JSONL archive of saves (one document per line) in constant memory.
+class JsonSaveArchiveReader {
+public:
+    explicit JsonSaveArchiveReader(std::istream& in) : in(in) {}
+
+    // Parses the next save without touching a Game, e.g. to hand records to worker threads.
+    // Blank lines are skipped; malformed lines are counted in errors() and skipped.
+    bool next(JsonSaveRecord& record);
+    // Same, and loads the record into `game`. Records the game cannot use count as errors.
+    bool next(Game& game);
+
+    size_t gamesRead() const { return games; }
+    size_t errors() const { return failures; }
+
+private:
+    std::istream& in;
+    std::string line;
+    JsonSaveRecord scratch;
+    size_t games = 0;
+    size_t failures = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Log-linear histogram in the style of HdrHistogram: every power-of-two range is split into
+// 32 equal sub-buckets, so any recorded value is reproduced within about 3% while the whole
+// 64-bit range fits in a fixed 15 KB table. Recording is a few shifts and an increment, and
+// histograms from different threads merge by adding counts. The unit is up to the caller.
+class LatencyHistogram {
+public:
+    void record(uint64_t value) {
+        ++counts[indexOf(value)];
+        ++total;
+        valueSum += value;
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBuckets; ++i) counts[i] += other.counts[i];
+        total += other.total;
+        valueSum += other.valueSum;
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minimum : 0; }
+    uint64_t max() const { return maximum; }
+    uint64_t sum() const { return valueSum; }
+    double mean() const { return total ? static_cast<double>(valueSum) / static_cast<double>(total) : 0.0; }
+
+    // Smallest recorded value v (to bucket precision) such that a fraction q of samples is <= v.
+    uint64_t percentile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total)));
+        rank = std::clamp<uint64_t>(rank, 1, total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::clamp(upperBound(i), min(), maximum);
+        }
+        return maximum;
+    }
+
+    // Bucket-level access for exporters: buckets() entries, each covering [lowerBound, upperBound].
+    static constexpr size_t buckets() { return kBuckets; }
+    uint64_t bucketCount(size_t index) const { return counts[index]; }
+    static uint64_t lowerBound(size_t index) {
+        if (index < kSubBuckets) return index;
+        unsigned shift = static_cast<unsigned>(index / kHalf) - 1;
+        return static_cast<uint64_t>(index - shift * kHalf) << shift;
+    }
+    static uint64_t upperBound(size_t index) {
+        return index + 1 < kBuckets ? lowerBound(index + 1) - 1 : std::numeric_limits<uint64_t>::max();
+    }
+
+private:
+    static constexpr unsigned kSubBits = 6;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBits;
+    static constexpr size_t kHalf = kSubBuckets / 2;
+    static constexpr size_t kBuckets = (66 - kSubBits) * kHalf;
+
+    static size_t indexOf(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        unsigned msb = 63 - static_cast<unsigned>(countLeadingZeros(value));
+        unsigned shift = msb - kSubBits + 1;
+        return shift * kHalf + static_cast<size_t>(value >> shift);
+    }
+
+    static int countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(value);
+#else
+        int zeros = 0;
+        for (uint64_t bit = uint64_t{1} << 63; !(value & bit); bit >>= 1) ++zeros;
+        return zeros;
+#endif
+    }
+
+    std::array<uint64_t, kBuckets> counts{};
+    uint64_t total = 0;
+    uint64_t valueSum = 0;
+    uint64_t minimum = std::numeric_limits<uint64_t>::max();
+    uint64_t maximum = 0;
+};
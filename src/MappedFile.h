@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// A file mapped into memory. Read-write mappings are shared, so several processes mapping the
+// same file see each other's writes.
+class MappedFile {
+public:
+    enum class Mode { ReadOnly, ReadWrite };
+
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Maps an existing file. In ReadWrite mode the file is created (or grown) to `minSize` bytes first.
+    bool open(const std::string& path, Mode mode, size_t minSize = 0);
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    const unsigned char* data() const { return static_cast<const unsigned char*>(base); }
+    unsigned char* data() { return static_cast<unsigned char*>(base); }
+    size_t size() const { return length; }
+    // Flushes dirty pages of a ReadWrite mapping to disk.
+    void sync();
+
+private:
+    void* base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
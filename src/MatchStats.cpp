@@ -0,0 +1,62 @@
+#include "MatchStats.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+double eloFromScore(double s) {
+    s = std::clamp(s, 1e-6, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / s - 1.0);
+}
+
+double scoreFromElo(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Per-game variance of the score around its mean.
+double scoreVariance(const MatchScore& score) {
+    int n = score.games();
+    if (n == 0) return 0.0;
+    double mu = score.score();
+    return (score.wins * (1.0 - mu) * (1.0 - mu) + score.draws * (0.5 - mu) * (0.5 - mu) + score.losses * mu * mu) / n;
+}
+} // namespace
+
+double MatchScore::score() const {
+    int n = games();
+    return n == 0 ? 0.5 : (wins + 0.5 * draws) / n;
+}
+
+EloEstimate estimateElo(const MatchScore& score) {
+    EloEstimate estimate;
+    int n = score.games();
+    if (n == 0) return estimate;
+
+    double mu = score.score();
+    double stderrScore = std::sqrt(scoreVariance(score) / n);
+    estimate.elo = eloFromScore(mu);
+    estimate.errorMargin = (eloFromScore(mu + 1.96 * stderrScore) - eloFromScore(mu - 1.96 * stderrScore)) / 2.0;
+    int decisive = score.wins + score.losses;
+    if (decisive > 0) {
+        estimate.los = 0.5 * (1.0 + std::erf((score.wins - score.losses) / std::sqrt(2.0 * decisive)));
+    }
+    return estimate;
+}
+
+SprtResult sprt(const MatchScore& score, double elo0, double elo1, double alpha, double beta) {
+    SprtResult result;
+    result.lowerBound = std::log(beta / (1.0 - alpha));
+    result.upperBound = std::log((1.0 - beta) / alpha);
+
+    double variance = scoreVariance(score);
+    if (score.games() == 0 || variance <= 0.0) return result;
+
+    double s0 = scoreFromElo(elo0);
+    double s1 = scoreFromElo(elo1);
+    result.llr = score.games() * (s1 - s0) * (2.0 * score.score() - s0 - s1) / (2.0 * variance);
+    if (result.llr >= result.upperBound) {
+        result.decision = SprtDecision::AcceptH1;
+    } else if (result.llr <= result.lowerBound) {
+        result.decision = SprtDecision::AcceptH0;
+    }
+    return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Win/draw/loss tally from the first player's point of view.
+struct MatchScore {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const; // mean points per game, 0..1
+};
+
+struct EloEstimate {
+    double elo = 0.0;
+    double errorMargin = 0.0; // 95% confidence half-width
+    double los = 0.5;         // likelihood of superiority
+};
+
+EloEstimate estimateElo(const MatchScore& score);
+
+enum class SprtDecision { Continue, AcceptH0, AcceptH1 };
+
+struct SprtResult {
+    double llr = 0.0;
+    double lowerBound = 0.0;
+    double upperBound = 0.0;
+    SprtDecision decision = SprtDecision::Continue;
+};
+
+// Sequential probability ratio test of H0: elo == elo0 against H1: elo == elo1,
+// using the normal approximation of the per-game score distribution.
+SprtResult sprt(const MatchScore& score, double elo0, double elo1, double alpha = 0.05, double beta = 0.05);
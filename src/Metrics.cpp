@@ -0,0 +1,167 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace {
+constexpr size_t kOps = static_cast<size_t>(MetricOp::Count);
+const char* const kNames[kOps] = {"make_move",    "undo_move",      "is_checkmate",     "is_stalemate",
+                                  "save_to_file", "load_from_file", "engine_round_trip"};
+
+struct MetricBlock {
+    LatencyHistogram latency[kOps];
+
+    void merge(const MetricBlock& other) {
+        for (size_t i = 0; i < kOps; ++i) latency[i].merge(other.latency[i]);
+    }
+};
+
+// A thread's block. Only the owner records, so its mutex is uncontended except while a
+// snapshot is being taken.
+struct ThreadMetrics {
+    std::mutex mutex;
+    MetricBlock block;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadMetrics*> live;
+    MetricBlock retired; // totals of threads that have exited
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// Registers the thread's block on first use and folds it into the retired totals at thread exit.
+class ThreadSlot {
+public:
+    ThreadSlot() : owner(registry()) {
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        owner.live.push_back(&metrics);
+    }
+    ~ThreadSlot() {
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        owner.live.erase(std::find(owner.live.begin(), owner.live.end(), &metrics));
+        owner.retired.merge(metrics.block);
+    }
+    ThreadMetrics metrics;
+
+private:
+    Registry& owner;
+};
+
+ThreadMetrics& threadMetrics() {
+    thread_local ThreadSlot slot;
+    return slot.metrics;
+}
+
+MetricBlock collect() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    MetricBlock total = reg.retired;
+    for (ThreadMetrics* metrics : reg.live) {
+        std::lock_guard<std::mutex> threadLock(metrics->mutex);
+        total.merge(metrics->block);
+    }
+    return total;
+}
+
+// Prometheus bucket bounds in nanoseconds: 1-2.5-5 steps from 250 ns to 10 s.
+std::vector<uint64_t> bucketBounds() {
+    std::vector<uint64_t> bounds;
+    for (uint64_t decade = 100; decade <= 1000000000; decade *= 10) {
+        for (uint64_t step : {decade * 5 / 2, decade * 5, decade * 10}) bounds.push_back(step);
+    }
+    return bounds;
+}
+
+std::string seconds(uint64_t nanoseconds) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(nanoseconds) / 1e9);
+    return buffer;
+}
+} // namespace
+
+const char* metricName(MetricOp op) {
+    size_t index = static_cast<size_t>(op);
+    return index < kOps ? kNames[index] : "unknown";
+}
+
+void recordMetric(MetricOp op, uint64_t nanoseconds) {
+#ifdef CHESS_METRICS
+    ThreadMetrics& metrics = threadMetrics();
+    std::lock_guard<std::mutex> lock(metrics.mutex);
+    metrics.block.latency[static_cast<size_t>(op)].record(nanoseconds);
+#else
+    (void)op;
+    (void)nanoseconds;
+#endif
+}
+
+std::vector<OperationMetrics> metricsSnapshot() {
+    MetricBlock total = collect();
+    std::vector<OperationMetrics> result(kOps);
+    for (size_t i = 0; i < kOps; ++i) {
+        result[i].op = static_cast<MetricOp>(i);
+        result[i].name = kNames[i];
+        result[i].latency = total.latency[i];
+    }
+    return result;
+}
+
+void resetMetrics() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.retired = MetricBlock();
+    for (ThreadMetrics* metrics : reg.live) {
+        std::lock_guard<std::mutex> threadLock(metrics->mutex);
+        metrics->block = MetricBlock();
+    }
+}
+
+std::string formatPrometheusMetrics() {
+    static const std::vector<uint64_t> bounds = bucketBounds();
+    std::ostringstream out;
+    out << "# HELP chess_operation_duration_seconds Latency of chess library operations.\n"
+        << "# TYPE chess_operation_duration_seconds histogram\n";
+    for (const auto& metrics : metricsSnapshot()) {
+        const LatencyHistogram& h = metrics.latency;
+        std::string label = std::string("op=\"") + metrics.name + "\"";
+        // Histogram buckets are much finer than the exported ones; each is credited to the first
+        // exported bound at or above its upper edge.
+        size_t bucket = 0;
+        uint64_t cumulative = 0;
+        for (uint64_t bound : bounds) {
+            for (; bucket < LatencyHistogram::buckets() && LatencyHistogram::upperBound(bucket) <= bound; ++bucket) {
+                cumulative += h.bucketCount(bucket);
+            }
+            out << "chess_operation_duration_seconds_bucket{" << label << ",le=\"" << seconds(bound) << "\"} "
+                << cumulative << '\n';
+        }
+        out << "chess_operation_duration_seconds_bucket{" << label << ",le=\"+Inf\"} " << h.count() << '\n'
+            << "chess_operation_duration_seconds_sum{" << label << "} " << seconds(h.sum()) << '\n'
+            << "chess_operation_duration_seconds_count{" << label << "} " << h.count() << '\n';
+    }
+    return out.str();
+}
+
+bool writePrometheusMetrics(const std::string& path) {
+    // Written beside the target and renamed, so a scraper never reads a half-written file.
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out << formatPrometheusMetrics();
+        if (!out) return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (!error) return true;
+    std::filesystem::remove(temp, error);
+    return false;
+}
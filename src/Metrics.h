@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LatencyHistogram.h"
+
+// Library operations with a call counter and a latency histogram each.
+enum class MetricOp { MakeMove, UndoMove, IsCheckmate, IsStalemate, SaveToFile, LoadFromFile, EngineRoundTrip, Count };
+
+struct OperationMetrics {
+    MetricOp op = MetricOp::MakeMove;
+    const char* name = ""; // snake_case, used as the Prometheus label
+    LatencyHistogram latency; // nanoseconds; count() is the number of calls
+};
+
+// True when the library was built with CHESS_METRICS; otherwise nothing is ever recorded.
+constexpr bool metricsEnabled() {
+#ifdef CHESS_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* metricName(MetricOp op);
+
+// Each thread records into its own block, so recording takes no shared lock; these functions
+// combine the blocks of live threads with what exited threads left behind.
+std::vector<OperationMetrics> metricsSnapshot();
+void resetMetrics();
+// Prometheus text exposition: one histogram family with an "op" label, durations in seconds.
+std::string formatPrometheusMetrics();
+bool writePrometheusMetrics(const std::string& path);
+
+void recordMetric(MetricOp op, uint64_t nanoseconds);
+
+#ifdef CHESS_METRICS
+class ScopedMetricTimer {
+public:
+    explicit ScopedMetricTimer(MetricOp op) : op(op), start(std::chrono::steady_clock::now()) {}
+    ~ScopedMetricTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        recordMetric(op, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+    ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+private:
+    MetricOp op;
+    std::chrono::steady_clock::time_point start;
+};
+#define CHESS_METRIC_SCOPE(op) ScopedMetricTimer chessMetricScope(op)
+#else
+#define CHESS_METRIC_SCOPE(op) ((void)0)
+#endif
@@ -9,3 +9,35 @@ int Move::getFromY() const { return fromY; }
 int Move::getToX() const { return toX; }
 int Move::getToY() const { return toY; }
 std::shared_ptr<Piece> Move::getCapturedPiece() const { return capturedPiece; }
+
+uint16_t packMove(const MoveCoords& move) {
+    unsigned promo = 0;
+    if (move.promotion) {
+        switch (*move.promotion) {
+            case PieceType::Knight: promo = 1; break;
+            case PieceType::Bishop: promo = 2; break;
+            case PieceType::Rook: promo = 3; break;
+            case PieceType::Queen: promo = 4; break;
+            default: break;
+        }
+    }
+    unsigned from = static_cast<unsigned>(move.fromY * 8 + move.fromX);
+    unsigned to = static_cast<unsigned>(move.toY * 8 + move.toX);
+    return static_cast<uint16_t>(from | (to << 6) | (promo << 12));
+}
+
+MoveCoords unpackMove(uint16_t packed) {
+    MoveCoords move;
+    move.fromX = packed & 7;
+    move.fromY = (packed >> 3) & 7;
+    move.toX = (packed >> 6) & 7;
+    move.toY = (packed >> 9) & 7;
+    switch ((packed >> 12) & 7) {
+        case 1: move.promotion = PieceType::Knight; break;
+        case 2: move.promotion = PieceType::Bishop; break;
+        case 3: move.promotion = PieceType::Rook; break;
+        case 4: move.promotion = PieceType::Queen; break;
+        default: break;
+    }
+    return move;
+}
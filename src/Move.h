@@ -1,7 +1,20 @@
 #pragma once
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include "Piece.h"
 
+// Plain from/to coordinates of a move, as parsed from input or produced by move generation.
+struct MoveCoords {
+    int fromX = 0, fromY = 0, toX = 0, toY = 0;
+    std::optional<PieceType> promotion;
+};
+
+// 16-bit move encoding for compact storage: from square (6 bits), to square (6 bits),
+// promotion (3 bits: 0 none, 1 knight, 2 bishop, 3 rook, 4 queen). 0 never encodes a real move.
+uint16_t packMove(const MoveCoords& move);
+MoveCoords unpackMove(uint16_t packed);
+
 class Move {
 public:
     Move(Piece* piece, int fromX, int fromY, int toX, int toY, std::shared_ptr<Piece> capturedPiece = nullptr);
@@ -24,7 +37,10 @@ public:
     int enPassantCapturedX = -1, enPassantCapturedY = -1;
     bool promotion = false;
     std::shared_ptr<Piece> promotedFrom;
+    PieceType promotedTo = PieceType::Queen;
     bool hadEnPassantTargetBefore = false;
     int prevEnPassantX = -1, prevEnPassantY = -1;
     bool pieceMovedBefore = false;
+    int prevHalfmoveClock = 0;
+    uint64_t serial = 0; // set by Game, see Game::getMoveSerial
 };
@@ -0,0 +1,170 @@
+#include "MoveJournal.h"
+#include "BinarySave.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr char kMagic[4] = {'2', 'Q', 'K', 'J'};
+constexpr uint16_t kVersion = 1;
+constexpr size_t kHeaderSize = 12;
+constexpr size_t kRecordSize = 4;
+
+uint8_t recordCheck(const uint8_t* record) {
+    return static_cast<uint8_t>(crc32(record, 3));
+}
+
+void encodeRecord(uint8_t* out, char type, uint16_t move) {
+    out[0] = static_cast<uint8_t>(type);
+    out[1] = static_cast<uint8_t>(move & 0xFF);
+    out[2] = static_cast<uint8_t>(move >> 8);
+    out[3] = recordCheck(out);
+}
+
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+} // namespace
+
+MoveJournal::MoveJournal(Options options) : options(options) {}
+
+MoveJournal::~MoveJournal() {
+    close();
+}
+
+bool MoveJournal::recover(const std::string& path, Game& game) {
+    MappedFile mapped;
+    if (!mapped.open(path, MappedFile::Mode::ReadOnly) || mapped.size() < kHeaderSize) return false;
+    const uint8_t* data = mapped.data();
+    if (std::memcmp(data, kMagic, 4) != 0 || (data[4] | data[5] << 8) != kVersion) return false;
+    size_t snapshotSize = static_cast<size_t>(data[8]) | static_cast<size_t>(data[9]) << 8 |
+                          static_cast<size_t>(data[10]) << 16 | static_cast<size_t>(data[11]) << 24;
+    if (snapshotSize > mapped.size() - kHeaderSize) return false;
+
+    Game recovered;
+    if (!decodeBinarySave(recovered, data + kHeaderSize, snapshotSize)) return false;
+    // Moves are replayed with full legality checks: anything that does not fit is a corrupt tail.
+    for (size_t offset = kHeaderSize + snapshotSize; offset + kRecordSize <= mapped.size(); offset += kRecordSize) {
+        const uint8_t* record = data + offset;
+        if (record[3] != recordCheck(record)) break;
+        if (record[0] == 'M') {
+            MoveCoords move = unpackMove(static_cast<uint16_t>(record[1] | record[2] << 8));
+            if (recovered.makeMove(move.fromX, move.fromY, move.toX, move.toY,
+                                   move.promotion.value_or(PieceType::Queen)) != MoveStatus::Ok) {
+                break;
+            }
+        } else if (record[0] == 'U' && recovered.getMoveCount() > 0) {
+            recovered.undoMove();
+        } else {
+            break;
+        }
+    }
+    game = std::move(recovered);
+    return true;
+}
+
+bool MoveJournal::open(const std::string& journalPath, const Game& game) {
+    close();
+    path = journalPath;
+    return compact(game);
+}
+
+bool MoveJournal::append(const uint8_t* data, size_t size) {
+    if (std::fwrite(data, 1, size, file) != size) return false;
+    unsynced += static_cast<int>(size / kRecordSize);
+    if (options.syncEvery > 0 && unsynced >= options.syncEvery) sync();
+    return true;
+}
+
+bool MoveJournal::update(const Game& game) {
+    if (path.empty()) return false;
+    if (!file || game.getStartFen() != startFen || game.getPlayerName(Color::White) != names[0] ||
+        game.getPlayerName(Color::Black) != names[1]) {
+        return compact(game);
+    }
+    // Only the tail can have changed: the deepest ply whose serial still matches ends the common part.
+    size_t length = game.getHistoryLength();
+    size_t common = std::min(length, recorded.size());
+    while (common > 0 && game.getMoveSerial(common - 1) != recorded[common - 1]) --common;
+    size_t changes = (recorded.size() - common) + (length - common);
+    if (changes == 0) return true;
+    if (records + changes > options.compactAfter) return compact(game);
+
+    std::vector<uint8_t> bytes(changes * kRecordSize);
+    uint8_t* out = bytes.data();
+    for (size_t i = recorded.size(); i > common; --i, out += kRecordSize) encodeRecord(out, 'U', 0);
+    recorded.resize(common);
+    for (size_t i = common; i < length; ++i, out += kRecordSize) {
+        recorded.push_back(game.getMoveSerial(i));
+        encodeRecord(out, 'M', packMove(game.getHistoryMove(i)));
+    }
+    records += changes;
+    return append(bytes.data(), bytes.size());
+}
+
+bool MoveJournal::compact(const Game& game) {
+    if (path.empty()) return false;
+    std::vector<uint8_t> snapshot = encodeBinarySave(game);
+    if (snapshot.empty()) return false;
+
+    uint8_t header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, 4);
+    header[4] = static_cast<uint8_t>(kVersion);
+    header[5] = static_cast<uint8_t>(kVersion >> 8);
+    for (int i = 0; i < 4; ++i) header[8 + i] = static_cast<uint8_t>(snapshot.size() >> (8 * i));
+
+    // Write the new journal next to the old one and swap it in, so a crash mid-way keeps one of them.
+    std::string tempPath = path + ".tmp";
+    std::FILE* temp = std::fopen(tempPath.c_str(), "wb");
+    if (!temp) return false;
+    bool written = std::fwrite(header, 1, kHeaderSize, temp) == kHeaderSize &&
+                   std::fwrite(snapshot.data(), 1, snapshot.size(), temp) == snapshot.size() && syncFile(temp);
+    std::fclose(temp);
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    std::error_code error;
+    if (written) std::filesystem::rename(tempPath, path, error);
+    if (!written || error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) return false;
+
+    startFen = game.getStartFen();
+    names[0] = game.getPlayerName(Color::White);
+    names[1] = game.getPlayerName(Color::Black);
+    recorded.clear();
+    for (size_t i = 0; i < game.getHistoryLength(); ++i) recorded.push_back(game.getMoveSerial(i));
+    records = 0;
+    unsynced = 0;
+    return true;
+}
+
+void MoveJournal::sync() {
+    if (file) syncFile(file);
+    unsynced = 0;
+}
+
+void MoveJournal::close() {
+    if (file) {
+        syncFile(file);
+        std::fclose(file);
+        file = nullptr;
+    }
+    path.clear();
+}
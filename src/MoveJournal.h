@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Game.h"
+
+// Append-only game journal for crash-safe autosave.
+//
+//   header    magic "2QKJ", u16 version, u16 reserved, u32 snapshot size
+//   snapshot  a binary save of the game (see BinarySave.h)
+//   records   4 bytes each: type ('M' move, 'U' undo), u16 packed move, check byte
+//
+// Each played or undone move costs one record; the file is rewritten (compacted) into a fresh
+// snapshot once enough records pile up, on a new start position, or when player names change.
+// Recovery replays the records after the snapshot and ignores a torn or corrupt tail.
+class MoveJournal {
+public:
+    struct Options {
+        int syncEvery = 1;          // records between fsyncs; 0 leaves flushing to the OS
+        size_t compactAfter = 512;  // records before the file is rewritten as a snapshot
+    };
+
+    MoveJournal() = default;
+    explicit MoveJournal(Options options);
+    ~MoveJournal();
+    MoveJournal(const MoveJournal&) = delete;
+    MoveJournal& operator=(const MoveJournal&) = delete;
+
+    // Restores `game` from the journal at `path`. Returns false (game untouched) if there is no
+    // journal or its snapshot is unreadable.
+    static bool recover(const std::string& path, Game& game);
+
+    // Starts journaling `game` to `path`, replacing any existing journal with a snapshot.
+    bool open(const std::string& path, const Game& game);
+    // Records whatever changed since the last call: moves played and moves taken back.
+    bool update(const Game& game);
+    // Rewrites the journal as a snapshot of `game`.
+    bool compact(const Game& game);
+    void sync();
+    void close();
+
+    bool isOpen() const { return file != nullptr; }
+    // Records appended since the last snapshot.
+    size_t pendingRecords() const { return records; }
+
+private:
+    bool append(const uint8_t* data, size_t size);
+
+    Options options;
+    std::string path;
+    std::FILE* file = nullptr;
+    std::string startFen;
+    std::string names[2];
+    std::vector<uint64_t> recorded; // serials of the moves journaled, see Game::getMoveSerial
+    size_t records = 0;
+    int unsynced = 0;
+};
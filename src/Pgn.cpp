@@ -0,0 +1,393 @@
+#include "Pgn.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+char pieceLetter(PieceType type) {
+    switch (type) {
+        case PieceType::King: return 'K';
+        case PieceType::Queen: return 'Q';
+        case PieceType::Rook: return 'R';
+        case PieceType::Bishop: return 'B';
+        case PieceType::Knight: return 'N';
+        case PieceType::Pawn: return 'P';
+    }
+    return '?';
+}
+
+void appendSquare(std::string& out, int x, int y) {
+    out.push_back(static_cast<char>('a' + x));
+    out.push_back(static_cast<char>('1' + y));
+}
+
+std::optional<PieceType> pieceFromLetter(char c) {
+    switch (c) {
+        case 'K': return PieceType::King;
+        case 'Q': return PieceType::Queen;
+        case 'R': return PieceType::Rook;
+        case 'B': return PieceType::Bishop;
+        case 'N': return PieceType::Knight;
+        default: return std::nullopt;
+    }
+}
+
+// Whether the move is legal, checked by playing and taking it back.
+bool isLegal(Game& game, const MoveCoords& move) {
+    if (game.makeMove(move.fromX, move.fromY, move.toX, move.toY, move.promotion.value_or(PieceType::Queen)) !=
+        MoveStatus::Ok) {
+        return false;
+    }
+    game.undoMove();
+    return true;
+}
+} // namespace
+
+std::string toSan(Game& game, const MoveCoords& move) {
+    const Board& board = game.getBoard();
+    auto piece = board.getPieceAt(move.fromX, move.fromY);
+    if (!piece) return "";
+
+    std::string san;
+    PieceType type = piece->getType();
+    if (type == PieceType::King && std::abs(move.toX - move.fromX) == 2) {
+        san = (move.toX > move.fromX) ? "O-O" : "O-O-O";
+    } else {
+        bool capture = board.getPieceAt(move.toX, move.toY) != nullptr ||
+                       (type == PieceType::Pawn && move.toX != move.fromX);
+        if (type == PieceType::Pawn) {
+            if (capture) san.push_back(static_cast<char>('a' + move.fromX));
+        } else {
+            san.push_back(pieceLetter(type));
+            // Only other pieces of the same kind that can legally reach the square make it ambiguous.
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    if (x == move.fromX && y == move.fromY) continue;
+                    const auto& other = board.getPieceAt(x, y);
+                    if (!other || other->getType() != type || other->getColor() != piece->getColor()) continue;
+                    if (!isLegal(game, MoveCoords{x, y, move.toX, move.toY, std::nullopt})) continue;
+                    ambiguous = true;
+                    if (x == move.fromX) sameFile = true;
+                    if (y == move.fromY) sameRank = true;
+                }
+            }
+            if (ambiguous) {
+                if (!sameFile) {
+                    san.push_back(static_cast<char>('a' + move.fromX));
+                } else if (!sameRank) {
+                    san.push_back(static_cast<char>('1' + move.fromY));
+                } else {
+                    appendSquare(san, move.fromX, move.fromY);
+                }
+            }
+        }
+        if (capture) san.push_back('x');
+        appendSquare(san, move.toX, move.toY);
+        if (move.promotion) {
+            san.push_back('=');
+            san.push_back(pieceLetter(*move.promotion));
+        }
+    }
+
+    if (game.makeMove(move.fromX, move.fromY, move.toX, move.toY, move.promotion.value_or(PieceType::Queen)) !=
+        MoveStatus::Ok) {
+        return "";
+    }
+    GameStatus status = game.getStatus();
+    if (status == GameStatus::Check) san.push_back('+');
+    else if (status == GameStatus::Checkmate) san.push_back('#');
+    game.undoMove();
+    return san;
+}
+
+std::optional<MoveCoords> parseSan(Game& game, std::string_view san) {
+    while (!san.empty() && std::strchr("+#!?", san.back())) san.remove_suffix(1);
+    if (san.empty()) return std::nullopt;
+
+    int rank = game.isWhiteTurn() ? 0 : 7;
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        MoveCoords castle{4, rank, san.size() == 3 ? 6 : 2, rank, std::nullopt};
+        const auto& king = game.getBoard().getPieceAt(4, rank);
+        if (!king || king->getType() != PieceType::King || !isLegal(game, castle)) return std::nullopt;
+        return castle;
+    }
+
+    PieceType type = PieceType::Pawn;
+    if (auto piece = pieceFromLetter(san.front())) {
+        type = *piece;
+        san.remove_prefix(1);
+    }
+    std::optional<PieceType> promotion;
+    if (type == PieceType::Pawn && san.size() >= 2) {
+        if (auto promo = pieceFromLetter(san.back())) {
+            promotion = promo;
+            san.remove_suffix(san[san.size() - 2] == '=' ? 2 : 1);
+        }
+    }
+    if (san.size() < 2) return std::nullopt;
+    char file = san[san.size() - 2], rankChar = san[san.size() - 1];
+    if (file < 'a' || file > 'h' || rankChar < '1' || rankChar > '8') return std::nullopt;
+    int toX = file - 'a', toY = rankChar - '1';
+
+    // Whatever precedes the destination (minus 'x') narrows the origin square.
+    int fromFile = -1, fromRank = -1;
+    for (char c : san.substr(0, san.size() - 2)) {
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != ':' && c != '-') return std::nullopt;
+    }
+    if (type == PieceType::Pawn && fromFile < 0) fromFile = toX;
+
+    const Board& board = game.getBoard();
+    Color color = game.getCurrentPlayer();
+    std::optional<MoveCoords> found;
+    for (int y = 0; y < 8; ++y) {
+        if (fromRank >= 0 && y != fromRank) continue;
+        for (int x = 0; x < 8; ++x) {
+            if (fromFile >= 0 && x != fromFile) continue;
+            const auto& piece = board.getPieceAt(x, y);
+            if (!piece || piece->getType() != type || piece->getColor() != color) continue;
+            MoveCoords candidate{x, y, toX, toY, promotion};
+            if (!isLegal(game, candidate)) continue;
+            if (found) return std::nullopt; // ambiguous
+            found = candidate;
+        }
+    }
+    return found;
+}
+
+void writePgn(std::ostream& out, const PgnGame& game) {
+    for (const auto& tag : game.tags) {
+        out << '[' << tag.first << " \"";
+        for (char c : tag.second) {
+            if (c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+        out << "\"]\n";
+    }
+    out << '\n';
+
+    std::string line;
+    auto emit = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 80) {
+            out << line << '\n';
+            line.clear();
+        }
+        if (!line.empty()) line.push_back(' ');
+        line += token;
+    };
+
+    int number = game.firstMoveNumber;
+    bool white = !game.blackMovesFirst;
+    bool afterAnnotation = false;
+    for (size_t i = 0; i < game.sanMoves.size(); ++i) {
+        if (white) {
+            emit(std::to_string(number) + ". " + game.sanMoves[i]);
+        } else {
+            // Black's move needs its number again when a comment separates it from White's.
+            if (i == 0 || afterAnnotation) emit(std::to_string(number) + "...");
+            emit(game.sanMoves[i]);
+            ++number;
+        }
+        white = !white;
+        afterAnnotation = i < game.moveAnnotations.size() && !game.moveAnnotations[i].empty();
+        if (afterAnnotation) emit(game.moveAnnotations[i]);
+    }
+    emit(game.result);
+    out << line << "\n\n";
+}
+
+PgnGame toPgnGame(const Game& game, const std::string& result) {
+    PgnGame pgn;
+    pgn.result = result;
+    pgn.tags = {
+        {"Event", "?"},
+        {"Site", "?"},
+        {"Date", "????.??.??"},
+        {"Round", "-"},
+        {"White", game.getPlayerName(Color::White)},
+        {"Black", game.getPlayerName(Color::Black)},
+        {"Result", result},
+    };
+
+    Game replay;
+    replay.start();
+    if (game.getStartFen() != replay.fen()) {
+        replay.setFen(game.getStartFen());
+        pgn.tags.emplace_back("SetUp", "1");
+        pgn.tags.emplace_back("FEN", game.getStartFen());
+    }
+    pgn.blackMovesFirst = !replay.isWhiteTurn();
+    pgn.firstMoveNumber = replay.getMoveCount() / 2 + 1;
+
+    for (const auto& move : game.getMoveHistory()) {
+        std::string san = toSan(replay, move);
+        if (san.empty()) break;
+        pgn.sanMoves.push_back(std::move(san));
+        replay.makeMove(move.fromX, move.fromY, move.toX, move.toY, move.promotion.value_or(PieceType::Queen));
+    }
+    return pgn;
+}
+
+bool replayPgn(Game& game, const PgnGame& pgn) {
+    game.start();
+    for (const auto& tag : pgn.tags) {
+        if (tag.first == "FEN" && !game.setFen(tag.second)) return false;
+        if (tag.first == "White") game.setPlayerName(Color::White, tag.second);
+        if (tag.first == "Black") game.setPlayerName(Color::Black, tag.second);
+    }
+    for (const auto& san : pgn.sanMoves) {
+        auto move = parseSan(game, san);
+        if (!move || game.makeMove(move->fromX, move->fromY, move->toX, move->toY,
+                                   move->promotion.value_or(PieceType::Queen)) != MoveStatus::Ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PgnReader::PgnReader(std::istream& in, size_t bufferSize) : in(in), buffer(std::max<size_t>(bufferSize, 16)) {}
+
+bool PgnReader::refill() {
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    pos = 0;
+    end = static_cast<size_t>(in.gcount());
+    return end > 0;
+}
+
+int PgnReader::peek() {
+    if (pos == end && !refill()) return -1;
+    return static_cast<unsigned char>(buffer[pos]);
+}
+
+int PgnReader::get() {
+    int c = peek();
+    if (c >= 0) ++pos;
+    return c;
+}
+
+void PgnReader::skipUntil(char terminator) {
+    while (true) {
+        if (pos == end && !refill()) return;
+        const void* hit = std::memchr(buffer.data() + pos, terminator, end - pos);
+        if (hit) {
+            pos = static_cast<size_t>(static_cast<const char*>(hit) - buffer.data()) + 1;
+            return;
+        }
+        pos = end;
+    }
+}
+
+void PgnReader::readTag(PgnGame& game) {
+    std::string name;
+    int c;
+    while ((c = get()) >= 0 && c != ']' && c != '"') {
+        if (!std::isspace(c)) name.push_back(static_cast<char>(c));
+    }
+    std::string value;
+    if (c == '"') {
+        while ((c = get()) >= 0 && c != '"') {
+            if (c == '\\') c = get();
+            if (c >= 0) value.push_back(static_cast<char>(c));
+        }
+        skipUntil(']');
+    }
+    if (name == "FEN") {
+        Game setup;
+        if (setup.setFen(value)) {
+            game.blackMovesFirst = !setup.isWhiteTurn();
+            game.firstMoveNumber = setup.getMoveCount() / 2 + 1;
+        }
+    }
+    game.tags.emplace_back(std::move(name), std::move(value));
+}
+
+void PgnReader::skipVariation() {
+    int depth = 1;
+    int c;
+    while (depth > 0 && (c = get()) >= 0) {
+        if (c == '(') ++depth;
+        else if (c == ')') --depth;
+        else if (c == '{') skipUntil('}');
+        else if (c == ';') skipUntil('\n');
+    }
+}
+
+bool PgnReader::next(PgnGame& game) {
+    game.tags.clear();
+    game.sanMoves.clear();
+    game.moveAnnotations.clear();
+    game.result = "*";
+    game.firstMoveNumber = 1;
+    game.blackMovesFirst = false;
+
+    bool inMovetext = false;
+    bool lineStart = true;
+    while (true) {
+        int c = peek();
+        if (c < 0) break;
+        if (c == '\n') {
+            ++pos;
+            lineStart = true;
+            continue;
+        }
+        if (std::isspace(c)) {
+            ++pos;
+            continue;
+        }
+        bool atLineStart = lineStart;
+        lineStart = false;
+        if (c == '%' && atLineStart) {
+            skipUntil('\n');
+            lineStart = true;
+        } else if (c == '[') {
+            // A tag after movetext belongs to the next game (this one had no result token).
+            if (inMovetext) break;
+            ++pos;
+            readTag(game);
+        } else if (c == '{') {
+            ++pos;
+            skipUntil('}');
+        } else if (c == ';') {
+            skipUntil('\n');
+            lineStart = true;
+        } else if (c == '(') {
+            ++pos;
+            skipVariation();
+        } else if (c == ')' || c == ']' || c == '}') {
+            ++pos;
+        } else {
+            token.clear();
+            // c != 0: strchr would match the terminator of the delimiter list.
+            while ((c = peek()) >= 0 && !std::isspace(c) && (c == 0 || !std::strchr("{}()[];", c))) {
+                token.push_back(static_cast<char>(c));
+                ++pos;
+            }
+            if (token.empty()) {
+                ++pos; // never stall on a byte no branch above consumes
+                continue;
+            }
+            inMovetext = true;
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                game.result = token;
+                break;
+            }
+            if (token[0] == '$') continue;
+            std::string_view move(token);
+            if (move[0] >= '1' && move[0] <= '9') {
+                // Move number, possibly glued to the move itself ("12.Nf3", "12...Nf6").
+                size_t skip = move.find_first_not_of("0123456789");
+                if (skip == std::string_view::npos || move[skip] != '.') continue;
+                skip = move.find_first_not_of('.', skip);
+                if (skip == std::string_view::npos) continue;
+                move.remove_prefix(skip);
+            }
+            game.sanMoves.emplace_back(move);
+        }
+    }
+    if (!inMovetext && game.tags.empty()) return false;
+    ++games;
+    return true;
+}
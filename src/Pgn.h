@@ -0,0 +1,64 @@
+#pragma once
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Game.h"
+
+// Standard Algebraic Notation of a legal move in the current position (e.g. "Nbd2", "exd6", "O-O", "e8=Q#").
+std::string toSan(Game& game, const MoveCoords& move);
+// Resolves a SAN move (check marks and !? suffixes allowed, "0-0" accepted) against the current
+// position. Returns nothing if it matches no legal move or more than one.
+std::optional<MoveCoords> parseSan(Game& game, std::string_view san);
+
+struct PgnGame {
+    std::vector<std::pair<std::string, std::string>> tags; // in output order
+    std::vector<std::string> sanMoves;
+    // Optional, parallel to sanMoves: NAGs and/or {comments} written after each move.
+    std::vector<std::string> moveAnnotations;
+    std::string result = "*";
+    int firstMoveNumber = 1;
+    bool blackMovesFirst = false;
+};
+
+// Writes one game: tag pairs, a blank line, movetext wrapped at 80 columns, and a blank line.
+void writePgn(std::ostream& out, const PgnGame& game);
+
+// Builds the PGN record of `game` from its start position and move history, with the seven tag
+// roster plus SetUp/FEN when the game does not start from the initial position.
+PgnGame toPgnGame(const Game& game, const std::string& result = "*");
+
+// Sets up `game` from the FEN tag (or the initial position) and plays the SAN moves.
+// Stops at the first move that cannot be resolved and returns false.
+bool replayPgn(Game& game, const PgnGame& pgn);
+
+// Reads games one at a time from a stream through a fixed-size buffer, so arbitrarily large
+// files are processed in constant memory. Comments, variations, NAGs and escape lines are skipped.
+class PgnReader {
+public:
+    explicit PgnReader(std::istream& in, size_t bufferSize = 1 << 16);
+
+    // Fills `game` with the next game; false at end of input. Reusing the same PgnGame keeps
+    // its allocations.
+    bool next(PgnGame& game);
+    // Number of games returned so far.
+    size_t gamesRead() const { return games; }
+
+private:
+    int peek();
+    int get();
+    bool refill();
+    void skipUntil(char terminator);
+    void readTag(PgnGame& game);
+    void skipVariation();
+
+    std::istream& in;
+    std::vector<char> buffer;
+    size_t pos = 0;
+    size_t end = 0;
+    size_t games = 0;
+    std::string token;
+};
@@ -36,7 +36,7 @@ public:
             case PieceType::Queen: symbol = 'Q'; break;
             case PieceType::King: symbol = 'K'; break;
         }
-        return (color == Color::White) ? std::toupper(symbol) : std::tolower(symbol);
+        return (color == Color::White) ? symbol : static_cast<char>(symbol - 'A' + 'a');
     }
 
     static std::shared_ptr<Piece> createFromSymbol(char symbol, int x, int y);
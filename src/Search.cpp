@@ -0,0 +1,145 @@
+#include "Search.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+int pieceValue(PieceType type) {
+    switch (type) {
+        case PieceType::Pawn: return 100;
+        case PieceType::Knight: return 320;
+        case PieceType::Bishop: return 330;
+        case PieceType::Rook: return 500;
+        case PieceType::Queen: return 900;
+        case PieceType::King: return 0;
+    }
+    return 0;
+}
+
+// Small positional terms: centralize minor pieces, push pawns.
+int placementBonus(PieceType type, Color color, int x, int y) {
+    int rank = (color == Color::White) ? y : 7 - y;
+    int center = 6 - static_cast<int>(std::abs(2 * x - 7) + std::abs(2 * y - 7)) / 2;
+    switch (type) {
+        case PieceType::Pawn: return rank * 8 + ((x == 3 || x == 4) ? rank * 4 : 0);
+        case PieceType::Knight: return center * 8;
+        case PieceType::Bishop: return center * 5;
+        case PieceType::Queen: return center * 2;
+        default: return 0;
+    }
+}
+
+bool sameMove(const MoveCoords& a, const MoveCoords& b) {
+    return a.fromX == b.fromX && a.fromY == b.fromY && a.toX == b.toX && a.toY == b.toY && a.promotion == b.promotion;
+}
+
+} // namespace
+
+void Searcher::play(Game& game, const MoveCoords& mv) {
+    game.playMove(mv.fromX, mv.fromY, mv.toX, mv.toY, mv.promotion.value_or(PieceType::Queen));
+}
+
+void Searcher::takeBack(Game& game) {
+    game.takeBackMove();
+}
+
+int Searcher::evaluate(const Game& game) {
+    const Board& board = game.getBoard();
+    int score = 0;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            auto piece = board.getPieceAt(x, y);
+            if (!piece) continue;
+            int value = pieceValue(piece->getType()) + placementBonus(piece->getType(), piece->getColor(), x, y);
+            score += (piece->getColor() == Color::White) ? value : -value;
+        }
+    }
+    return game.isWhiteTurn() ? score : -score;
+}
+
+SearchResult Searcher::search(Game& game, const SearchLimits& limits) {
+    nodes = 0;
+    nodeLimit = limits.nodes;
+    hasDeadline = limits.movetimeMs > 0;
+    if (hasDeadline) deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.movetimeMs);
+    stopped = false;
+    previousBest.reset();
+
+    int maxDepth = limits.depth > 0 ? limits.depth : (limits.nodes > 0 || hasDeadline ? 64 : 3);
+    SearchResult result;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        rootBest.reset();
+        int score = negamax(game, depth, -kMateScore - 1, kMateScore + 1, 0);
+        if (stopped && result.best) break;
+        result.best = rootBest;
+        result.score = score;
+        result.depth = depth;
+        previousBest = rootBest;
+        if (onIteration) {
+            result.nodes = nodes;
+            onIteration(result);
+        }
+        if (stopped || !rootBest || std::abs(score) >= kMateScore - 100) break;
+    }
+    if (!result.best) {
+        // Budget ran out before the first iteration finished; any legal move beats none.
+        auto moves = game.getLegalMoves();
+        if (!moves.empty()) {
+            orderMoves(game, moves);
+            result.best = moves.front();
+        }
+    }
+    result.nodes = nodes;
+    return result;
+}
+
+bool Searcher::outOfBudget() {
+    if (nodeLimit > 0 && nodes >= nodeLimit) stopped = true;
+    if (hasDeadline && (nodes & 1023) == 0 && std::chrono::steady_clock::now() >= deadline) stopped = true;
+    return stopped;
+}
+
+void Searcher::orderMoves(const Game& game, std::vector<MoveCoords>& moves) const {
+    const Board& board = game.getBoard();
+    auto key = [&](const MoveCoords& mv) {
+        int k = 0;
+        if (auto victim = board.getPieceAt(mv.toX, mv.toY)) {
+            auto attacker = board.getPieceAt(mv.fromX, mv.fromY);
+            k += 10 * pieceValue(victim->getType()) - (attacker ? pieceValue(attacker->getType()) / 10 : 0);
+        }
+        if (mv.promotion) k += pieceValue(*mv.promotion);
+        return k;
+    };
+    std::stable_sort(moves.begin(), moves.end(), [&](const MoveCoords& a, const MoveCoords& b) { return key(a) > key(b); });
+}
+
+int Searcher::negamax(Game& game, int depth, int alpha, int beta, int ply) {
+    ++nodes;
+    if (ply > 0 && outOfBudget()) return 0;
+
+    auto moves = game.getLegalMoves();
+    if (moves.empty()) {
+        return game.isInCheck(game.getCurrentPlayer()) ? -kMateScore + ply : 0;
+    }
+    if (depth == 0) return evaluate(game);
+
+    orderMoves(game, moves);
+    if (ply == 0 && previousBest) {
+        auto it = std::find_if(moves.begin(), moves.end(), [&](const MoveCoords& m) { return sameMove(m, *previousBest); });
+        if (it != moves.end()) std::rotate(moves.begin(), it, it + 1);
+    }
+
+    int best = -kMateScore - 1;
+    for (const auto& mv : moves) {
+        play(game, mv);
+        int score = -negamax(game, depth - 1, -beta, -alpha, ply + 1);
+        takeBack(game);
+        if (stopped) return best;
+        if (score > best) {
+            best = score;
+            if (ply == 0) rootBest = mv;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) break;
+    }
+    return best;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "Game.h"
+#include "UciEngine.h"
+
+struct SearchResult {
+    std::optional<MoveCoords> best;
+    int score = 0; // centipawns from the side to move's point of view
+    int depth = 0; // last completed iteration
+    long long nodes = 0;
+};
+
+// Built-in engine: iterative-deepening alpha-beta over Game with a material and
+// piece-square evaluation. Honors depth, nodes and movetime limits (MultiPV is ignored).
+class Searcher {
+public:
+    static constexpr int kMateScore = 100000;
+
+    SearchResult search(Game& game, const SearchLimits& limits);
+    // Called after every completed iteration with the result so far.
+    void setIterationCallback(std::function<void(const SearchResult&)> callback) { onIteration = std::move(callback); }
+    // Static evaluation from the side to move's point of view.
+    static int evaluate(const Game& game);
+
+private:
+    int negamax(Game& game, int depth, int alpha, int beta, int ply);
+    void orderMoves(const Game& game, std::vector<MoveCoords>& moves) const;
+    bool outOfBudget();
+    // Unmetered makeMove/undoMove (Game befriends Searcher for these).
+    static void play(Game& game, const MoveCoords& mv);
+    static void takeBack(Game& game);
+
+    long long nodes = 0;
+    long long nodeLimit = 0;
+    bool hasDeadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    bool stopped = false;
+    std::optional<MoveCoords> rootBest;
+    std::optional<MoveCoords> previousBest;
+    std::function<void(const SearchResult&)> onIteration;
+};
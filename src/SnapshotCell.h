@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Single-writer cell publishing immutable values to any number of lock-free readers, RCU style.
+// The writer swaps in a new value with one atomic exchange; readers copy out a shared_ptr, which
+// keeps their value alive for as long as they hold it.
+//
+// The cell owns a heap shared_ptr per published value. A reader registers in one of two reader
+// counters (picked by the current epoch) around loading that pointer and copying the shared_ptr
+// out of it. A replaced holder is retired, and freed once each counter has been seen at zero
+// after the retirement: a reader that could still hold it was counted at the swap and has left.
+// The writer flips the epoch on every store, so new readers land on the other counter and the old
+// one drains. Nobody waits and nothing locks; the retire list is empty whenever reads are quiet.
+//
+// store() must only be called by one thread at a time; load() from any thread.
+template <typename T>
+class SnapshotCell {
+public:
+    static_assert(std::atomic<int>::is_always_lock_free && std::atomic<unsigned>::is_always_lock_free,
+                  "SnapshotCell needs lock-free atomics");
+
+    SnapshotCell() = default;
+    // Copies publish the source's current value; readers of the source are not affected.
+    SnapshotCell(const SnapshotCell& other) { store(other.load()); }
+    SnapshotCell& operator=(const SnapshotCell& other) {
+        if (this != &other) store(other.load());
+        return *this;
+    }
+    ~SnapshotCell() {
+        delete current.load();
+        for (const Retired& old : retired) delete old.holder;
+    }
+
+    std::shared_ptr<const T> load() const {
+        std::atomic<int>& counter = readers[epoch.load() & 1];
+        counter.fetch_add(1);
+        const Holder* holder = current.load();
+        std::shared_ptr<const T> value = holder ? *holder : nullptr;
+        counter.fetch_sub(1);
+        return value;
+    }
+
+    void store(std::shared_ptr<const T> value) {
+        const Holder* next = value ? new Holder(std::move(value)) : nullptr;
+        if (const Holder* old = current.exchange(next)) retired.push_back(Retired{old, {false, false}});
+        epoch.fetch_add(1);
+        reclaim();
+    }
+
+private:
+    using Holder = std::shared_ptr<const T>;
+    struct Retired {
+        const Holder* holder;
+        bool drained[2];
+    };
+
+    void reclaim() {
+        if (retired.empty()) return;
+        for (int parity = 0; parity < 2; ++parity) {
+            if (readers[parity].load() != 0) continue;
+            for (Retired& old : retired) old.drained[parity] = true;
+        }
+        auto done = std::partition(retired.begin(), retired.end(),
+                                   [](const Retired& old) { return !(old.drained[0] && old.drained[1]); });
+        for (auto it = done; it != retired.end(); ++it) delete it->holder;
+        retired.erase(done, retired.end());
+    }
+
+    std::atomic<const Holder*> current{nullptr};
+    mutable std::atomic<int> readers[2]{};
+    std::atomic<unsigned> epoch{0};
+    std::vector<Retired> retired; // writer only
+};
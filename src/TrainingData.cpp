@@ -0,0 +1,142 @@
+#include "TrainingData.h"
+#include "BinarySave.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr char kMagic[4] = {'2', 'Q', 'K', 'T'};
+constexpr size_t kShardHeaderSize = 8;
+} // namespace
+
+bool encodeTrainingRecord(const TrainingRecord& record, uint8_t* out) {
+    if (!packPosition(record.position, out)) return false;
+    auto score = static_cast<uint16_t>(static_cast<int16_t>(std::clamp(record.score, -32767, 32767)));
+    out[32] = static_cast<uint8_t>(score & 0xFF);
+    out[33] = static_cast<uint8_t>(score >> 8);
+    out[34] = static_cast<uint8_t>(static_cast<int8_t>(std::clamp(record.result, -1, 1)));
+    out[35] = static_cast<uint8_t>(std::clamp(record.ply, 0, 255));
+    return true;
+}
+
+bool decodeTrainingRecord(const uint8_t* in, TrainingRecord& record) {
+    if (!unpackPosition(in, record.position)) return false;
+    record.score = static_cast<int16_t>(in[32] | in[33] << 8);
+    record.result = static_cast<int8_t>(in[34]);
+    record.ply = in[35];
+    return true;
+}
+
+bool readTrainingShard(const std::string& path, std::vector<TrainingRecord>& records) {
+    MappedFile file;
+    if (!file.open(path, MappedFile::Mode::ReadOnly) || file.size() < kShardHeaderSize) return false;
+    const uint8_t* data = file.data();
+    if (std::memcmp(data, kMagic, 4) != 0 || (data[4] | data[5] << 8) != kTrainingDataVersion ||
+        (data[6] | data[7] << 8) != kTrainingRecordSize) {
+        return false;
+    }
+    size_t count = (file.size() - kShardHeaderSize) / kTrainingRecordSize;
+    records.reserve(records.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        TrainingRecord record;
+        if (!decodeTrainingRecord(data + kShardHeaderSize + i * kTrainingRecordSize, record)) return false;
+        records.push_back(record);
+    }
+    return true;
+}
+
+bool PositionDeduper::insert(uint64_t hash) {
+    // The low bits pick the bucket inside the set; take the stripe from the top.
+    Stripe& stripe = stripes[hash >> 58];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    return stripe.hashes.insert(hash).second;
+}
+
+void PositionDeduper::erase(uint64_t hash) {
+    Stripe& stripe = stripes[hash >> 58];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.hashes.erase(hash);
+}
+
+size_t PositionDeduper::size() const {
+    size_t total = 0;
+    for (const auto& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        total += stripe.hashes.size();
+    }
+    return total;
+}
+
+TrainingDataWriter::TrainingDataWriter(std::string prefix, size_t recordsPerShard)
+    : prefix(std::move(prefix)), recordsPerShard(std::max<size_t>(1, recordsPerShard)) {}
+
+TrainingDataWriter::~TrainingDataWriter() {
+    close();
+}
+
+std::string TrainingDataWriter::shardPath(const std::string& prefix, size_t index) {
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "-%05zu.bin", index);
+    return prefix + suffix;
+}
+
+bool TrainingDataWriter::openShard() {
+    if (shard) std::fclose(shard);
+    shard = std::fopen(shardPath(prefix, shards).c_str(), "wb");
+    if (!shard) return false;
+    ++shards;
+    inShard = 0;
+    uint8_t header[kShardHeaderSize];
+    std::memcpy(header, kMagic, 4);
+    header[4] = static_cast<uint8_t>(kTrainingDataVersion & 0xFF);
+    header[5] = static_cast<uint8_t>(kTrainingDataVersion >> 8);
+    header[6] = static_cast<uint8_t>(kTrainingRecordSize);
+    header[7] = 0;
+    return std::fwrite(header, 1, sizeof(header), shard) == sizeof(header);
+}
+
+bool TrainingDataWriter::write(const std::vector<TrainingRecord>& records) {
+    std::vector<uint8_t> bytes(records.size() * kTrainingRecordSize);
+    size_t count = 0;
+    for (const auto& record : records) {
+        if (encodeTrainingRecord(record, bytes.data() + count * kTrainingRecordSize)) ++count;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t done = 0; done < count && !failed;) {
+        if (!shard || inShard == recordsPerShard) {
+            if (!openShard()) {
+                failed = true;
+                break;
+            }
+        }
+        size_t chunk = std::min(count - done, recordsPerShard - inShard);
+        size_t size = chunk * kTrainingRecordSize;
+        if (std::fwrite(bytes.data() + done * kTrainingRecordSize, 1, size, shard) != size) {
+            failed = true;
+            break;
+        }
+        inShard += chunk;
+        written += chunk;
+        done += chunk;
+    }
+    return !failed;
+}
+
+void TrainingDataWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (shard) {
+        std::fclose(shard);
+        shard = nullptr;
+    }
+}
+
+size_t TrainingDataWriter::recordsWritten() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return written;
+}
+
+size_t TrainingDataWriter::shardCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shards;
+}
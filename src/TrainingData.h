@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Game.h"
+
+// Packed training positions for fitting evaluation parameters. All integers are little endian.
+//
+//   shard header  magic "2QKT", u16 version, u16 record size
+//   record        packed position (32 bytes, see BinarySave.h), i16 score in centipawns, i8 result
+//                 (1 win, 0 draw, -1 loss), u8 ply capped at 255
+//
+// Score and result are from the side to move's point of view.
+constexpr size_t kTrainingRecordSize = 36;
+constexpr uint16_t kTrainingDataVersion = 1;
+
+struct TrainingRecord {
+    PositionSetup position;
+    int score = 0;
+    int result = 0;
+    int ply = 0;
+};
+
+bool encodeTrainingRecord(const TrainingRecord& record, uint8_t* out);
+bool decodeTrainingRecord(const uint8_t* in, TrainingRecord& record);
+// Reads a whole shard; false if it is missing or not a training shard.
+bool readTrainingShard(const std::string& path, std::vector<TrainingRecord>& records);
+
+// Set of position hashes shared by all workers, lock-striped so they rarely wait on each other.
+class PositionDeduper {
+public:
+    // True if `hash` was not seen before.
+    bool insert(uint64_t hash);
+    // Forgets `hash` again, e.g. when the game that claimed it was thrown away.
+    void erase(uint64_t hash);
+    size_t size() const;
+
+private:
+    static constexpr size_t kStripes = 64;
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_set<uint64_t> hashes;
+    };
+    Stripe stripes[kStripes];
+};
+
+// Appends records to <prefix>-00000.bin, <prefix>-00001.bin, ..., starting a new shard every
+// `recordsPerShard` records. Safe to call from several threads; records are encoded before the lock.
+class TrainingDataWriter {
+public:
+    TrainingDataWriter(std::string prefix, size_t recordsPerShard);
+    ~TrainingDataWriter();
+    TrainingDataWriter(const TrainingDataWriter&) = delete;
+    TrainingDataWriter& operator=(const TrainingDataWriter&) = delete;
+
+    bool write(const std::vector<TrainingRecord>& records);
+    void close();
+
+    size_t recordsWritten() const;
+    size_t shardCount() const;
+    static std::string shardPath(const std::string& prefix, size_t index);
+
+private:
+    bool openShard();
+
+    std::string prefix;
+    size_t recordsPerShard;
+    mutable std::mutex mutex;
+    std::FILE* shard = nullptr;
+    size_t shards = 0;
+    size_t inShard = 0;
+    size_t written = 0;
+    bool failed = false;
+};
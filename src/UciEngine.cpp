@@ -0,0 +1,545 @@
+#include "UciEngine.h"
+#include "EvalCache.h"
+#include "Game.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+std::string toUci(const MoveCoords& move) {
+    std::string m;
+    m.push_back(static_cast<char>('a' + move.fromX));
+    m.push_back(static_cast<char>('1' + move.fromY));
+    m.push_back(static_cast<char>('a' + move.toX));
+    m.push_back(static_cast<char>('1' + move.toY));
+    if (move.promotion.has_value()) {
+        char c = 'q';
+        switch (*move.promotion) {
+            case PieceType::Queen: c = 'q'; break;
+            case PieceType::Rook: c = 'r'; break;
+            case PieceType::Bishop: c = 'b'; break;
+            case PieceType::Knight: c = 'n'; break;
+            default: break;
+        }
+        m.push_back(c);
+    }
+    return m;
+}
+
+std::optional<MoveCoords> parseUci(std::string_view text) {
+    if (text.size() < 4) return std::nullopt;
+    MoveCoords mv;
+    mv.fromX = text[0] - 'a';
+    mv.fromY = text[1] - '1';
+    mv.toX = text[2] - 'a';
+    mv.toY = text[3] - '1';
+    for (int v : {mv.fromX, mv.fromY, mv.toX, mv.toY}) {
+        if (v < 0 || v > 7) return std::nullopt;
+    }
+    if (text.size() >= 5) {
+        char p = static_cast<char>(std::tolower(static_cast<unsigned char>(text[4])));
+        switch (p) {
+            case 'q': mv.promotion = PieceType::Queen; break;
+            case 'r': mv.promotion = PieceType::Rook; break;
+            case 'b': mv.promotion = PieceType::Bishop; break;
+            case 'n': mv.promotion = PieceType::Knight; break;
+            default: break;
+        }
+    }
+    return mv;
+}
+
+UciEngine::~UciEngine() {
+    stop();
+}
+
+bool UciEngine::start(const std::string& path, int skillLevel) {
+    if (running) stop();
+    endOfStream = false;
+    timedOut = false;
+    readDeadline.reset();
+    bufferPos = bufferLen = 0;
+    partialLine.clear();
+    multiPv = 1;
+#ifdef _WIN32
+    SECURITY_ATTRIBUTES saAttr{};
+    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+    saAttr.bInheritHandle = TRUE;
+    saAttr.lpSecurityDescriptor = nullptr;
+
+    HANDLE outRd = nullptr, outWr = nullptr, inRd = nullptr, inWr = nullptr;
+    if (!CreatePipe(&outRd, &outWr, &saAttr, 0)) return false;
+    if (!SetHandleInformation(outRd, HANDLE_FLAG_INHERIT, 0)) return false;
+    if (!CreatePipe(&inRd, &inWr, &saAttr, 0)) return false;
+    if (!SetHandleInformation(inWr, HANDLE_FLAG_INHERIT, 0)) return false;
+
+    STARTUPINFOA si{};
+    si.cb = sizeof(STARTUPINFOA);
+    si.hStdError = outWr;
+    si.hStdOutput = outWr;
+    si.hStdInput = inRd;
+    si.dwFlags |= STARTF_USESTDHANDLES;
+
+    PROCESS_INFORMATION pi{};
+    std::string cmd = "\"" + path + "\"";
+    BOOL success = CreateProcessA(
+        nullptr,
+        cmd.data(),
+        nullptr,
+        nullptr,
+        TRUE,
+        0,
+        nullptr,
+        nullptr,
+        &si,
+        &pi);
+
+    if (!success) {
+        CloseHandle(outRd);
+        CloseHandle(outWr);
+        CloseHandle(inRd);
+        CloseHandle(inWr);
+        return false;
+    }
+    // Only the child keeps these ends, so its exit closes the pipe and reads see end of stream.
+    CloseHandle(outWr);
+    CloseHandle(inRd);
+    childStdoutRd = outRd;
+    childStdinWr = inWr;
+    processHandle = pi.hProcess;
+    threadHandle = pi.hThread;
+    running = true;
+#else
+    int stdinPipe[2];
+    int stdoutPipe[2];
+    if (pipe(stdinPipe) != 0) return false;
+    if (pipe(stdoutPipe) != 0) {
+        close(stdinPipe[0]);
+        close(stdinPipe[1]);
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(stdinPipe[0], STDIN_FILENO);
+        dup2(stdoutPipe[1], STDOUT_FILENO);
+        dup2(stdoutPipe[1], STDERR_FILENO);
+        close(stdinPipe[0]);
+        close(stdinPipe[1]);
+        close(stdoutPipe[0]);
+        close(stdoutPipe[1]);
+        execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
+        _exit(1);
+    } else if (pid < 0) {
+        close(stdinPipe[0]);
+        close(stdinPipe[1]);
+        close(stdoutPipe[0]);
+        close(stdoutPipe[1]);
+        return false;
+    }
+
+    childPid = pid;
+    childStdinFd = stdinPipe[1];
+    childStdoutFd = stdoutPipe[0];
+    close(stdinPipe[0]);
+    close(stdoutPipe[1]);
+    running = true;
+#endif
+    send("uci\n");
+    if (waitWithin("uciok", kReplyTimeoutMs).empty()) {
+        stop();
+        return false;
+    }
+    setOption("Skill Level", std::to_string(skillLevel));
+    return isReady();
+}
+
+void UciEngine::setCache(EvalCache* evalCache, int minDepth) {
+    cache = evalCache;
+    cacheMinDepth = minDepth;
+}
+
+void UciEngine::stop() {
+    if (!running) return;
+    send("quit\n");
+    release(kStopGraceMs);
+}
+
+void UciEngine::kill() {
+    if (running) release(0);
+}
+
+void UciEngine::release(int graceMs) {
+#ifdef _WIN32
+    CloseHandle(childStdinWr);
+    if (WaitForSingleObject(processHandle, static_cast<DWORD>(graceMs)) != WAIT_OBJECT_0) {
+        TerminateProcess(processHandle, 1);
+        WaitForSingleObject(processHandle, INFINITE);
+    }
+    CloseHandle(childStdoutRd);
+    CloseHandle(processHandle);
+    CloseHandle(threadHandle);
+    childStdoutRd = childStdinWr = nullptr;
+    processHandle = threadHandle = nullptr;
+#else
+    close(childStdinFd);
+    auto deadline = Clock::now() + std::chrono::milliseconds(graceMs);
+    int status = 0;
+    while (waitpid(childPid, &status, WNOHANG) == 0) {
+        if (Clock::now() >= deadline) {
+            ::kill(childPid, SIGKILL);
+            waitpid(childPid, &status, 0);
+            break;
+        }
+        usleep(1000);
+    }
+    close(childStdoutFd);
+    childStdinFd = -1;
+    childStdoutFd = -1;
+    childPid = -1;
+#endif
+    running = false;
+}
+
+bool UciEngine::send(const std::string& msg) const {
+    if (!running) return false;
+#ifdef _WIN32
+    DWORD written = 0;
+    return WriteFile(childStdinWr, msg.c_str(), static_cast<DWORD>(msg.size()), &written, nullptr) &&
+           written == msg.size();
+#else
+    // A write to an engine that exited raises SIGPIPE, which would kill the host process. Rather
+    // than ignoring it process-wide, block it on this thread for the write and swallow the one
+    // the write raised.
+    sigset_t pipeSignal, previousMask, pending;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &previousMask);
+    sigpending(&pending);
+    bool alreadyPending = sigismember(&pending, SIGPIPE);
+    ssize_t written = write(childStdinFd, msg.c_str(), msg.size());
+    if (written < 0 && errno == EPIPE && !alreadyPending) {
+        timespec noWait{0, 0};
+        while (sigtimedwait(&pipeSignal, nullptr, &noWait) < 0 && errno == EINTR) {
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+    return written == static_cast<ssize_t>(msg.size());
+#endif
+}
+
+void UciEngine::setOption(const std::string& name, const std::string& value) const {
+    send("setoption name " + name + " value " + value + "\n");
+}
+
+bool UciEngine::fillBuffer() {
+    if (!running || endOfStream) return false;
+#ifdef _WIN32
+    while (readDeadline) {
+        DWORD available = 0;
+        if (!PeekNamedPipe(childStdoutRd, nullptr, 0, nullptr, &available, nullptr) || available > 0) break;
+        if (Clock::now() >= *readDeadline) {
+            timedOut = true;
+            return false;
+        }
+        Sleep(5);
+    }
+    DWORD readBytes = 0;
+    if (!ReadFile(childStdoutRd, buffer, sizeof(buffer), &readBytes, nullptr) || readBytes == 0) {
+        endOfStream = true;
+        return false;
+    }
+#else
+    while (readDeadline) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(*readDeadline - Clock::now()).count();
+        pollfd readable{childStdoutFd, POLLIN, 0};
+        int ready = poll(&readable, 1, static_cast<int>(std::max<long long>(0, left)));
+        if (ready > 0) break;
+        if (ready == 0) {
+            timedOut = true;
+            return false;
+        }
+        if (errno != EINTR) break;
+    }
+    ssize_t readBytes = read(childStdoutFd, buffer, sizeof(buffer));
+    if (readBytes <= 0) {
+        endOfStream = true;
+        return false;
+    }
+#endif
+    bufferPos = 0;
+    bufferLen = static_cast<size_t>(readBytes);
+    return true;
+}
+
+std::string UciEngine::readLine() {
+    while (true) {
+        if (bufferPos == bufferLen && !fillBuffer()) {
+            if (timedOut) return "";
+            break;
+        }
+        char ch = buffer[bufferPos++];
+        if (ch == '\r') continue;
+        if (ch == '\n') break;
+        partialLine.push_back(ch);
+    }
+    std::string line;
+    line.swap(partialLine);
+    return line;
+}
+
+std::string UciEngine::waitFor(const std::string& prefix) {
+    std::string line;
+    do {
+        line = readLine();
+    } while (running && !endOfStream && !timedOut && line.rfind(prefix, 0) != 0);
+    if (line.rfind(prefix, 0) != 0) return "";
+    return line;
+}
+
+std::string UciEngine::waitWithin(const std::string& prefix, int timeoutMs) {
+    readDeadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::string line = waitFor(prefix);
+    readDeadline.reset();
+    if (timedOut) {
+        timedOut = false;
+        kill();
+    }
+    return line;
+}
+
+bool UciEngine::isReady() {
+    send("isready\n");
+    return !waitWithin("readyok", kReplyTimeoutMs).empty();
+}
+
+std::string UciEngine::waitForBestMove(int timeoutMs, const std::function<void(std::string_view)>& onLine) {
+    if (timeoutMs > 0) readDeadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    bool stopSent = false;
+    std::string bestLine;
+    while (true) {
+        std::string line = readLine();
+        if (timedOut) {
+            timedOut = false;
+            if (stopSent) {
+                kill();
+                break;
+            }
+            // Out of time: the engine still owes a bestmove for what it has searched so far.
+            send("stop\n");
+            stopSent = true;
+            readDeadline = Clock::now() + std::chrono::milliseconds(kStopGraceMs);
+            continue;
+        }
+        if (line.empty() && endOfStream) {
+            kill(); // exited or crashed mid-search
+            break;
+        }
+        if (line.rfind("bestmove", 0) == 0) {
+            bestLine = std::move(line);
+            break;
+        }
+        if (onLine) onLine(line);
+    }
+    readDeadline.reset();
+    return bestLine;
+}
+
+void UciEngine::sendPosition(const std::string& fen, const std::vector<std::string>& uciMoves) const {
+    std::string posCmd = fen.empty() ? "position startpos" : "position fen " + fen;
+    if (!uciMoves.empty()) {
+        posCmd += " moves";
+        for (const auto& mv : uciMoves) {
+            posCmd += " " + mv;
+        }
+    }
+    posCmd += "\n";
+    send(posCmd);
+}
+
+namespace {
+std::string_view nextToken(std::string_view& rest) {
+    size_t start = rest.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        rest = {};
+        return {};
+    }
+    size_t end = rest.find(' ', start);
+    std::string_view token = rest.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    rest = (end == std::string_view::npos) ? std::string_view{} : rest.substr(end);
+    return token;
+}
+
+long long toNumber(std::string_view token) {
+    long long value = 0;
+    bool negative = !token.empty() && token.front() == '-';
+    for (size_t i = negative ? 1 : 0; i < token.size(); ++i) {
+        if (token[i] < '0' || token[i] > '9') break;
+        value = value * 10 + (token[i] - '0');
+    }
+    return negative ? -value : value;
+}
+
+// Parses an "info ... pv ..." line into `line`; returns false for lines without a PV.
+bool parseInfoLine(std::string_view rest, PvLine& line) {
+    bool bound = false;
+    while (!rest.empty()) {
+        std::string_view key = nextToken(rest);
+        if (key == "depth") {
+            line.depth = static_cast<int>(toNumber(nextToken(rest)));
+        } else if (key == "multipv") {
+            line.multiPv = static_cast<int>(toNumber(nextToken(rest)));
+        } else if (key == "nodes") {
+            line.nodes = toNumber(nextToken(rest));
+        } else if (key == "score") {
+            std::string_view kind = nextToken(rest);
+            line.mate = (kind == "mate");
+            line.score = static_cast<int>(toNumber(nextToken(rest)));
+        } else if (key == "lowerbound" || key == "upperbound") {
+            bound = true;
+        } else if (key == "pv") {
+            line.pv.clear();
+            while (!rest.empty()) {
+                std::string_view mv = nextToken(rest);
+                if (!mv.empty()) line.pv.emplace_back(mv);
+            }
+        } else if (key == "string") {
+            return false;
+        }
+    }
+    return !bound && !line.pv.empty();
+}
+} // namespace
+
+std::optional<uint64_t> analysisKey(const std::string& fen, const std::vector<std::string>& uciMoves) {
+    Game game;
+    if (fen.empty()) {
+        game.start();
+    } else if (!game.setFen(fen)) {
+        return std::nullopt;
+    }
+    if (game.applyMoves(uciMoves) != uciMoves.size()) return std::nullopt;
+    return game.getPositionHash();
+}
+
+std::optional<AnalysisResult> cachedAnalysis(const EvalCache& cache, uint64_t key, int minDepth) {
+    auto hit = cache.probe(key);
+    if (!hit || hit->pv.empty() || hit->depth < minDepth) return std::nullopt;
+    AnalysisResult result;
+    PvLine line;
+    line.depth = hit->depth;
+    line.mate = hit->mate;
+    line.score = hit->score;
+    for (const auto& mv : hit->pv) line.pv.push_back(toUci(mv));
+    result.bestMove = line.pv.front();
+    result.lines.push_back(std::move(line));
+    return result;
+}
+
+void storeAnalysis(EvalCache& cache, uint64_t key, const AnalysisResult& result) {
+    if (result.bestMove.empty() || result.lines.empty()) return;
+    const PvLine& line = result.lines.front();
+    CachedEval eval;
+    eval.depth = line.depth;
+    eval.mate = line.mate;
+    eval.score = line.score;
+    for (const auto& text : line.pv) {
+        auto mv = parseUci(text);
+        if (!mv) break;
+        eval.pv.push_back(*mv);
+    }
+    if (eval.pv.empty() || toUci(eval.pv.front()) != result.bestMove) return;
+    cache.store(key, eval);
+}
+
+AnalysisResult UciEngine::analyse(const std::string& fen, const std::vector<std::string>& uciMoves,
+                                  const SearchLimits& limits, const std::function<void(const PvLine&)>& onInfo) {
+    AnalysisResult result;
+    if (!running) return result;
+    std::optional<uint64_t> key;
+    if (cache && cache->isOpen() && limits.multiPv <= 1) {
+        key = analysisKey(fen, uciMoves);
+        if (key) {
+            if (auto hit = cachedAnalysis(*cache, *key, std::max(cacheMinDepth, limits.depth))) {
+                if (onInfo) onInfo(hit->lines.front());
+                return *hit;
+            }
+        }
+    }
+    CHESS_METRIC_SCOPE(MetricOp::EngineRoundTrip);
+
+    int wantedMultiPv = limits.multiPv < 1 ? 1 : limits.multiPv;
+    if (wantedMultiPv != multiPv) {
+        setOption("MultiPV", std::to_string(wantedMultiPv));
+        multiPv = wantedMultiPv;
+    }
+    sendPosition(fen, uciMoves);
+
+    std::string go = "go";
+    if (limits.depth > 0) go += " depth " + std::to_string(limits.depth);
+    if (limits.nodes > 0) go += " nodes " + std::to_string(limits.nodes);
+    if (limits.movetimeMs > 0) go += " movetime " + std::to_string(limits.movetimeMs);
+    int movetimeMs = limits.movetimeMs;
+    if (go == "go") {
+        movetimeMs = 1000;
+        go += " movetime 1000";
+    }
+    send(go + "\n");
+    int timeoutMs = limits.timeoutMs > 0 ? limits.timeoutMs : (movetimeMs > 0 ? movetimeMs + kStopGraceMs : 0);
+
+    result.lines.resize(static_cast<size_t>(wantedMultiPv));
+    std::string bestLine = waitForBestMove(timeoutMs, [&](std::string_view view) {
+        if (view.rfind("info ", 0) != 0) return;
+        PvLine parsed;
+        if (!parseInfoLine(view.substr(5), parsed)) return;
+        if (parsed.multiPv < 1 || parsed.multiPv > wantedMultiPv) return;
+        result.nodes = std::max(result.nodes, parsed.nodes);
+        if (onInfo) onInfo(parsed);
+        result.lines[static_cast<size_t>(parsed.multiPv - 1)] = std::move(parsed);
+    });
+    if (bestLine.empty()) return AnalysisResult{};
+    std::string_view rest = std::string_view(bestLine).substr(8);
+    std::string_view best = nextToken(rest);
+    if (best != "(none)" && best != "0000") result.bestMove = std::string(best);
+    while (!result.lines.empty() && result.lines.back().pv.empty()) {
+        result.lines.pop_back();
+    }
+    if (key) storeAnalysis(*cache, *key, result);
+    return result;
+}
+
+std::string UciEngine::bestMove(const std::vector<std::string>& uciMoves, int movetimeMs) {
+    return bestMove("", uciMoves, movetimeMs);
+}
+
+std::string UciEngine::bestMove(const std::string& fen, const std::vector<std::string>& uciMoves, int movetimeMs) {
+    if (!running) return "";
+    if (cache && cache->isOpen()) {
+        auto key = analysisKey(fen, uciMoves);
+        if (key) {
+            if (auto hit = cachedAnalysis(*cache, *key, cacheMinDepth)) return hit->bestMove;
+        }
+    }
+    CHESS_METRIC_SCOPE(MetricOp::EngineRoundTrip);
+    sendPosition(fen, uciMoves);
+    send("go movetime " + std::to_string(movetimeMs) + "\n");
+    auto line = waitForBestMove(movetimeMs + kStopGraceMs, nullptr);
+    if (line.empty()) return "";
+    auto partsPos = line.find(' ');
+    if (partsPos == std::string::npos) return "";
+    std::string moveStr = line.substr(partsPos + 1);
+    auto space = moveStr.find(' ');
+    if (space != std::string::npos) moveStr = moveStr.substr(0, space);
+    if (moveStr == "(none)") return "";
+    return moveStr;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Move.h"
+
+// Formats a move as a UCI string, e.g. "e2e4" or "e7e8n".
+std::string toUci(const MoveCoords& move);
+// Parses a UCI move string; returns nullopt for malformed or off-board squares.
+std::optional<MoveCoords> parseUci(std::string_view text);
+
+// Search limits for a single "go" command; zero means "not set".
+struct SearchLimits {
+    int depth = 0;
+    long long nodes = 0;
+    int movetimeMs = 0;
+    int multiPv = 1;
+    // Wall-clock cap: when it runs out the engine is sent "stop", and killed if no bestmove follows
+    // within UciEngine::kStopGraceMs. Zero means movetime plus that grace for timed searches and
+    // no cap for depth or node limited ones.
+    int timeoutMs = 0;
+};
+
+// Last reported principal variation for one MultiPV slot.
+struct PvLine {
+    int multiPv = 1;
+    int depth = 0;
+    bool mate = false;
+    int score = 0; // centipawns, or moves to mate if `mate`; from the side to move's point of view
+    long long nodes = 0;
+    std::vector<std::string> pv;
+};
+
+struct AnalysisResult {
+    std::string bestMove;
+    std::vector<PvLine> lines; // lines[i] is MultiPV slot i + 1
+    long long nodes = 0;
+};
+
+class EvalCache;
+
+// Evaluation cache glue (see EvalCache.h), shared by UciEngine and EnginePool. The key is the
+// position hash after `uciMoves`; nullopt if the FEN or a move does not apply.
+std::optional<uint64_t> analysisKey(const std::string& fen, const std::vector<std::string>& uciMoves);
+// The cached single-PV result for `key` if it is at least `minDepth` deep.
+std::optional<AnalysisResult> cachedAnalysis(const EvalCache& cache, uint64_t key, int minDepth);
+void storeAnalysis(EvalCache& cache, uint64_t key, const AnalysisResult& result);
+
+// A UCI engine (Stockfish or the mock engine) running as a child process, talking over pipes.
+class UciEngine {
+public:
+    // How long an engine gets to answer "stop", "quit", "uci" or "isready" before it is killed.
+    static constexpr int kStopGraceMs = 1000;
+    static constexpr int kReplyTimeoutMs = 10000;
+
+    UciEngine() = default;
+    ~UciEngine();
+    UciEngine(const UciEngine&) = delete;
+    UciEngine& operator=(const UciEngine&) = delete;
+
+    bool start(const std::string& path, int skillLevel);
+    // False once stopped, after the engine was killed for not answering, and after it exited on its
+    // own (noticed at the next search).
+    bool isRunning() const { return running; }
+    void stop();
+
+    bool send(const std::string& msg) const;
+    void setOption(const std::string& name, const std::string& value) const;
+    // Returns the next output line without the line terminator; empty once the pipe is closed.
+    std::string readLine();
+    // Reads lines until one starts with `prefix` (or the engine goes away) and returns it.
+    std::string waitFor(const std::string& prefix);
+    // False (and the engine killed) if it does not answer within kReplyTimeoutMs.
+    bool isReady();
+    // Single-PV searches are answered from `cache` when it holds one at least `minDepth` (and the
+    // requested depth) deep, and finished searches are written back. The cache must outlive the
+    // engine; null turns caching off.
+    void setCache(EvalCache* cache, int minDepth = 1);
+
+    std::string bestMove(const std::vector<std::string>& uciMoves, int movetimeMs);
+    // Same, starting from `fen` instead of the standard start position.
+    std::string bestMove(const std::string& fen, const std::vector<std::string>& uciMoves, int movetimeMs);
+    // Searches `fen` (the start position if empty) after `uciMoves` and collects the info output.
+    // `onInfo`, if set, sees every PV line as it arrives (e.g. to time when the best move settled).
+    // A search cut off by limits.timeoutMs keeps what the engine reported; a killed or crashed
+    // engine gives an empty result and isRunning() turns false.
+    AnalysisResult analyse(const std::string& fen, const std::vector<std::string>& uciMoves, const SearchLimits& limits,
+                           const std::function<void(const PvLine&)>& onInfo = nullptr);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool fillBuffer();
+    void sendPosition(const std::string& fen, const std::vector<std::string>& uciMoves) const;
+    // waitFor with a deadline; kills the engine when it runs out.
+    std::string waitWithin(const std::string& prefix, int timeoutMs);
+    // Reads the search output up to "bestmove" and returns that line, passing every other line to
+    // `onLine`; see SearchLimits::timeoutMs for `timeoutMs`. Empty if the engine died or was killed.
+    std::string waitForBestMove(int timeoutMs, const std::function<void(std::string_view)>& onLine);
+    void kill();
+    // Closes the pipes and reaps the child, killing it if it has not exited after `graceMs`.
+    void release(int graceMs);
+
+#ifdef _WIN32
+    void* childStdoutRd = nullptr;
+    void* childStdinWr = nullptr;
+    void* processHandle = nullptr;
+    void* threadHandle = nullptr;
+#else
+    int childStdoutFd = -1;
+    int childStdinFd = -1;
+    int childPid = -1;
+#endif
+    bool running = false;
+    bool endOfStream = false;
+    bool timedOut = false;
+    std::optional<Clock::time_point> readDeadline; // reads give up (timedOut) past this point
+    int multiPv = 1;
+    EvalCache* cache = nullptr;
+    int cacheMinDepth = 1;
+
+    // Output is read in blocks; engines print long runs of "info" lines per search.
+    char buffer[4096];
+    size_t bufferPos = 0;
+    size_t bufferLen = 0;
+    std::string partialLine; // kept when a read times out mid-line
+};
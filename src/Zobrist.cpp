@@ -0,0 +1,56 @@
+#include "Zobrist.h"
+#include <array>
+
+namespace {
+struct Keys {
+    std::array<uint64_t, 12 * 64> pieces{};
+    std::array<uint64_t, 16> castling{};
+    std::array<uint64_t, 8> enPassant{};
+    uint64_t side = 0;
+
+    Keys() {
+        uint64_t state = 0x2021C0DEull;
+        auto next = [&state]() {
+            // splitmix64
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        for (auto& key : pieces) key = next();
+        std::array<uint64_t, 4> rights{};
+        for (auto& key : rights) key = next();
+        for (int mask = 0; mask < 16; ++mask) {
+            for (int bit = 0; bit < 4; ++bit) {
+                if (mask & (1 << bit)) castling[mask] ^= rights[bit];
+            }
+        }
+        for (auto& key : enPassant) key = next();
+        side = next();
+    }
+};
+
+const Keys& keys() {
+    static const Keys instance;
+    return instance;
+}
+} // namespace
+
+namespace zobrist {
+uint64_t piece(PieceType type, Color color, int x, int y) {
+    int index = static_cast<int>(type) * 2 + (color == Color::White ? 0 : 1);
+    return keys().pieces[static_cast<size_t>(index * 64 + y * 8 + x)];
+}
+
+uint64_t blackToMove() {
+    return keys().side;
+}
+
+uint64_t castling(int rights) {
+    return keys().castling[static_cast<size_t>(rights & 15)];
+}
+
+uint64_t enPassantFile(int file) {
+    return keys().enPassant[static_cast<size_t>(file & 7)];
+}
+} // namespace zobrist
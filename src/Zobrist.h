@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include "Piece.h"
+
+// Zobrist keys for position hashing. The keys come from a fixed-seed generator, so hashes are
+// stable across runs and can be persisted (evaluation cache, databases).
+namespace zobrist {
+uint64_t piece(PieceType type, Color color, int x, int y);
+uint64_t blackToMove();
+uint64_t castling(int rights); // rights: bitmask of the four castling rights (0..15)
+uint64_t enPassantFile(int file);
+} // namespace zobrist
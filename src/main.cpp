@@ -1,25 +1,26 @@
+#include "Annotator.h"
 #include "Game.h"
+#include "GameDatabase.h"
+#include "Metrics.h"
+#include "MoveJournal.h"
+#include "Pgn.h"
+#include "UciEngine.h"
 #include <algorithm>
 #include <cctype>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
-
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <signal.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <unistd.h>
-#endif
+#include <thread>
 
 namespace {
 const std::string kSaveFile = "savegame.json";
+// Crash recovery: every move is journaled here and the file is removed again on a clean exit.
+const std::string kJournalFile = "savegame.journal";
 
 std::optional<std::pair<int, int>> parseSquare(const std::string& coord) {
     if (coord.size() != 2) return std::nullopt;
@@ -77,10 +78,17 @@ void printHelp() {
               << "  move <from> <to>        - e.g. move e2 e4\n"
               << "  undo                    - undo last move\n"
               << "  show                    - print board\n"
-              << "  save                    - save game\n"
-              << "  load                    - load game\n"
+              << "  save [file]             - save game (.json, .fen or compact .bin)\n"
+              << "  load [file]             - load game\n"
               << "  name <white|black> <name> - set player name\n"
               << "  stockfish                - play vs Stockfish\n"
+              << "  fen                     - print the position as FEN\n"
+              << "  setfen <fen>            - set up a position from FEN\n"
+              << "  pgn [file]              - export the game as PGN\n"
+              << "  loadpgn <file>          - load the first game of a PGN file\n"
+              << "  annotate [file]         - annotate the last finished game as PGN\n"
+              << "  explore [db]            - moves played from this position in a game database\n"
+              << "  stats [file]            - operation latencies (file: Prometheus text export)\n"
               << "  help                    - show this help\n"
               << "  quit                    - exit game\n";
 }
@@ -100,272 +108,49 @@ PieceType promptPromotionChoice() {
     }
 }
 
-class StockfishProcess {
-public:
-    bool start(const std::string& path, int skillLevel) {
-#ifdef _WIN32
-        SECURITY_ATTRIBUTES saAttr{};
-        saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
-        saAttr.bInheritHandle = TRUE;
-        saAttr.lpSecurityDescriptor = nullptr;
-
-        if (!CreatePipe(&childStdoutRd, &childStdoutWr, &saAttr, 0)) return false;
-        if (!SetHandleInformation(childStdoutRd, HANDLE_FLAG_INHERIT, 0)) return false;
-        if (!CreatePipe(&childStdinRd, &childStdinWr, &saAttr, 0)) return false;
-        if (!SetHandleInformation(childStdinWr, HANDLE_FLAG_INHERIT, 0)) return false;
-
-        STARTUPINFOA si{};
-        si.cb = sizeof(STARTUPINFOA);
-        si.hStdError = childStdoutWr;
-        si.hStdOutput = childStdoutWr;
-        si.hStdInput = childStdinRd;
-        si.dwFlags |= STARTF_USESTDHANDLES;
-
-        std::string cmd = "\"" + path + "\"";
-        BOOL success = CreateProcessA(
-            nullptr,
-            cmd.data(),
-            nullptr,
-            nullptr,
-            TRUE,
-            0,
-            nullptr,
-            nullptr,
-            &si,
-            &pi);
-
-        if (!success) return false;
-        running = true;
-        childStdoutRdValid = true;
-        childStdoutWrValid = true;
-        childStdinRdValid = true;
-        childStdinWrValid = true;
-#else
-        int stdinPipe[2];
-        int stdoutPipe[2];
-        if (pipe(stdinPipe) != 0) return false;
-        if (pipe(stdoutPipe) != 0) {
-            close(stdinPipe[0]);
-            close(stdinPipe[1]);
-            return false;
-        }
-        pid_t pid = fork();
-        if (pid == 0) {
-            dup2(stdinPipe[0], STDIN_FILENO);
-            dup2(stdoutPipe[1], STDOUT_FILENO);
-            dup2(stdoutPipe[1], STDERR_FILENO);
-            close(stdinPipe[0]);
-            close(stdinPipe[1]);
-            close(stdoutPipe[0]);
-            close(stdoutPipe[1]);
-            execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
-            _exit(1);
-        } else if (pid < 0) {
-            close(stdinPipe[0]);
-            close(stdinPipe[1]);
-            close(stdoutPipe[0]);
-            close(stdoutPipe[1]);
-            return false;
-        }
-
-        childPid = pid;
-        childStdinFd = stdinPipe[1];
-        childStdoutFd = stdoutPipe[0];
-        close(stdinPipe[0]);
-        close(stdoutPipe[1]);
-        running = true;
-#endif
-        send("uci\n");
-        send("setoption name Skill Level value " + std::to_string(skillLevel) + "\n");
-        send("isready\n");
-        waitFor("readyok");
-        return true;
-    }
-
-    bool isRunning() const { return running; }
-
-    void stop() {
-        if (!running) return;
-        send("quit\n");
-#ifdef _WIN32
-        if (childStdoutWrValid) CloseHandle(childStdoutWr);
-        if (childStdinRdValid) CloseHandle(childStdinRd);
-        if (childStdinWrValid) CloseHandle(childStdinWr);
-        if (childStdoutRdValid) CloseHandle(childStdoutRd);
-        WaitForSingleObject(pi.hProcess, 1000);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        childStdoutWrValid = childStdinRdValid = childStdinWrValid = childStdoutRdValid = false;
-#else
-        close(childStdinFd);
-        int status = 0;
-        waitpid(childPid, &status, 0);
-        close(childStdoutFd);
-        childStdinFd = -1;
-        childStdoutFd = -1;
-        childPid = -1;
-#endif
-        running = false;
-    }
-
-    bool send(const std::string& msg) const {
-        if (!running) return false;
-#ifdef _WIN32
-        DWORD written = 0;
-        return WriteFile(childStdinWr, msg.c_str(), static_cast<DWORD>(msg.size()), &written, nullptr);
-#else
-        ssize_t written = write(childStdinFd, msg.c_str(), msg.size());
-        return written == static_cast<ssize_t>(msg.size());
-#endif
-    }
-
-    std::string readLine() const {
-        std::string line;
-        char ch = 0;
-#ifdef _WIN32
-        DWORD read = 0;
-        while (true) {
-            if (!ReadFile(childStdoutRd, &ch, 1, &read, nullptr) || read == 0) break;
-            if (ch == '\r') continue;
-            if (ch == '\n') break;
-            line.push_back(ch);
-        }
-#else
-        ssize_t readBytes = 0;
-        while (true) {
-            readBytes = read(childStdoutFd, &ch, 1);
-            if (readBytes <= 0) break;
-            if (ch == '\r') continue;
-            if (ch == '\n') break;
-            line.push_back(ch);
-        }
-#endif
-        return line;
-    }
-
-    std::string waitFor(const std::string& prefix) const {
-        std::string line;
-        do {
-            line = readLine();
-        } while (running && line.rfind(prefix, 0) != 0);
-        return line;
-    }
-
-    std::string bestMove(const std::vector<std::string>& uciMoves, int movetimeMs) {
-        if (!running) return "";
-        std::string posCmd = "position startpos";
-        if (!uciMoves.empty()) {
-            posCmd += " moves";
-            for (const auto& mv : uciMoves) {
-                posCmd += " " + mv;
-            }
-        }
-        posCmd += "\n";
-        send(posCmd);
-        send("go movetime " + std::to_string(movetimeMs) + "\n");
-        auto line = waitFor("bestmove");
-        if (line.empty()) return "";
-        auto partsPos = line.find(' ');
-        if (partsPos == std::string::npos) return "";
-        std::string moveStr = line.substr(partsPos + 1);
-        auto space = moveStr.find(' ');
-        if (space != std::string::npos) moveStr = moveStr.substr(0, space);
-        return moveStr;
-    }
-
-private:
-#ifdef _WIN32
-    HANDLE childStdoutRd = nullptr;
-    HANDLE childStdoutWr = nullptr;
-    HANDLE childStdinRd = nullptr;
-    HANDLE childStdinWr = nullptr;
-    PROCESS_INFORMATION pi{};
-    bool childStdoutRdValid = false;
-    bool childStdoutWrValid = false;
-    bool childStdinRdValid = false;
-    bool childStdinWrValid = false;
-#else
-    int childStdoutFd = -1;
-    int childStdinFd = -1;
-    pid_t childPid = -1;
-#endif
-    bool running = false;
-};
-
-std::string coordsToUci(int fromX, int fromY, int toX, int toY, std::optional<PieceType> promo = std::nullopt) {
-    auto toFile = [](int x) { return static_cast<char>('a' + x); };
-    auto toRank = [](int y) { return static_cast<char>('1' + y); };
-    std::string m;
-    m.push_back(toFile(fromX));
-    m.push_back(toRank(fromY));
-    m.push_back(toFile(toX));
-    m.push_back(toRank(toY));
-    if (promo.has_value()) {
-        char c = 'q';
-        switch (*promo) {
-            case PieceType::Queen: c = 'q'; break;
-            case PieceType::Rook: c = 'r'; break;
-            case PieceType::Bishop: c = 'b'; break;
-            case PieceType::Knight: c = 'n'; break;
-            default: break;
-        }
-        m.push_back(c);
-    }
-    return m;
-}
-
-bool parseUciMove(const std::string& mv, int& fromX, int& fromY, int& toX, int& toY, PieceType& promoType, bool& hasPromo) {
-    if (mv.size() < 4) return false;
-    fromX = mv[0] - 'a';
-    fromY = mv[1] - '1';
-    toX = mv[2] - 'a';
-    toY = mv[3] - '1';
-    hasPromo = false;
-    if (mv.size() >= 5) {
-        hasPromo = true;
-        char p = static_cast<char>(std::tolower(static_cast<unsigned char>(mv[4])));
-        switch (p) {
-            case 'q': promoType = PieceType::Queen; break;
-            case 'r': promoType = PieceType::Rook; break;
-            case 'b': promoType = PieceType::Bishop; break;
-            case 'n': promoType = PieceType::Knight; break;
-            default: hasPromo = false; break;
-        }
-    }
-    return true;
-}
-
-void applyEngineMove(Game& game, const std::string& mv) {
-    int fx, fy, tx, ty;
-    PieceType promo = PieceType::Queen;
-    bool hasPromo = false;
-    if (!parseUciMove(mv, fx, fy, tx, ty, promo, hasPromo)) return;
-    game.makeMove(fx, fy, tx, ty, hasPromo ? promo : PieceType::Queen);
+// False if the engine's move does not parse or is illegal.
+bool applyEngineMove(Game& game, const std::string& mv) {
+    auto parsed = parseUci(mv);
+    if (!parsed) return false;
+    return game.makeMove(parsed->fromX, parsed->fromY, parsed->toX, parsed->toY,
+                         parsed->promotion.value_or(PieceType::Queen)) == MoveStatus::Ok;
 }
 
 } // namespace
 
 int main() {
     Game game;
-    StockfishProcess engine;
+    UciEngine engine;
     bool engineEnabled = false;
     Color engineColor = Color::Black;
     int engineMovetimeMs = 1000;
-    std::vector<std::string> uciMoves;
+    std::string lastStartFen;
+    std::vector<MoveCoords> lastMoves;
+    std::string lastResult = "*";
 
     auto restartGame = [&](const std::string& message) {
         std::cout << message
-                  << "\nGame over. Starting a new game. Type 'quit' to exit if you are done.\n";
+                  << "\nGame over. Type 'annotate' to review it. Starting a new game. Type 'quit' to exit if you are done.\n";
+        lastStartFen = game.getStartFen();
+        lastMoves = game.getMoveHistory();
+        GameStatus status = game.getStatus();
+        if (status == GameStatus::Checkmate) {
+            lastResult = game.isWhiteTurn() ? "0-1" : "1-0";
+        } else {
+            lastResult = status == GameStatus::Stalemate ? "1/2-1/2" : "*";
+        }
         game.start();
-        uciMoves.clear();
         if (engine.isRunning()) {
             engine.send("ucinewgame\n");
         }
         printBoard(game);
     };
 
+    MoveJournal journal;
     std::ifstream infile(kSaveFile);
-    if (infile.good()) {
+    if (MoveJournal::recover(kJournalFile, game)) {
+        std::cout << "Recovered the unfinished game from " << kJournalFile << "." << std::endl;
+    } else if (infile.good()) {
         std::cout << "Loading previous save..." << std::endl;
         game.loadFromFile(kSaveFile);
     } else {
@@ -377,8 +162,13 @@ int main() {
     printBoard(game);
     printHelp();
 
+    if (!journal.open(kJournalFile, game)) {
+        std::cout << "Warning: cannot write " << kJournalFile << "; moves will not survive a crash." << std::endl;
+    }
+
     std::string line;
     while (true) {
+        journal.update(game);
         std::cout << '\n'
                   << (game.isWhiteTurn() ? game.getPlayerName(Color::White)
                                           : game.getPlayerName(Color::Black))
@@ -416,54 +206,53 @@ int main() {
                 }
             }
 
-            int beforeMoves = game.getMoveCount();
-            game.makeMove(fromCoord->first, fromCoord->second, toCoord->first, toCoord->second, promotionChoice);
-            if (game.getMoveCount() == beforeMoves) {
-                std::cout << "Illegal move.";
+            MoveStatus result =
+                game.makeMove(fromCoord->first, fromCoord->second, toCoord->first, toCoord->second, promotionChoice);
+            if (result != MoveStatus::Ok) {
+                std::cout << "Illegal move: " << moveStatusMessage(result) << ".";
             } else {
-                uciMoves.push_back(coordsToUci(fromCoord->first, fromCoord->second, toCoord->first, toCoord->second,
-                                               (promotionChoice != PieceType::Queen) ? std::optional<PieceType>(promotionChoice) : std::nullopt));
                 std::cout << "Move recorded.";
 
-                if (game.isCheckmate()) {
+                GameStatus status = game.getStatus();
+                if (status == GameStatus::Checkmate) {
                     Color winner = game.isWhiteTurn() ? Color::Black : Color::White;
                     std::cout << "\nCheckmate! " << game.getPlayerName(winner) << " wins.\n";
                     restartGame("Checkmate reached.");
                     continue;
-                } else if (game.isStalemate()) {
+                } else if (status == GameStatus::Stalemate) {
                     std::cout << "\nStalemate. Draw.\n";
                     restartGame("Stalemate reached.");
                     continue;
                 } else {
                     Color toMove = game.getCurrentPlayer();
-                    if (game.isInCheck(toMove)) {
+                    if (status == GameStatus::Check) {
                         std::cout << " Check! " << game.getPlayerName(toMove) << " is in check.";
                     }
                     printBoard(game);
 
                     if (engineEnabled && game.getCurrentPlayer() == engineColor && engine.isRunning()) {
                         std::cout << "\nEngine thinking..." << std::endl;
-                        std::string best = engine.bestMove(uciMoves, engineMovetimeMs);
+                        std::vector<std::string> uciMoves;
+                        for (const auto& mv : game.getMoveHistory()) uciMoves.push_back(toUci(mv));
+                        std::string best = engine.bestMove(game.getStartFen(), uciMoves, engineMovetimeMs);
                         if (!best.empty()) {
-                            uciMoves.push_back(best);
-                            int before = game.getMoveCount();
-                            applyEngineMove(game, best);
-                            if (game.getMoveCount() == before) {
+                            if (!applyEngineMove(game, best)) {
                                 std::cout << "Engine move was illegal; skipping.\n";
                             } else {
                                 std::cout << "Engine played: " << best << "\n";
-                                if (game.isCheckmate()) {
+                                GameStatus reply = game.getStatus();
+                                if (reply == GameStatus::Checkmate) {
                                     Color winner = game.isWhiteTurn() ? Color::Black : Color::White;
                                     std::cout << "Checkmate! " << game.getPlayerName(winner) << " wins.\n";
                                     restartGame("Checkmate reached.");
                                     continue;
-                                } else if (game.isStalemate()) {
+                                } else if (reply == GameStatus::Stalemate) {
                                     std::cout << "Stalemate. Draw.\n";
                                     restartGame("Stalemate reached.");
                                     continue;
                                 } else {
                                     Color tm = game.getCurrentPlayer();
-                                    if (game.isInCheck(tm)) {
+                                    if (reply == GameStatus::Check) {
                                         std::cout << game.getPlayerName(tm) << " is in check.\n";
                                     }
                                     printBoard(game);
@@ -481,21 +270,27 @@ int main() {
                 continue;
             }
             game.undoMove();
-            if (!uciMoves.empty()) uciMoves.pop_back();
             std::cout << "Last move undone.";
             printBoard(game);
         } else if (command == "show") {
             printBoard(game);
         } else if (command == "save") {
-            game.saveToFile(kSaveFile);
-            std::cout << "Saved to: " << kSaveFile;
+            std::string file = kSaveFile;
+            ss >> file;
+            if (game.saveToFile(file)) {
+                std::cout << "Saved to: " << file;
+            } else {
+                std::cout << "Could not save to: " << file;
+            }
         } else if (command == "load") {
-            std::ifstream check(kSaveFile);
+            std::string file = kSaveFile;
+            ss >> file;
+            std::ifstream check(file);
             if (!check.good()) {
-                std::cout << "No saved game in " << kSaveFile << ".";
+                std::cout << "No saved game in " << file << ".";
                 continue;
             }
-            game.loadFromFile(kSaveFile);
+            game.loadFromFile(file);
             std::cout << "Game loaded.";
             printBoard(game);
         } else if (command == "name") {
@@ -548,7 +343,6 @@ int main() {
             }
 
             engine.stop();
-            uciMoves.clear();
             if (!engine.start(enginePath, skill)) {
                 std::cout << "Failed to start engine at: " << enginePath;
             } else {
@@ -556,6 +350,127 @@ int main() {
                 std::cout << "Engine started as " << (engineColor == Color::White ? "White" : "Black")
                           << " with skill " << skill << ".";
             }
+        } else if (command == "fen") {
+            std::cout << game.fen();
+        } else if (command == "setfen") {
+            std::string fen;
+            std::getline(ss, fen);
+            if (!game.setFen(fen)) {
+                std::cout << "Invalid FEN. Usage: setfen <fen>";
+                continue;
+            }
+            if (engine.isRunning()) {
+                engine.send("ucinewgame\n");
+            }
+            std::cout << "Position set.";
+            printBoard(game);
+        } else if (command == "pgn") {
+            std::string file = "game.pgn";
+            ss >> file;
+            std::ofstream out(file);
+            writePgn(out, toPgnGame(game));
+            std::cout << "Written to " << file << ".";
+        } else if (command == "loadpgn") {
+            std::string file;
+            ss >> file;
+            std::ifstream in(file);
+            PgnReader reader(in);
+            PgnGame pgn;
+            if (file.empty() || !reader.next(pgn)) {
+                std::cout << "Usage: loadpgn <file> (reads the first game)";
+                continue;
+            }
+            if (!replayPgn(game, pgn)) {
+                std::cout << "Stopped at an unreadable move; loaded " << game.getMoveHistory().size() << " plies.";
+            } else {
+                std::cout << "Loaded " << pgn.sanMoves.size() << " plies.";
+            }
+            if (engine.isRunning()) {
+                engine.send("ucinewgame\n");
+            }
+            printBoard(game);
+        } else if (command == "annotate") {
+            std::string file = "annotated.pgn";
+            ss >> file;
+            // Without a finished game, review the one in progress.
+            std::string startFen = lastStartFen;
+            std::vector<MoveCoords> moves = lastMoves;
+            std::string result = lastResult;
+            if (moves.empty()) {
+                startFen = game.getStartFen();
+                moves = game.getMoveHistory();
+                result = "*";
+            }
+            if (moves.empty()) {
+                std::cout << "No moves to annotate.";
+                continue;
+            }
+            Annotator annotator;
+            std::vector<PlyAnnotation> notes;
+            std::string enginePath = resolveEnginePath();
+            unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+            SearchLimits limits;
+            if (std::filesystem::exists(enginePath)) {
+                std::cout << "Annotating with " << enginePath << "..." << std::endl;
+                limits.movetimeMs = 200;
+                EnginePool pool(enginePath, static_cast<int>(threads));
+                notes = annotator.annotate(pool, startFen, moves, limits);
+            } else {
+                std::cout << "Annotating with the built-in searcher..." << std::endl;
+                limits.depth = 3;
+                notes = annotator.annotateNative(static_cast<int>(threads), startFen, moves, limits);
+            }
+            std::ofstream out(file);
+            Annotator::writePgn(out, game, startFen, notes, result);
+            int counts[5] = {};
+            for (const auto& note : notes) ++counts[static_cast<int>(note.quality)];
+            std::cout << "Inaccuracies: " << counts[2] << ", mistakes: " << counts[3]
+                      << ", blunders: " << counts[4] << ". Written to " << file << ".";
+        } else if (command == "explore") {
+            std::string file = "games.cdb";
+            ss >> file;
+            GameDatabase database;
+            if (!database.open(file)) {
+                std::cout << "Cannot open " << file << " (build one with chess_db_build).";
+                continue;
+            }
+            auto moves = database.explore(game);
+            if (moves.empty()) {
+                std::cout << "No games in " << file << " reach this position.";
+                continue;
+            }
+            std::cout << "Move     Games   +White  =Draw  -Black  Score  Avg rating\n";
+            for (const auto& stats : moves) {
+                std::ostringstream line;
+                line << std::left << std::setw(8) << stats.san << std::right << std::setw(6) << stats.games
+                     << std::setw(9) << stats.whiteWins << std::setw(7) << stats.draws << std::setw(8)
+                     << stats.blackWins << std::setw(6) << static_cast<int>(stats.score * 100 + 0.5) << '%'
+                     << std::setw(12);
+                if (stats.averageRating) line << stats.averageRating;
+                else line << '-';
+                std::cout << line.str() << '\n';
+            }
+        } else if (command == "stats") {
+            if (!metricsEnabled()) {
+                std::cout << "Metrics are not compiled in (configure with -DCHESS_METRICS=ON).";
+                continue;
+            }
+            std::string file;
+            if (ss >> file) {
+                if (writePrometheusMetrics(file)) std::cout << "Metrics written to " << file << ".";
+                else std::cout << "Could not write " << file << ".";
+                continue;
+            }
+            std::cout << "Operation              Calls    Mean us     p50 us     p99 us    p999 us     Max us\n";
+            for (const auto& metrics : metricsSnapshot()) {
+                const LatencyHistogram& h = metrics.latency;
+                std::ostringstream line;
+                line << std::left << std::setw(18) << metrics.name << std::right << std::setw(10) << h.count()
+                     << std::fixed << std::setprecision(1) << std::setw(11) << h.mean() / 1000.0 << std::setw(11)
+                     << h.percentile(0.50) / 1000.0 << std::setw(11) << h.percentile(0.99) / 1000.0
+                     << std::setw(11) << h.percentile(0.999) / 1000.0 << std::setw(11) << h.max() / 1000.0;
+                std::cout << line.str() << '\n';
+            }
         } else if (command == "help") {
             printHelp();
         } else if (command == "quit" || command == "exit") {
@@ -567,9 +482,16 @@ int main() {
     }
 
     std::cout << "\nSaving game to JSON..." << std::endl;
-    game.saveToFile(kSaveFile);
-
-    std::cout << "Save complete. Goodbye!" << std::endl;
+    bool saved = game.saveToFile(kSaveFile);
+    journal.close();
+    // The journal is the only copy of the game until the save is on disk.
+    if (saved) {
+        std::error_code removeError;
+        std::filesystem::remove(kJournalFile, removeError);
+        std::cout << "Save complete. Goodbye!" << std::endl;
+    } else {
+        std::cout << "Save failed; the game is kept in " << kJournalFile << ". Goodbye!" << std::endl;
+    }
     engine.stop();
     return 0;
 }
@@ -1,12 +1,28 @@
 #include <gtest/gtest.h>
+#include <atomic>
 #include <cstdio>
 #include <fstream>
 #include <filesystem>
+#include <sstream>
+#include <thread>
 #include <nlohmann/json.hpp>
 
 #include "Game.h"
 #include "Board.h"
 #include "Piece.h"
+#include "Annotator.h"
+#include "BinarySave.h"
+#include "GameDatabase.h"
+#include "GameSessionManager.h"
+#include "GameTree.h"
+#include "JsonSave.h"
+#include "LatencyHistogram.h"
+#include "Metrics.h"
+#include "MoveJournal.h"
+#include "Pgn.h"
+#include "Search.h"
+#include "TrainingData.h"
+#include "UciEngine.h"
 
 namespace {
 void RemoveFile(const std::string& filename) {
@@ -54,6 +70,12 @@ TEST(GameTest, InitializesCorrectly) {
     EXPECT_FALSE(game.isStalemate());
 }
 
+TEST(GameTest, StartingPositionHasTwentyLegalMoves) {
+    Game game;
+    game.start();
+    EXPECT_EQ(game.getLegalMoves().size(), 20u);
+}
+
 TEST(BoardTest, CanMovePiece) {
     Board board;
     board.initialize();
@@ -569,3 +591,963 @@ TEST(GameIntegrationTest, UndoAcrossCastlingAndCapture) {
     EXPECT_FALSE(rook->hasMoved());
     EXPECT_TRUE(g.isWhiteTurn()); // back to white to move before castling
 }
+
+TEST(FenTest, StartPositionRoundTrip) {
+    Game g;
+    g.start();
+    const std::string startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    EXPECT_EQ(g.fen(), startFen);
+
+    Game loaded;
+    ASSERT_TRUE(loaded.setFen(startFen));
+    ExpectBoardsEqual(loaded.getBoard(), g.getBoard());
+    EXPECT_TRUE(loaded.isWhiteTurn());
+}
+
+TEST(FenTest, CastlingRightsAndEnPassantAreRestored) {
+    Game g;
+    ASSERT_TRUE(g.setFen("r3k2r/8/8/3pP3/8/8/8/R3K2R w Kq d6 0 20"));
+    EXPECT_EQ(g.fen(), "r3k2r/8/8/3pP3/8/8/8/R3K2R w Kq d6 0 20");
+    EXPECT_EQ(g.getMoveCount(), 38);
+
+    int before = g.getMoveCount();
+    g.makeMove(4, 0, 2, 0); // O-O-O without the right is rejected
+    EXPECT_EQ(g.getMoveCount(), before);
+    g.makeMove(4, 4, 3, 5); // exd6 e.p.
+    EXPECT_EQ(g.getMoveCount(), before + 1);
+    EXPECT_EQ(g.getBoard().getPieceAt(3, 4), nullptr);
+}
+
+TEST(FenTest, MalformedInputLeavesGameUnchanged) {
+    Game g;
+    g.start();
+    std::string before = g.fen();
+    EXPECT_FALSE(g.setFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1"));
+    EXPECT_FALSE(g.setFen("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+    EXPECT_FALSE(g.setFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1"));
+    EXPECT_EQ(g.fen(), before);
+}
+
+TEST(FenTest, HalfmoveClockFollowsMovesAndUndo) {
+    Game g;
+    ASSERT_TRUE(g.setFen("4k3/8/8/8/8/8/4P3/4K1N1 w - - 7 30"));
+    EXPECT_EQ(g.getHalfmoveClock(), 7);
+    g.makeMove(6, 0, 5, 2); // Nf3
+    EXPECT_EQ(g.getHalfmoveClock(), 8);
+    g.makeMove(4, 7, 3, 7); // ...Kd8
+    g.makeMove(4, 1, 4, 3); // e4 resets the clock
+    EXPECT_EQ(g.getHalfmoveClock(), 0);
+    EXPECT_EQ(g.fen(), "3k4/8/8/8/4P3/5N2/8/4K3 b - e3 0 31");
+    g.undoMove();
+    EXPECT_EQ(g.fen(), "3k4/8/8/8/8/5N2/4P3/4K3 w - - 9 31");
+    EXPECT_EQ(g.getStartFen(), "4k3/8/8/8/8/8/4P3/4K1N1 w - - 7 30");
+}
+
+TEST(BinarySaveTest, RoundTripsPositionNamesAndClocks) {
+    Game g;
+    g.start();
+    g.setPlayerName(Color::White, "Alice");
+    g.setPlayerName(Color::Black, "Bob");
+    g.makeMove(6, 0, 5, 2); // Nf3
+    g.makeMove(3, 6, 3, 4); // ...d5
+    g.makeMove(4, 1, 4, 3); // e4
+    g.makeMove(3, 4, 3, 3); // ...d4
+    g.makeMove(2, 1, 2, 3); // c4, en passant possible
+
+    std::vector<uint8_t> bytes = encodeBinarySave(g);
+    ASSERT_FALSE(bytes.empty());
+    EXPECT_LT(bytes.size(), 128u);
+
+    std::string path = "roundtrip_test_save.bin";
+    g.saveToFile(path);
+    Game loaded;
+    loaded.start();
+    loaded.loadFromFile(path);
+    EXPECT_EQ(loaded.fen(), g.fen());
+    EXPECT_EQ(loaded.getPlayerName(Color::White), "Alice");
+    EXPECT_EQ(loaded.getPlayerName(Color::Black), "Bob");
+    RemoveFile(path);
+
+    bytes[40] ^= 1; // corrupt the payload
+    Game untouched;
+    untouched.start();
+    EXPECT_FALSE(decodeBinarySave(untouched, bytes.data(), bytes.size()));
+    EXPECT_EQ(untouched.fen(), "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+}
+
+TEST(HistoryTest, SavesKeepMoveHistoryForUndo) {
+    for (std::string path : {"history_test_save.json", "history_test_save.bin"}) {
+        Game g;
+        g.start();
+        g.makeMove(4, 1, 4, 3); // e4
+        g.makeMove(3, 6, 3, 4); // ...d5
+        g.makeMove(4, 3, 3, 4); // exd5
+        g.makeMove(6, 7, 5, 5); // ...Nf6
+        g.makeMove(5, 0, 1, 4); // Bb5+
+        g.saveToFile(path);
+
+        Game loaded;
+        loaded.loadFromFile(path);
+        EXPECT_EQ(loaded.fen(), g.fen()) << path;
+        ASSERT_EQ(loaded.getMoveHistory().size(), 5u) << path;
+        loaded.undoMove();
+        loaded.undoMove();
+        loaded.undoMove();
+        EXPECT_EQ(loaded.fen(), "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2") << path;
+        RemoveFile(path);
+    }
+}
+
+TEST(HistoryTest, RepetitionCountFollowsMovesAndReplay) {
+    Game g;
+    g.start();
+    std::vector<MoveCoords> shuffle = {MoveCoords{6, 0, 5, 2, std::nullopt}, MoveCoords{6, 7, 5, 5, std::nullopt},
+                                       MoveCoords{5, 2, 6, 0, std::nullopt}, MoveCoords{5, 5, 6, 7, std::nullopt}};
+    for (int round = 0; round < 2; ++round) {
+        for (const auto& mv : shuffle) g.makeMove(mv.fromX, mv.fromY, mv.toX, mv.toY);
+    }
+    EXPECT_EQ(g.getRepetitionCount(), 3);
+    g.undoMove();
+    EXPECT_EQ(g.getRepetitionCount(), 2);
+
+    Game replayed;
+    PositionSetup start;
+    ASSERT_TRUE(Game::parseFen(g.getStartFen(), start));
+    ASSERT_TRUE(replayed.replayFrom(start, g.getMoveHistory()));
+    EXPECT_EQ(replayed.fen(), g.fen());
+    EXPECT_EQ(replayed.getRepetitionCount(), 2);
+    EXPECT_EQ(replayed.getPositionHash(), g.getPositionHash());
+}
+
+TEST(SanTest, GeneratesDisambiguationChecksAndCastling) {
+    Game g;
+    ASSERT_TRUE(g.setFen("4k3/8/8/8/8/5N2/8/RN2K2R w K - 0 1"));
+    EXPECT_EQ(toSan(g, MoveCoords{1, 0, 3, 1, std::nullopt}), "Nbd2");
+    EXPECT_EQ(toSan(g, MoveCoords{4, 0, 6, 0, std::nullopt}), "O-O");
+    EXPECT_EQ(toSan(g, MoveCoords{0, 0, 0, 7, std::nullopt}), "Ra8+");
+
+    ASSERT_TRUE(g.setFen("7k/4P1pp/8/8/8/8/8/6K1 w - - 0 1"));
+    EXPECT_EQ(toSan(g, MoveCoords{4, 6, 4, 7, PieceType::Queen}), "e8=Q#");
+}
+
+TEST(PgnTest, ParsesSanAgainstThePosition) {
+    Game g;
+    ASSERT_TRUE(g.setFen("4k3/8/8/8/8/5N2/8/RN2K2R w K - 0 1"));
+    auto nbd2 = parseSan(g, "Nbd2");
+    ASSERT_TRUE(nbd2.has_value());
+    EXPECT_EQ(nbd2->fromX, 1);
+    EXPECT_FALSE(parseSan(g, "Nd2").has_value()); // ambiguous
+    auto castle = parseSan(g, "O-O+");
+    ASSERT_TRUE(castle.has_value());
+    EXPECT_EQ(castle->toX, 6);
+    EXPECT_FALSE(parseSan(g, "O-O-O").has_value());
+
+    ASSERT_TRUE(g.setFen("7k/4P1pp/8/8/8/8/8/6K1 w - - 0 1"));
+    auto promo = parseSan(g, "e8=N");
+    ASSERT_TRUE(promo.has_value());
+    EXPECT_EQ(promo->promotion, PieceType::Knight);
+}
+
+TEST(PgnTest, StreamsGamesAndRoundTripsThroughWriter) {
+    std::istringstream in(
+        "[Event \"One\"]\n[White \"A\"]\n\n"
+        "1. e4 {best by test} e5 (1... c5 2. Nf3 (2. c3) d6) 2. Nf3 $1 Nc6 3.Bb5 a6 ; Ruy\n"
+        "% escaped line\n"
+        "4. Bxc6 dxc6 5. O-O 1/2-1/2\n\n"
+        "[Event \"Two\"]\n[FEN \"4k3/8/8/8/8/8/4P3/4K3 b - - 0 10\"]\n\n10... Kd7 11. e4 *\n"
+        "[Event \"Three\"]\n\n1. d4 d5\n");
+    PgnReader reader(in, 16); // tiny buffer to exercise refills
+    PgnGame pgn;
+
+    ASSERT_TRUE(reader.next(pgn));
+    EXPECT_EQ(pgn.result, "1/2-1/2");
+    ASSERT_EQ(pgn.sanMoves.size(), 9u);
+    EXPECT_EQ(pgn.sanMoves[4], "Bb5");
+    EXPECT_EQ(pgn.sanMoves[8], "O-O");
+    Game g;
+    ASSERT_TRUE(replayPgn(g, pgn));
+    EXPECT_EQ(g.getPlayerName(Color::White), "A");
+    EXPECT_EQ(g.fen(), "r1bqkbnr/1pp2ppp/p1p5/4p3/4P3/5N2/PPPP1PPP/RNBQ1RK1 b kq - 1 5");
+
+    std::ostringstream out;
+    writePgn(out, toPgnGame(g, "1/2-1/2"));
+    std::istringstream again(out.str());
+    PgnReader rereader(again);
+    PgnGame copy;
+    ASSERT_TRUE(rereader.next(copy));
+    EXPECT_EQ(copy.sanMoves, pgn.sanMoves);
+
+    ASSERT_TRUE(reader.next(pgn));
+    EXPECT_TRUE(pgn.blackMovesFirst);
+    EXPECT_EQ(pgn.firstMoveNumber, 10);
+    ASSERT_TRUE(replayPgn(g, pgn));
+    EXPECT_EQ(g.fen(), "8/3k4/8/8/4P3/8/8/4K3 b - e3 0 11");
+
+    ASSERT_TRUE(reader.next(pgn));
+    EXPECT_EQ(pgn.sanMoves.size(), 2u);
+    EXPECT_EQ(pgn.result, "*");
+    EXPECT_FALSE(reader.next(pgn));
+    EXPECT_EQ(reader.gamesRead(), 3u);
+}
+
+TEST(PgnTest, ReaderEndsOnJunkBytesInMovetext) {
+    std::string text = "[Event \"Junk\"]\n\n1. e4 ";
+    text += std::string("\0\0 e5", 5);
+    text += " 2. Nf3\x01 *\n[Event \"Next\"]\n\n1. d4 ";
+    text += '\0';
+    std::istringstream in(text);
+    PgnReader reader(in, 16);
+    PgnGame pgn;
+    size_t games = 0;
+    while (reader.next(pgn) && games < 10) ++games;
+    EXPECT_EQ(games, 2u);
+    EXPECT_EQ(reader.gamesRead(), 2u);
+    EXPECT_LE(pgn.sanMoves.size(), 2u);
+}
+
+TEST(GameDatabaseTest, ExploresMoveStatisticsByPosition) {
+    std::istringstream in(
+        "[White \"A\"]\n[Black \"B\"]\n[WhiteElo \"2000\"]\n[BlackElo \"1800\"]\n\n1. e4 e5 2. Nf3 1-0\n"
+        "[White \"C\"]\n[Black \"D\"]\n[WhiteElo \"2200\"]\n\n1. e4 c5 1/2-1/2\n"
+        "[White \"E\"]\n[Black \"F\"]\n\n1. d4 d5 0-1\n"
+        "[White \"G\"]\n\n1. Nf3 e5 2. Nxe6 *\n"
+        "[White \"H\"]\n\n1. Nf3 Nf6 2. Nc3 Nc6 1-0\n"
+        "[White \"I\"]\n\n1. Nc3 Nc6 2. Nf3 Nf6 3. e4 0-1\n");
+    PgnReader reader(in);
+    PgnGame pgn;
+    GameDatabaseBuilder builder;
+    int rejected = 0;
+    while (reader.next(pgn)) {
+        if (!builder.addGame(pgn)) ++rejected;
+    }
+    EXPECT_EQ(rejected, 1); // Nxe6 is illegal
+    EXPECT_EQ(builder.gameCount(), 5u);
+    const std::string path = "test_games.cdb";
+    ASSERT_TRUE(builder.write(path));
+
+    GameDatabase db;
+    ASSERT_TRUE(db.open(path));
+    EXPECT_EQ(db.gameCount(), 5u);
+
+    Game g;
+    g.start();
+    auto moves = db.explore(g);
+    ASSERT_EQ(moves.size(), 4u);
+    EXPECT_EQ(moves[0].san, "e4");
+    EXPECT_EQ(moves[0].games, 2u);
+    EXPECT_EQ(moves[0].whiteWins, 1u);
+    EXPECT_EQ(moves[0].draws, 1u);
+    EXPECT_DOUBLE_EQ(moves[0].score, 0.75);
+    EXPECT_EQ(moves[0].averageRating, 2100);
+
+    g.makeMove(4, 1, 4, 3); // e4
+    moves = db.explore(g);
+    ASSERT_EQ(moves.size(), 2u);
+    for (const auto& stats : moves) {
+        if (stats.san == "e5") {
+            EXPECT_DOUBLE_EQ(stats.score, 0.0);
+            EXPECT_EQ(stats.averageRating, 1800);
+        } else {
+            EXPECT_EQ(stats.san, "c5");
+            EXPECT_EQ(stats.averageRating, 0);
+        }
+    }
+
+    // Transpositions meet in the same position: 1. Nf3 Nf6 2. Nc3 Nc6 and 1. Nc3 Nc6 2. Nf3 Nf6.
+    Game t;
+    t.start();
+    t.makeMove(6, 0, 5, 2);
+    t.makeMove(6, 7, 5, 5);
+    t.makeMove(1, 0, 2, 2);
+    t.makeMove(1, 7, 2, 5);
+    auto games = db.gamesAt(t);
+    ASSERT_EQ(games.size(), 2u);
+    moves = db.explore(t);
+    ASSERT_EQ(moves.size(), 1u);
+    EXPECT_EQ(moves[0].san, "e4");
+    EXPECT_EQ(moves[0].games, 1u);
+
+    auto stored = db.loadGame(games[1].game);
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(stored->white, "I");
+    EXPECT_EQ(stored->result, GameResult::BlackWins);
+    ASSERT_EQ(stored->moves.size(), 5u);
+    EXPECT_EQ(stored->moves[4].toX, 4);
+    EXPECT_EQ(games[1].ply, 4);
+    EXPECT_FALSE(db.loadGame(5).has_value());
+
+    db.close();
+    RemoveFile(path);
+}
+
+TEST(SearchTest, FindsMateInOne) {
+    Game g;
+    ASSERT_TRUE(g.setFen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"));
+    Searcher searcher;
+    SearchLimits limits;
+    limits.depth = 2;
+    auto result = searcher.search(g, limits);
+    ASSERT_TRUE(result.best.has_value());
+    EXPECT_EQ(toUci(*result.best), "a1a8");
+    EXPECT_GE(result.score, Searcher::kMateScore - 10);
+    EXPECT_EQ(g.fen(), "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+}
+
+TEST(SearchTest, ReportsEveryCompletedIteration) {
+    Game g;
+    g.start();
+    Searcher searcher;
+    std::vector<int> depths;
+    long long lastNodes = 0;
+    searcher.setIterationCallback([&](const SearchResult& iteration) {
+        depths.push_back(iteration.depth);
+        EXPECT_TRUE(iteration.best.has_value());
+        EXPECT_GE(iteration.nodes, lastNodes);
+        lastNodes = iteration.nodes;
+    });
+    SearchLimits limits;
+    limits.depth = 3;
+    auto result = searcher.search(g, limits);
+    EXPECT_EQ(depths, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(result.nodes, lastNodes);
+}
+
+TEST(HashTest, TranspositionsHashEqualAndSideToMoveMatters) {
+    Game a;
+    a.start();
+    a.makeMove(6, 0, 5, 2); // Nf3
+    a.makeMove(6, 7, 5, 5); // ...Nf6
+    a.makeMove(1, 0, 2, 2); // Nc3
+
+    Game b;
+    b.start();
+    b.makeMove(1, 0, 2, 2); // Nc3
+    b.makeMove(6, 7, 5, 5); // ...Nf6
+    b.makeMove(6, 0, 5, 2); // Nf3
+    EXPECT_EQ(a.getPositionHash(), b.getPositionHash());
+
+    Game c;
+    ASSERT_TRUE(c.setFen(a.fen()));
+    EXPECT_EQ(c.getPositionHash(), a.getPositionHash());
+
+    Game start;
+    start.start();
+    Game flipped;
+    ASSERT_TRUE(flipped.setFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1"));
+    EXPECT_NE(start.getPositionHash(), flipped.getPositionHash());
+}
+
+TEST(AnnotatorTest, FlagsHangingQueenAsBlunder) {
+    std::vector<MoveCoords> moves;
+    for (const char* uci : {"e2e4", "e7e5", "d1h5", "b8c6", "h5f7", "e8f7"}) moves.push_back(*parseUci(uci));
+
+    SearchLimits limits;
+    limits.depth = 2;
+    Annotator annotator;
+    auto notes = annotator.annotateNative(4, "", moves, limits);
+    ASSERT_EQ(notes.size(), moves.size());
+    EXPECT_EQ(notes[4].san, "Qxf7+");
+    EXPECT_EQ(notes[4].quality, MoveQuality::Blunder);
+    EXPECT_NE(notes[0].quality, MoveQuality::Blunder);
+
+    Game g;
+    g.start();
+    std::ostringstream pgn;
+    Annotator::writePgn(pgn, g, "", notes);
+    EXPECT_NE(pgn.str().find("$4 {"), std::string::npos);
+    EXPECT_NE(pgn.str().find("best was"), std::string::npos);
+}
+
+TEST(MoveJournalTest, RecoversMovesUndosAndIgnoresTornTail) {
+    const std::string path = "test_journal.journal";
+    Game g;
+    g.start();
+    g.setPlayerName(Color::White, "Alice");
+    {
+        MoveJournal journal;
+        ASSERT_TRUE(journal.open(path, g));
+        g.makeMove(4, 1, 4, 3); // e4
+        g.makeMove(4, 6, 4, 4); // e5
+        ASSERT_TRUE(journal.update(g));
+        g.undoMove();
+        g.makeMove(2, 6, 2, 4); // c5 instead
+        g.makeMove(6, 0, 5, 2); // Nf3
+        ASSERT_TRUE(journal.update(g));
+        EXPECT_EQ(journal.pendingRecords(), 5u);
+        // No close(): the destructor only syncs, like a process that dies after the last append.
+    }
+    std::uintmax_t size = std::filesystem::file_size(path);
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn.write("M\x01", 2);
+    }
+
+    Game recovered;
+    ASSERT_TRUE(MoveJournal::recover(path, recovered));
+    EXPECT_EQ(recovered.fen(), g.fen());
+    EXPECT_EQ(recovered.getPlayerName(Color::White), "Alice");
+    EXPECT_EQ(recovered.getMoveHistory().size(), 3u);
+
+    // Compaction folds the records into a snapshot.
+    MoveJournal::Options options;
+    options.compactAfter = 2;
+    MoveJournal journal(options);
+    ASSERT_TRUE(journal.open(path, recovered));
+    recovered.makeMove(1, 7, 2, 5); // Nc6
+    ASSERT_TRUE(journal.update(recovered));
+    recovered.makeMove(3, 1, 3, 3); // d4
+    recovered.makeMove(2, 4, 3, 3); // cxd4
+    ASSERT_TRUE(journal.update(recovered));
+    EXPECT_EQ(journal.pendingRecords(), 0u);
+    EXPECT_LT(std::filesystem::file_size(path), size + 16);
+
+    Game again;
+    ASSERT_TRUE(MoveJournal::recover(path, again));
+    EXPECT_EQ(again.fen(), recovered.fen());
+    again.undoMove();
+    recovered.undoMove();
+    EXPECT_EQ(again.fen(), recovered.fen());
+
+    journal.close();
+    RemoveFile(path);
+    Game none;
+    EXPECT_FALSE(MoveJournal::recover(path, none));
+}
+
+TEST(MoveJournalTest, RecordsChangesBelowAnUnchangedTail) {
+    const std::string path = "test_journal_tail.journal";
+    Game g;
+    g.start();
+    MoveJournal journal;
+    ASSERT_TRUE(journal.open(path, g));
+    g.makeMove(4, 1, 4, 3); // e4
+    g.makeMove(4, 6, 4, 4); // e5
+    g.makeMove(6, 0, 5, 2); // Nf3
+    ASSERT_TRUE(journal.update(g));
+    ASSERT_TRUE(journal.update(g));
+    EXPECT_EQ(journal.pendingRecords(), 3u);
+
+    // Same length and same last move, but a different move at ply 2.
+    g.undoMove();
+    g.undoMove();
+    g.makeMove(2, 6, 2, 4); // c5
+    g.makeMove(6, 0, 5, 2); // Nf3
+    ASSERT_TRUE(journal.update(g));
+    EXPECT_EQ(journal.pendingRecords(), 7u);
+    journal.close();
+
+    Game recovered;
+    ASSERT_TRUE(MoveJournal::recover(path, recovered));
+    EXPECT_EQ(recovered.fen(), g.fen());
+    RemoveFile(path);
+}
+
+TEST(GameTest, SaveToFileReportsFailure) {
+    Game g;
+    g.start();
+    EXPECT_FALSE(g.saveToFile("no_such_dir/save.json"));
+    EXPECT_FALSE(g.saveToFile("no_such_dir/save.fen"));
+    const std::string path = "test_save_ok.json";
+    EXPECT_TRUE(g.saveToFile(path));
+    RemoveFile(path);
+}
+
+TEST(TrainingDataTest, ShardsRoundTripRecordsAndDedupe) {
+    Game g;
+    ASSERT_TRUE(g.setFen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3"));
+    TrainingRecord first;
+    first.position = g.getPosition();
+    first.score = 35;
+    first.result = 1;
+    first.ply = 4;
+    TrainingRecord second = first;
+    second.score = -40000; // clamped
+    second.result = -1;
+    second.ply = 300;      // capped
+
+    const std::string prefix = "test_training";
+    {
+        TrainingDataWriter writer(prefix, 2);
+        ASSERT_TRUE(writer.write({first, second, first}));
+        EXPECT_EQ(writer.recordsWritten(), 3u);
+        EXPECT_EQ(writer.shardCount(), 2u);
+    }
+    std::vector<TrainingRecord> records;
+    ASSERT_TRUE(readTrainingShard(TrainingDataWriter::shardPath(prefix, 0), records));
+    ASSERT_TRUE(readTrainingShard(TrainingDataWriter::shardPath(prefix, 1), records));
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(std::filesystem::file_size(TrainingDataWriter::shardPath(prefix, 0)), 8 + 2 * kTrainingRecordSize);
+    EXPECT_EQ(records[0].score, 35);
+    EXPECT_EQ(records[0].result, 1);
+    EXPECT_EQ(records[0].ply, 4);
+    EXPECT_EQ(records[1].score, -32767);
+    EXPECT_EQ(records[1].result, -1);
+    EXPECT_EQ(records[1].ply, 255);
+    Game restored;
+    restored.setPosition(records[2].position);
+    EXPECT_EQ(restored.fen(), g.fen());
+    RemoveFile(TrainingDataWriter::shardPath(prefix, 0));
+    RemoveFile(TrainingDataWriter::shardPath(prefix, 1));
+
+    PositionDeduper seen;
+    EXPECT_TRUE(seen.insert(g.getPositionHash()));
+    EXPECT_FALSE(seen.insert(g.getPositionHash()));
+    EXPECT_TRUE(seen.insert(~g.getPositionHash()));
+    EXPECT_EQ(seen.size(), 2u);
+}
+
+TEST(JsonSaveTest, StreamsArchiveWithoutDom) {
+    const std::string path = "test_archive_game.json";
+    Game played;
+    played.start();
+    played.setPlayerName(Color::Black, "Bob");
+    played.makeMove(4, 1, 4, 3); // e4
+    played.makeMove(3, 6, 3, 4); // d5
+    played.makeMove(4, 3, 4, 4); // e5
+    played.makeMove(5, 6, 5, 4); // f5
+    played.saveToFile(path, SaveFormat::Json);
+    std::ifstream saved(path);
+    nlohmann::json document = nlohmann::json::parse(saved);
+    RemoveFile(path);
+
+    // Old saves carry only the board snapshot.
+    nlohmann::json legacy = document;
+    legacy.erase("moves");
+    legacy.erase("start_fen");
+    legacy.erase("fen");
+
+    std::istringstream archive(document.dump() + "\n\n{\"turn\": \"white\", \n" + legacy.dump() + "\n" +
+                               document.dump() + "\n");
+    JsonSaveArchiveReader reader(archive);
+    Game g;
+    ASSERT_TRUE(reader.next(g));
+    EXPECT_EQ(g.fen(), played.fen());
+    EXPECT_EQ(g.getPlayerName(Color::Black), "Bob");
+    ASSERT_EQ(g.getMoveHistory().size(), 4u);
+    g.makeMove(4, 4, 5, 5); // exf6 en passant still available
+    EXPECT_EQ(g.getBoard().getPieceAt(5, 4), nullptr);
+
+    ASSERT_TRUE(reader.next(g));
+    EXPECT_EQ(g.fen(), played.fen());
+    EXPECT_TRUE(g.getMoveHistory().empty());
+
+    JsonSaveRecord record;
+    ASSERT_TRUE(reader.next(record));
+    EXPECT_EQ(record.moves.size(), 4u);
+    EXPECT_EQ(record.board[4][4], 'P');
+    EXPECT_EQ(record.enPassantX, 5);
+    EXPECT_EQ(record.enPassantY, 5);
+    EXPECT_FALSE(reader.next(record));
+    EXPECT_EQ(reader.gamesRead(), 3u);
+    EXPECT_EQ(reader.errors(), 1u); // the truncated line
+}
+
+TEST(GameSessionManagerTest, EvictsAndRestoresGamesTransparently) {
+    for (bool spillToDisk : {false, true}) {
+        GameSessionManager::Options options;
+        options.shards = 4;
+        options.maxResident = 8;
+        options.poolSize = 8;
+        options.idleTimeout = std::chrono::seconds(60);
+        if (spillToDisk) options.spillDirectory = "test_sessions";
+        GameSessionManager manager(options);
+
+        std::vector<SessionId> ids;
+        for (int i = 0; i < 40; ++i) {
+            ids.push_back(manager.create());
+            ASSERT_TRUE(manager.withGame(ids.back(), [&](Game& game) {
+                game.makeMove(i % 8, 1, i % 8, 3); // a different double pawn push per file
+                game.setPlayerName(Color::White, "player" + std::to_string(i));
+            }));
+        }
+        SessionStats stats = manager.stats();
+        EXPECT_EQ(stats.sessions, 40u);
+        EXPECT_LE(stats.resident, 8u);
+        EXPECT_EQ(stats.evicted, 40u - stats.resident);
+
+        // The first game was evicted long ago; touching it brings it back with its history.
+        std::string fen;
+        ASSERT_TRUE(manager.withGame(ids[0], [&](Game& game) {
+            EXPECT_EQ(game.getPlayerName(Color::White), "player0");
+            ASSERT_EQ(game.getMoveHistory().size(), 1u);
+            game.undoMove();
+            fen = game.fen();
+        }));
+        EXPECT_EQ(fen, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        EXPECT_GE(manager.stats().restores, 1u);
+
+        EXPECT_TRUE(manager.close(ids[0]));
+        EXPECT_FALSE(manager.contains(ids[0]));
+        EXPECT_FALSE(manager.withGame(ids[0], [](Game&) {}));
+        EXPECT_FALSE(manager.close(ids[0]));
+
+        size_t idle = manager.evictIdle(GameSessionManager::Clock::now() + std::chrono::seconds(61));
+        stats = manager.stats();
+        EXPECT_EQ(stats.resident, 0u);
+        EXPECT_GT(idle, 0u);
+        EXPECT_EQ(stats.sessions, 39u);
+        EXPECT_GT(stats.pooled, 0u);
+
+        // New sessions reuse pooled games but start clean.
+        SessionId fresh = manager.create();
+        ASSERT_TRUE(manager.withGame(fresh, [&](Game& game) {
+            EXPECT_EQ(game.getPlayerName(Color::White), "White");
+            EXPECT_TRUE(game.getMoveHistory().empty());
+        }));
+        ASSERT_TRUE(manager.withGame(ids[39], [&](Game& game) {
+            EXPECT_EQ(game.getPlayerName(Color::White), "player39");
+        }));
+    }
+    EXPECT_TRUE(std::filesystem::is_empty("test_sessions"));
+    std::filesystem::remove_all("test_sessions");
+}
+
+TEST(LatencyHistogramTest, PercentilesStayWithinBucketPrecision) {
+    LatencyHistogram low, high;
+    for (uint64_t v = 1; v <= 10000; ++v) (v <= 5000 ? low : high).record(v * 1000);
+    EXPECT_EQ(low.count(), 5000u);
+    low.merge(high);
+    EXPECT_EQ(low.count(), 10000u);
+    EXPECT_EQ(low.min(), 1000u);
+    EXPECT_EQ(low.max(), 10000000u);
+    EXPECT_NEAR(low.mean(), 5000500.0, 1.0);
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        double exact = q * 10000 * 1000;
+        EXPECT_NEAR(static_cast<double>(low.percentile(q)), exact, exact * 0.035) << q;
+    }
+    EXPECT_EQ(low.percentile(1.0), 10000000u);
+
+    // Buckets tile the whole range without gaps.
+    for (size_t i = 1; i < LatencyHistogram::buckets(); ++i) {
+        ASSERT_EQ(LatencyHistogram::lowerBound(i), LatencyHistogram::upperBound(i - 1) + 1) << i;
+    }
+    LatencyHistogram extremes;
+    extremes.record(0);
+    extremes.record(UINT64_MAX);
+    EXPECT_EQ(extremes.percentile(0.5), 0u);
+    EXPECT_EQ(extremes.percentile(1.0), UINT64_MAX);
+}
+
+TEST(MetricsTest, RecordsOperationsFromAllThreads) {
+    resetMetrics();
+    auto play = [] {
+        Game game;
+        game.start();
+        game.makeMove(4, 1, 4, 3);
+        game.undoMove();
+        game.isCheckmate();
+        game.isStalemate();
+    };
+    play();
+    std::thread other(play);
+    other.join();
+
+    auto snapshot = metricsSnapshot();
+    ASSERT_EQ(snapshot.size(), static_cast<size_t>(MetricOp::Count));
+    const LatencyHistogram& moves = snapshot[static_cast<size_t>(MetricOp::MakeMove)].latency;
+    std::string text = formatPrometheusMetrics();
+    if (!metricsEnabled()) {
+        EXPECT_EQ(moves.count(), 0u);
+        return;
+    }
+    // The exited thread's samples survive it.
+    EXPECT_EQ(moves.count(), 2u);
+    EXPECT_EQ(snapshot[static_cast<size_t>(MetricOp::UndoMove)].latency.count(), 2u);
+    EXPECT_EQ(snapshot[static_cast<size_t>(MetricOp::IsStalemate)].latency.count(), 2u);
+    EXPECT_EQ(snapshot[static_cast<size_t>(MetricOp::SaveToFile)].latency.count(), 0u);
+    EXPECT_STREQ(snapshot[static_cast<size_t>(MetricOp::MakeMove)].name, "make_move");
+
+    EXPECT_NE(text.find("# TYPE chess_operation_duration_seconds histogram"), std::string::npos);
+    EXPECT_NE(text.find("chess_operation_duration_seconds_count{op=\"make_move\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("chess_operation_duration_seconds_bucket{op=\"undo_move\",le=\"+Inf\"} 2\n"),
+              std::string::npos);
+
+    resetMetrics();
+    EXPECT_EQ(metricsSnapshot()[static_cast<size_t>(MetricOp::MakeMove)].latency.count(), 0u);
+}
+
+TEST(GameStatusTest, CachedStatusFollowsMakeUndoAndSetup) {
+    Game game;
+    game.start();
+    EXPECT_EQ(game.getStatus(), GameStatus::Ongoing);
+    EXPECT_EQ(game.getLegalMoves().size(), 20u);
+
+    // Fool's mate, with status queried at every ply so stale entries would show.
+    const int moves[][4] = {{5, 1, 5, 2}, {4, 6, 4, 4}, {6, 1, 6, 3}, {3, 7, 7, 3}};
+    for (const auto& m : moves) {
+        EXPECT_FALSE(game.getLegalMoves().empty());
+        EXPECT_EQ(game.getStatus(), GameStatus::Ongoing);
+        game.makeMove(m[0], m[1], m[2], m[3]);
+    }
+    EXPECT_EQ(game.getMoveCount(), 4);
+    EXPECT_EQ(game.getStatus(), GameStatus::Checkmate);
+    EXPECT_TRUE(game.isCheckmate());
+    EXPECT_FALSE(game.isStalemate());
+    EXPECT_TRUE(game.getLegalMoves().empty());
+
+    // A rejected move leaves the position, and so its status, unchanged.
+    game.makeMove(4, 0, 5, 1);
+    EXPECT_EQ(game.getStatus(), GameStatus::Checkmate);
+
+    game.undoMove();
+    EXPECT_EQ(game.getStatus(), GameStatus::Ongoing);
+    EXPECT_FALSE(game.isCheckmate());
+    game.makeMove(3, 7, 7, 3);
+    EXPECT_TRUE(game.isCheckmate());
+
+    ASSERT_TRUE(game.setFen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"));
+    EXPECT_TRUE(game.isStalemate());
+    EXPECT_EQ(game.getStatus(), GameStatus::Stalemate);
+
+    ASSERT_TRUE(game.setFen("4k3/8/8/8/8/8/8/4R1K1 b - - 0 1"));
+    EXPECT_EQ(game.getStatus(), GameStatus::Check);
+    EXPECT_FALSE(game.isCheckmate());
+    EXPECT_FALSE(game.isStalemate());
+    EXPECT_EQ(game.getLegalMoves().size(), 4u);
+}
+
+TEST(GameStatusTest, LegalTargetsAndMoveStatusCodes) {
+    Game game;
+    game.start();
+    EXPECT_EQ(game.legalTargets(1, 0), (uint64_t{1} << 16) | (uint64_t{1} << 18)); // Nb1: a3, c3
+    EXPECT_EQ(game.legalTargets(4, 1), (uint64_t{1} << 20) | (uint64_t{1} << 28)); // e2: e3, e4
+    EXPECT_EQ(game.legalTargets(4, 6), 0u);
+    EXPECT_EQ(game.legalTargets(4, 4), 0u);
+    EXPECT_EQ(game.legalTargets(-1, 9), 0u);
+
+    EXPECT_EQ(game.makeMove(8, 0, 4, 3), MoveStatus::OffBoard);
+    EXPECT_EQ(game.makeMove(4, 3, 4, 4), MoveStatus::NoPiece);
+    EXPECT_EQ(game.makeMove(4, 6, 4, 4), MoveStatus::NotYourTurn);
+    EXPECT_EQ(game.makeMove(4, 1, 4, 4), MoveStatus::IllegalMove);
+    EXPECT_EQ(game.getMoveCount(), 0);
+
+    // A pinned bishop, with and without the legal list cached.
+    for (bool cached : {true, false}) {
+        ASSERT_TRUE(game.setFen("4k3/4r3/8/8/8/8/4B3/4K3 w - - 0 1"));
+        if (cached) {
+            EXPECT_EQ(game.legalTargets(4, 1), 0u);
+        }
+        EXPECT_EQ(game.makeMove(4, 1, 3, 2), MoveStatus::LeavesKingInCheck) << cached;
+        EXPECT_EQ(game.makeMove(4, 0, 3, 0), MoveStatus::Ok) << cached;
+        EXPECT_EQ(game.getMoveCount(), 1);
+    }
+
+    // Both validation paths agree on every from/to pair along a game with castling and en passant.
+    const char* line[] = {"e2e4", "a7a6", "e4e5", "d7d5", "e5d6", "c7d6", "g1f3", "b8c6", "f1c4", "g8f6", "e1g1"};
+    Game lookup, direct;
+    lookup.start();
+    direct.start();
+    for (const char* uci : line) {
+        for (int from = 0; from < 64; ++from) {
+            for (int to = 0; to < 64; ++to) {
+                lookup.getLegalMoves();
+                MoveStatus viaList = lookup.makeMove(from % 8, from / 8, to % 8, to / 8);
+                if (viaList == MoveStatus::Ok) lookup.undoMove();
+                MoveStatus viaChecks = direct.makeMove(from % 8, from / 8, to % 8, to / 8);
+                if (viaChecks == MoveStatus::Ok) direct.undoMove();
+                ASSERT_EQ(viaList == MoveStatus::Ok, viaChecks == MoveStatus::Ok) << uci << " " << from << "-" << to;
+            }
+        }
+        auto move = parseUci(uci);
+        ASSERT_TRUE(move.has_value());
+        ASSERT_EQ(lookup.makeMove(move->fromX, move->fromY, move->toX, move->toY), MoveStatus::Ok) << uci;
+        ASSERT_EQ(direct.makeMove(move->fromX, move->fromY, move->toX, move->toY), MoveStatus::Ok) << uci;
+    }
+    EXPECT_EQ(lookup.fen(), direct.fen());
+}
+
+TEST(GameStatusTest, ApplyMovesStopsAtFirstBadMoveAndUncheckedMatches) {
+    Game game;
+    game.start();
+    std::vector<std::string> line = {"e2e4", "e7e5", "g1f3", "b8c6", "f1b5", "a7a6", "e1g1"};
+    EXPECT_EQ(game.applyMoves(line), line.size());
+    EXPECT_EQ(game.fen(), "r1bqkbnr/1ppp1ppp/p1n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQ1RK1 b kq - 1 4");
+
+    Game partial;
+    partial.start();
+    std::string_view bad[] = {"e2e4", "e7e5", "e1e3", "g1f3"};
+    EXPECT_EQ(partial.applyMoves(bad, 4), 2u);
+    EXPECT_EQ(partial.getMoveCount(), 2);
+    std::string_view garbage[] = {"g1f3", "zz"};
+    EXPECT_EQ(partial.applyMoves(garbage, 2), 1u);
+
+    Game unchecked;
+    unchecked.start();
+    ASSERT_TRUE(unchecked.applyMovesUnchecked(game.getMoveHistory()));
+    EXPECT_EQ(unchecked.fen(), game.fen());
+    EXPECT_EQ(unchecked.getPositionHash(), game.getPositionHash());
+    unchecked.undoMove();
+    EXPECT_EQ(unchecked.getMoveCount(), 6);
+    std::string_view castle = line.back();
+    EXPECT_EQ(unchecked.applyMoves(&castle, 1), 1u);
+    EXPECT_EQ(unchecked.fen(), game.fen());
+
+    MoveCoords offBoard{4, 1, 4, 8, std::nullopt};
+    EXPECT_FALSE(unchecked.applyMovesUnchecked(&offBoard, 1));
+
+    // A bad move in the middle still publishes the moves played before it.
+    Game published;
+    published.setSnapshotPublishing(true);
+    published.start();
+    std::vector<MoveCoords> broken = {*parseUci("e2e4"), *parseUci("e7e5"), offBoard, *parseUci("g1f3")};
+    EXPECT_FALSE(published.applyMovesUnchecked(broken));
+    EXPECT_EQ(published.getMoveCount(), 2);
+    ASSERT_NE(published.snapshot(), nullptr);
+    EXPECT_EQ(published.snapshot()->ply, 2);
+    EXPECT_EQ(published.snapshot()->fen, published.fen());
+}
+
+TEST(GameSnapshotTest, ReadersSeeWholePositionsWhileTheOwnerPlays) {
+    Game game;
+    EXPECT_EQ(game.snapshot(), nullptr);
+    game.setSnapshotPublishing(true);
+    game.start();
+    auto initial = game.snapshot();
+    ASSERT_NE(initial, nullptr);
+    EXPECT_EQ(initial->fen, game.fen());
+    EXPECT_EQ(initial->ply, 0);
+    EXPECT_FALSE(initial->lastMove.has_value());
+
+    // A refused move, including the trial apply of one that leaves the king in check, publishes nothing.
+    ASSERT_TRUE(game.setFen("4k3/4r3/8/8/8/8/4B3/4K3 w - - 0 1"));
+    auto pinned = game.snapshot();
+    EXPECT_EQ(game.makeMove(4, 1, 3, 2), MoveStatus::LeavesKingInCheck);
+    EXPECT_EQ(game.snapshot(), pinned);
+    EXPECT_EQ(pinned->status, GameStatus::Ongoing);
+
+    game.start();
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> reads{0};
+    std::thread reader([&] {
+        Game check;
+        while (!done) {
+            auto seen = game.snapshot();
+            // Every snapshot must be one consistent position: its FEN, hash and ply agree.
+            if (!check.setFen(seen->fen) || check.getPositionHash() != seen->hash ||
+                (seen->ply % 2 == 0) != seen->position.whiteToMove) {
+                ++torn;
+            }
+            ++reads;
+        }
+    });
+    for (int round = 0; round < 50; ++round) {
+        ASSERT_EQ(game.applyMoves({"e2e4", "e7e5", "f1c4", "b8c6", "d1h5", "g8f6", "h5f7"}), 7u);
+        auto mate = game.snapshot();
+        EXPECT_EQ(mate->status, GameStatus::Checkmate);
+        EXPECT_EQ(mate->ply, 7);
+        ASSERT_TRUE(mate->lastMove.has_value());
+        EXPECT_EQ(toUci(*mate->lastMove), "h5f7");
+        for (int ply = 0; ply < 7; ++ply) game.undoMove();
+        EXPECT_EQ(game.snapshot()->fen, initial->fen);
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(torn, 0);
+    EXPECT_GT(reads, 0);
+    EXPECT_EQ(initial->ply, 0); // old snapshots stay valid
+
+    // Once nobody holds a replaced snapshot, the next publish frees it.
+    std::weak_ptr<const GameSnapshot> replaced = game.snapshot();
+    game.applyMoves({"e2e4"});
+    EXPECT_TRUE(replaced.expired());
+}
+
+TEST(GameTreeTest, JumpsAnywhereWithinTheCheckpointInterval) {
+    const int kInterval = 8;
+    GameTree tree(kInterval);
+    // A long pseudo-random game, with the FEN of every ply for reference.
+    Game reference;
+    reference.start();
+    std::vector<std::string> fens = {reference.fen()};
+    std::vector<uint64_t> hashes = {reference.getPositionHash()};
+    for (int ply = 0; ply < 200; ++ply) {
+        auto moves = reference.getLegalMoves();
+        if (moves.empty()) break;
+        MoveCoords move = moves[static_cast<size_t>(ply * 13 + 5) % moves.size()];
+        if (move.promotion) move.promotion = PieceType::Knight;
+        ASSERT_EQ(reference.makeMove(move.fromX, move.fromY, move.toX, move.toY, move.promotion.value_or(PieceType::Queen)),
+                  MoveStatus::Ok);
+        ASSERT_EQ(tree.play(move), MoveStatus::Ok) << ply;
+        fens.push_back(reference.fen());
+        hashes.push_back(reference.getPositionHash());
+    }
+    int length = static_cast<int>(fens.size()) - 1;
+    ASSERT_GT(length, 100);
+    ASSERT_EQ(tree.lineLength(), length);
+    auto line = tree.line();
+    auto history = reference.getMoveHistory();
+    ASSERT_EQ(line.size(), history.size());
+    for (size_t i = 0; i < line.size(); ++i) EXPECT_EQ(toUci(line[i]), toUci(history[i])) << i;
+
+    for (int ply : {5, length, 0, length / 2, length / 2 + 3, length - 1, 17, 1, 96, 9}) {
+        ASSERT_TRUE(tree.goToPly(ply));
+        EXPECT_EQ(tree.ply(), ply);
+        EXPECT_EQ(tree.game().fen(), fens[static_cast<size_t>(ply)]) << ply;
+        EXPECT_EQ(tree.game().getPositionHash(), hashes[static_cast<size_t>(ply)]) << ply;
+        EXPECT_LE(tree.lastSteps(), kInterval) << ply;
+        EXPECT_EQ(tree.lineLength(), length);
+    }
+    EXPECT_FALSE(tree.goToPly(length + 1));
+
+    ASSERT_TRUE(tree.goToPly(10));
+    ASSERT_TRUE(tree.undo());
+    EXPECT_EQ(tree.game().fen(), fens[9]);
+    ASSERT_TRUE(tree.redo());
+    ASSERT_TRUE(tree.redo());
+    EXPECT_EQ(tree.game().fen(), fens[11]);
+    EXPECT_EQ(tree.lastSteps(), 1);
+}
+
+TEST(GameTreeTest, KeepsVariationsAndRedoFollowsTheLastVisited) {
+    GameTree tree(4);
+    auto uci = [](const char* text) { return *parseUci(text); };
+    ASSERT_EQ(tree.playLine({uci("e2e4"), uci("e7e5"), uci("g1f3"), uci("b8c6"), uci("f1b5")}), 5u);
+    GameTree::NodeId mainEnd = tree.current();
+    ASSERT_TRUE(tree.goToPly(2));
+    GameTree::NodeId branch = tree.current();
+    ASSERT_EQ(tree.playLine({uci("f2f4"), uci("e5f4"), uci("e1e3")}), 2u);
+    EXPECT_EQ(tree.children(branch).size(), 2u);
+    EXPECT_EQ(tree.lineLength(), 4);
+
+    // Playing a move that is already in the tree follows it instead of adding a node.
+    size_t nodes = tree.size();
+    ASSERT_TRUE(tree.goTo(branch));
+    EXPECT_EQ(tree.play(uci("g1f3")), MoveStatus::Ok);
+    EXPECT_EQ(tree.size(), nodes);
+    EXPECT_EQ(tree.lineLength(), 5);
+    ASSERT_TRUE(tree.goToPly(5));
+    EXPECT_EQ(tree.current(), mainEnd);
+
+    ASSERT_TRUE(tree.goToPly(2));
+    ASSERT_TRUE(tree.goTo(tree.children(branch)[1]));
+    ASSERT_TRUE(tree.redo());
+    EXPECT_EQ(tree.game().fen(), "rnbqkbnr/pppp1ppp/8/8/4Pp2/8/PPPP2PP/RNBQKBNR w KQkq - 0 3");
+    EXPECT_FALSE(tree.redo());
+    EXPECT_EQ(tree.play(uci("a1a5")), MoveStatus::IllegalMove);
+    EXPECT_EQ(tree.size(), nodes);
+
+    ASSERT_TRUE(tree.setFen("4k3/8/8/8/8/8/8/4K3 w - - 0 1"));
+    EXPECT_EQ(tree.size(), 1u);
+    EXPECT_FALSE(tree.undo());
+}
+
+TEST(GameStatusTest, LegalListsSurviveOnlyForTheCurrentPlyAndItsParent) {
+    Game game;
+    game.start();
+    EXPECT_EQ(game.getLegalMoves().size(), 20u);
+    ASSERT_EQ(game.makeMove(4, 1, 4, 3), MoveStatus::Ok);
+    EXPECT_EQ(game.getLegalMoves().size(), 20u);
+    ASSERT_EQ(game.makeMove(3, 6, 3, 4), MoveStatus::Ok);
+    EXPECT_EQ(game.getLegalMoves().size(), 31u);
+    // The ply-0 slot was reused for ply 2; going back recomputes it.
+    game.undoMove();
+    game.undoMove();
+    EXPECT_EQ(game.getLegalMoves().size(), 20u);
+    EXPECT_EQ(game.legalTargets(6, 0), (uint64_t{1} << 21) | (uint64_t{1} << 23));
+
+    // A new position never inherits a list cached at the same ply of the old one.
+    ASSERT_TRUE(game.setFen("4k3/8/8/8/8/8/8/4K2R w K - 0 1"));
+    EXPECT_EQ(game.getLegalMoves().size(), 15u);
+    EXPECT_EQ(game.makeMove(4, 0, 6, 0), MoveStatus::Ok);
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+// Runs chess_server on a Unix socket in a scratch directory for the lifetime of the object.
+class ServerProcess {
+public:
+    ServerProcess() {
+        directory = std::filesystem::temp_directory_path() / ("chess_server_test_" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+        socketPath = (directory / "server.sock").string();
+        std::string saves = (directory / "saves").string();
+        pid = fork();
+        if (pid == 0) {
+            execl(CHESS_SERVER_PATH, CHESS_SERVER_PATH, "--port", "0", "--unix", socketPath.c_str(), "--workers", "2",
+                  "--engine-threads", "1", "--save-dir", saves.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+    }
+    ~ServerProcess() {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            int status = 0;
+            waitpid(pid, &status, 0);
+        }
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+
+    int connect() const {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+            if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return fd;
+            close(fd);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        return -1;
+    }
+
+    std::filesystem::path directory;
+    std::string socketPath;
+    pid_t pid = -1;
+};
+
+// Sends the whole script at once and reads one reply line per request.
+std::vector<std::string> Exchange(int fd, const std::vector<std::string>& script) {
+    std::string out;
+    for (const auto& line : script) out += line + "\n";
+    EXPECT_EQ(write(fd, out.data(), out.size()), static_cast<ssize_t>(out.size()));
+    std::vector<std::string> replies;
+    std::string buffer;
+    char chunk[4096];
+    while (replies.size() < script.size()) {
+        ssize_t got = read(fd, chunk, sizeof(chunk));
+        if (got <= 0) break;
+        buffer.append(chunk, static_cast<size_t>(got));
+        for (size_t newline; (newline = buffer.find('\n')) != std::string::npos; buffer.erase(0, newline + 1)) {
+            replies.push_back(buffer.substr(0, newline));
+        }
+    }
+    return replies;
+}
+} // namespace
+
+TEST(ChessServerTest, AnswersPipelinedRequestsInOrder) {
+    ServerProcess server;
+    int fd = server.connect();
+    ASSERT_GE(fd, 0);
+    auto replies = Exchange(fd, {"new", "move 1 f2f3", "move 1 e7e5", "move 1 g2g4", "move 1 e2e4", "move 1 d8h4",
+                                 "undo 1", "state 1", "engine 1", "save 1", "state 42", "close 1", "state 1"});
+    close(fd);
+    ASSERT_EQ(replies.size(), 13u);
+    EXPECT_EQ(replies[0], "ok 1");
+    EXPECT_EQ(replies[1], "ok ongoing rnbqkbnr/pppppppp/8/8/8/5P2/PPPPP1PP/RNBQKBNR b KQkq - 0 1");
+    EXPECT_EQ(replies[4], "error illegal move e2e4: not your turn");
+    EXPECT_EQ(replies[5], "ok checkmate rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+    EXPECT_EQ(replies[6], replies[3]);
+    EXPECT_EQ(replies[7], replies[3]);
+    EXPECT_EQ(replies[8].rfind("ok ", 0), 0u);
+    EXPECT_EQ(replies[9], "ok " + (server.directory / "saves" / "1.bin").string());
+    EXPECT_TRUE(std::filesystem::exists(server.directory / "saves" / "1.bin"));
+    EXPECT_EQ(replies[10], "error no such game");
+    EXPECT_EQ(replies[11], "ok");
+    EXPECT_EQ(replies[12], "error no such game");
+}
+
+TEST(ChessServerTest, ServesConcurrentClients) {
+    ServerProcess server;
+    std::vector<std::thread> clients;
+    std::vector<int> finished(8, 0);
+    for (size_t i = 0; i < finished.size(); ++i) {
+        clients.emplace_back([&, i] {
+            int fd = server.connect();
+            if (fd < 0) return;
+            auto created = Exchange(fd, {"new"});
+            if (created.size() == 1 && created[0].rfind("ok ", 0) == 0) {
+                std::string id = created[0].substr(3);
+                auto replies = Exchange(fd, {"move " + id + " e2e4", "move " + id + " e7e5", "undo " + id, "quit"});
+                if (replies.size() == 4 && replies[2].find(" b KQkq e3 ") != std::string::npos && replies[3] == "ok") {
+                    finished[i] = 1;
+                }
+            }
+            close(fd);
+        });
+    }
+    for (auto& client : clients) client.join();
+    for (int done : finished) EXPECT_EQ(done, 1);
+}
@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Game.h"
+#include "EnginePlayer.h"
+#include "EnginePool.h"
+#include "Epd.h"
+#include "EvalCache.h"
+#include "MatchStats.h"
+#include "UciEngine.h"
+
+namespace {
+bool IsLegalIn(Game& game, const std::string& uci) {
+    auto moves = game.getLegalMoves();
+    return std::any_of(moves.begin(), moves.end(), [&](const MoveCoords& m) { return toUci(m) == uci; });
+}
+} // namespace
+
+TEST(UciFormatTest, RoundTripsMoveStrings) {
+    auto mv = parseUci("e7e8n");
+    ASSERT_TRUE(mv.has_value());
+    EXPECT_EQ(mv->fromX, 4);
+    EXPECT_EQ(mv->fromY, 6);
+    EXPECT_EQ(mv->toX, 4);
+    EXPECT_EQ(mv->toY, 7);
+    ASSERT_TRUE(mv->promotion.has_value());
+    EXPECT_EQ(*mv->promotion, PieceType::Knight);
+    EXPECT_EQ(toUci(*mv), "e7e8n");
+
+    EXPECT_FALSE(parseUci("e2").has_value());
+    EXPECT_FALSE(parseUci("i2e4").has_value());
+}
+
+TEST(UciEngineTest, ScriptedMovesAreReturnedInOrder) {
+    UciEngine engine;
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+    engine.setOption("Script", "e2e4,g1f3");
+    EXPECT_EQ(engine.bestMove({}, 10), "e2e4");
+    EXPECT_EQ(engine.bestMove({"e2e4", "e7e5"}, 10), "g1f3");
+    EXPECT_EQ(engine.bestMove({"e2e4", "e7e5", "g1f3", "b8c6"}, 10), "");
+    engine.stop();
+    EXPECT_FALSE(engine.isRunning());
+}
+
+TEST(UciEngineTest, RandomMovesAreLegalThroughInfoSpam) {
+    UciEngine engine;
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+    engine.setOption("InfoLines", "500");
+
+    Game game;
+    game.start();
+    std::vector<std::string> uciMoves;
+    for (int ply = 0; ply < 20; ++ply) {
+        std::string best = engine.bestMove(uciMoves, 0);
+        ASSERT_FALSE(best.empty());
+        ASSERT_TRUE(IsLegalIn(game, best)) << best << " at ply " << ply;
+        auto mv = parseUci(best);
+        game.makeMove(mv->fromX, mv->fromY, mv->toX, mv->toY, mv->promotion.value_or(PieceType::Queen));
+        uciMoves.push_back(best);
+        if (game.isCheckmate() || game.isStalemate()) break;
+    }
+    EXPECT_TRUE(engine.isReady());
+}
+
+TEST(UciEngineTest, SearchesFromFenPositions) {
+    UciEngine engine;
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+    // Black has a single legal king move in both positions.
+    const std::string fen = "7k/8/5K2/8/8/8/8/6R1 b - - 0 1";
+    EXPECT_EQ(engine.bestMove(fen, {}, 0), "h8h7");
+    EXPECT_EQ(engine.bestMove(fen, {"h8h7", "g1h1"}, 0), "h7g8");
+    engine.stop();
+}
+
+TEST(UciEngineTest, KillsAnEngineThatIgnoresTheSearchDeadline) {
+    UciEngine engine;
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+    // The mock sleeps through "stop", so it is killed once the grace period is over too.
+    engine.setOption("DelayMs", "600000");
+    SearchLimits limits;
+    limits.depth = 1;
+    limits.timeoutMs = 100;
+    auto started = std::chrono::steady_clock::now();
+    AnalysisResult result = engine.analyse("", {}, limits);
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    EXPECT_TRUE(result.bestMove.empty());
+    EXPECT_FALSE(engine.isRunning());
+    EXPECT_LT(elapsed, std::chrono::milliseconds(100 + UciEngine::kStopGraceMs + 2000));
+
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+    EXPECT_FALSE(engine.analyse("", {}, limits).bestMove.empty());
+}
+
+TEST(UciEngineTest, WritesToAnEngineThatExitedFailWithoutSigpipe) {
+    UciEngine engine;
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+    ASSERT_TRUE(engine.send("quit\n"));
+    EXPECT_TRUE(engine.readLine().empty()); // end of stream: the engine is on its way out
+    // Writes fail once the process is gone; SIGPIPE's default action would end the test instead.
+    bool failed = false;
+    for (int attempt = 0; attempt < 200 && !failed; ++attempt) {
+        failed = !engine.send("isready\n");
+        if (!failed) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_TRUE(failed);
+    EXPECT_FALSE(engine.isReady());
+}
+
+TEST(UciEngineTest, MockSeedOptionIsCaseInsensitive) {
+    std::string first;
+    for (const char* name : {"Seed", "seed", "SEED"}) {
+        UciEngine engine;
+        ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+        engine.setOption(name, "12345");
+        std::string moves = engine.bestMove({}, 0) + " " + engine.bestMove({"e2e4"}, 0);
+        if (first.empty()) first = moves;
+        EXPECT_EQ(moves, first) << name;
+    }
+}
+
+TEST(UciEngineTest, StartFailsForMissingBinary) {
+    UciEngine engine;
+    EXPECT_FALSE(engine.start("/nonexistent/engine/binary", 10));
+    EXPECT_FALSE(engine.isRunning());
+}
+
+TEST(UciEngineTest, AnalyseCollectsMultiPvLines) {
+    UciEngine engine;
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 20));
+    SearchLimits limits;
+    limits.depth = 3;
+    limits.multiPv = 3;
+    auto result = engine.analyse("", {"e2e4"}, limits);
+    ASSERT_EQ(result.lines.size(), 3u);
+    for (size_t i = 0; i < result.lines.size(); ++i) {
+        EXPECT_EQ(result.lines[i].multiPv, static_cast<int>(i) + 1);
+        EXPECT_EQ(result.lines[i].depth, 3);
+        EXPECT_FALSE(result.lines[i].pv.empty());
+    }
+    EXPECT_EQ(result.bestMove, result.lines.front().pv.front());
+}
+
+TEST(EnginePoolTest, AnswersConcurrentRequests) {
+    EnginePool pool(MOCK_UCI_ENGINE_PATH, 3);
+    ASSERT_EQ(pool.size(), 3);
+    std::vector<std::future<AnalysisResult>> results;
+    for (int i = 0; i < 12; ++i) {
+        AnalysisRequest request;
+        request.moves = {"d2d4"};
+        request.limits.depth = 1;
+        results.push_back(pool.submit(request));
+    }
+    Game game;
+    game.start();
+    game.makeMove(3, 1, 3, 3);
+    for (auto& result : results) {
+        auto value = result.get();
+        EXPECT_TRUE(IsLegalIn(game, value.bestMove)) << value.bestMove;
+    }
+}
+
+TEST(EnginePoolTest, RestartsAnEngineThatCrashed) {
+    EnginePool pool(MOCK_UCI_ENGINE_PATH, 1, {{"CrashAfter", "1"}});
+    ASSERT_EQ(pool.size(), 1);
+    AnalysisRequest request;
+    request.limits.depth = 1;
+    EXPECT_FALSE(pool.submit(request).get().bestMove.empty());
+    AnalysisResult crashed = pool.submit(request).get();
+    EXPECT_TRUE(crashed.bestMove.empty());
+    EXPECT_TRUE(crashed.lines.empty());
+    EXPECT_FALSE(pool.submit(request).get().bestMove.empty());
+}
+
+TEST(EpdTest, ParsesOperationsAndCounters) {
+    auto record = parseEpd("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - bm Bb5 Bc4; id \"test.001\"; hmvc 2; fmvn 3;");
+    ASSERT_TRUE(record.has_value());
+    EXPECT_EQ(record->fen, "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+    EXPECT_EQ(record->id(), "test.001");
+    EXPECT_EQ(record->operandList("bm"), (std::vector<std::string>{"Bb5", "Bc4"}));
+
+    auto fen = parseEpd("8/8/8/8/8/8/8/K6k b - - 12 40");
+    ASSERT_TRUE(fen.has_value());
+    EXPECT_EQ(fen->fen, "8/8/8/8/8/8/8/K6k b - - 12 40");
+    EXPECT_TRUE(fen->operations.empty());
+
+    EXPECT_FALSE(parseEpd("# comment").has_value());
+    EXPECT_FALSE(parseEpd("   ").has_value());
+}
+
+TEST(EngineSpecTest, ParsesKeyValuePairs) {
+    auto spec = EngineSpec::parse("name=sf5 cmd=/usr/games/stockfish skill=5 movetime=100");
+    ASSERT_TRUE(spec.has_value());
+    EXPECT_EQ(spec->name, "sf5");
+    EXPECT_FALSE(spec->isNative());
+    EXPECT_EQ(spec->skill, 5);
+    EXPECT_EQ(spec->limits.movetimeMs, 100);
+
+    auto native = EngineSpec::parse("cmd=native,depth=3");
+    ASSERT_TRUE(native.has_value());
+    EXPECT_TRUE(native->isNative());
+    EXPECT_EQ(native->limits.depth, 3);
+
+    EXPECT_FALSE(EngineSpec::parse("bogus").has_value());
+}
+
+TEST(MatchStatsTest, EloAndSprt) {
+    MatchScore even{10, 20, 10};
+    EXPECT_DOUBLE_EQ(even.score(), 0.5);
+    EXPECT_NEAR(estimateElo(even).elo, 0.0, 1e-9);
+    EXPECT_NEAR(estimateElo(even).los, 0.5, 1e-9);
+
+    MatchScore strong{600, 300, 100};
+    auto elo = estimateElo(strong);
+    EXPECT_GT(elo.elo, 150.0);
+    EXPECT_GT(elo.los, 0.99);
+    EXPECT_EQ(sprt(strong, 0.0, 10.0).decision, SprtDecision::AcceptH1);
+    EXPECT_EQ(sprt(MatchScore{100, 300, 600}, 0.0, 10.0).decision, SprtDecision::AcceptH0);
+}
+
+TEST(EvalCacheTest, StoresProbesAndPersists) {
+    auto path = (std::filesystem::temp_directory_path() / "chess_test_eval.cache").string();
+    std::filesystem::remove(path);
+
+    Game game;
+    game.start();
+    uint64_t key = game.getPositionHash();
+    {
+        EvalCache cache;
+        ASSERT_TRUE(cache.open(path, 1 << 16));
+        EXPECT_FALSE(cache.probe(key).has_value());
+
+        CachedEval eval;
+        eval.depth = 12;
+        eval.score = 31;
+        eval.pv = {*parseUci("e2e4"), *parseUci("e7e5")};
+        cache.store(key, eval);
+
+        CachedEval shallow = eval;
+        shallow.depth = 4;
+        shallow.score = -5;
+        cache.store(key, shallow); // a shallower search must not evict the deeper one
+        auto hit = cache.probe(key);
+        ASSERT_TRUE(hit.has_value());
+        EXPECT_EQ(hit->depth, 12);
+        EXPECT_EQ(hit->score, 31);
+    }
+
+    EvalCache reopened;
+    ASSERT_TRUE(reopened.open(path, 1 << 16));
+    auto hit = reopened.probe(key);
+    ASSERT_TRUE(hit.has_value());
+    ASSERT_EQ(hit->pv.size(), 2u);
+    EXPECT_EQ(toUci(hit->pv[0]), "e2e4");
+    EXPECT_EQ(toUci(hit->pv[1]), "e7e5");
+    EXPECT_FALSE(reopened.probe(key ^ 1).has_value());
+    reopened.close();
+    std::filesystem::remove(path);
+}
+
+TEST(EvalCacheTest, ProcessesShareOneFileWhateverSizeTheyAskFor) {
+    auto path = (std::filesystem::temp_directory_path() / "chess_test_shared.cache").string();
+    std::filesystem::remove(path);
+
+    EvalCache first, second;
+    ASSERT_TRUE(first.open(path, 1 << 16));
+    ASSERT_TRUE(second.open(path, 1 << 20)); // adopts the existing size instead of recreating the file
+    EXPECT_EQ(second.capacity(), first.capacity());
+    CachedEval eval;
+    eval.depth = 9;
+    eval.pv = {*parseUci("d2d4")};
+    first.store(42, eval);
+    auto hit = second.probe(42);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->depth, 9);
+    first.close();
+    second.close();
+
+    // A file that is not a cache is replaced by an empty one.
+    {
+        std::ofstream junk(path, std::ios::binary | std::ios::trunc);
+        junk << "not a cache";
+    }
+    EvalCache replaced;
+    ASSERT_TRUE(replaced.open(path, 1 << 16));
+    EXPECT_FALSE(replaced.probe(42).has_value());
+    replaced.close();
+    std::filesystem::remove(path);
+}
+
+TEST(UciEngineTest, AnswersRepeatedSearchesFromTheEvalCache) {
+    auto path = (std::filesystem::temp_directory_path() / "chess_test_engine.cache").string();
+    std::filesystem::remove(path);
+    EvalCache cache;
+    ASSERT_TRUE(cache.open(path, 1 << 16));
+
+    UciEngine engine;
+    ASSERT_TRUE(engine.start(MOCK_UCI_ENGINE_PATH, 10));
+    engine.setCache(&cache, 2);
+    SearchLimits limits;
+    limits.depth = 2;
+    AnalysisResult first = engine.analyse("", {"d2d4"}, limits);
+    ASSERT_FALSE(first.bestMove.empty());
+    // The mock picks a random move per search, so identical answers mean it never searched.
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(engine.analyse("", {"d2d4"}, limits).bestMove, first.bestMove);
+        EXPECT_EQ(engine.bestMove({"d2d4"}, 10), first.bestMove);
+    }
+    engine.stop();
+    cache.close();
+    std::filesystem::remove(path);
+}
+
+TEST(EnginePoolTest, RepeatedRequestsAreServedFromCache) {
+    auto path = (std::filesystem::temp_directory_path() / "chess_test_pool.cache").string();
+    std::filesystem::remove(path);
+    EvalCache cache;
+    ASSERT_TRUE(cache.open(path, 1 << 16));
+
+    EnginePool pool(MOCK_UCI_ENGINE_PATH, 1);
+    pool.setCache(&cache, 2);
+    AnalysisRequest request;
+    request.moves = {"e2e4"};
+    request.limits.depth = 2;
+    auto first = pool.submit(request).get();
+    ASSERT_FALSE(first.bestMove.empty());
+
+    // The mock picks a random move per search, so an identical answer means it never searched.
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(pool.submit(request).get().bestMove, first.bestMove);
+    }
+    pool.shutdown();
+    cache.close();
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,276 @@
+// Batch analysis of EPD/FEN files over a pool of UCI engines.
+//
+// Usage: chess_analyze --engine <path> --input <file.epd> --output <file.jsonl|file.csv>
+//                      [--workers N] [--multipv K] [--depth D] [--nodes N] [--movetime MS]
+//                      [--format jsonl|csv] [--cache N] [--cache-file <path> [--cache-mb N]]
+//                      [--timeout MS]
+//
+// Positions are streamed from the input and analysed concurrently; results are appended to the
+// output in input order. Every record carries the index of its input position, so re-running the
+// same command after an interruption skips everything that was already written. Positions the
+// engine failed on (crash, timeout: no best move and no lines) are not written, so they are
+// retried by the next run.
+//
+// --format csv is implied by a .csv output; --cache N caps how many distinct positions of this
+// run are remembered for deduplication (default 100000); --cache-file keeps evaluations across
+// runs in a shared file of --cache-mb megabytes. --timeout caps every search (default 60000 ms,
+// 0 for none): the engine is told to stop, and killed and restarted if it does not answer.
+#include "EnginePool.h"
+#include "Epd.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+using json = nlohmann::json;
+
+namespace {
+SearchLimits defaultLimits() {
+    SearchLimits limits;
+    limits.timeoutMs = 60000;
+    return limits;
+}
+
+struct Config {
+    std::string enginePath;
+    std::string inputPath;
+    std::string outputPath;
+    int workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    SearchLimits limits = defaultLimits();
+    bool csv = false;
+    size_t cacheLimit = 100000;
+    std::string cacheFile;
+    size_t cacheMb = 256;
+};
+
+struct Pending {
+    long long index;
+    EpdRecord record;
+    std::shared_future<AnalysisResult> result;
+};
+
+void printUsage() {
+    std::cerr << "Usage: chess_analyze --engine <path> --input <file.epd> --output <file.jsonl|file.csv>\n"
+              << "                     [--workers N] [--multipv K] [--depth D] [--nodes N] [--movetime MS]\n"
+              << "                     [--format jsonl|csv] [--cache N] [--cache-file <path> [--cache-mb N]]\n"
+              << "                     [--timeout MS]\n";
+}
+
+bool parseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (arg == "--engine") config.enginePath = value();
+            else if (arg == "--input") config.inputPath = value();
+            else if (arg == "--output") config.outputPath = value();
+            else if (arg == "--workers") config.workers = std::max(1, std::stoi(value()));
+            else if (arg == "--multipv") config.limits.multiPv = std::max(1, std::stoi(value()));
+            else if (arg == "--depth") config.limits.depth = std::stoi(value());
+            else if (arg == "--nodes") config.limits.nodes = std::stoll(value());
+            else if (arg == "--movetime") config.limits.movetimeMs = std::stoi(value());
+            else if (arg == "--cache") config.cacheLimit = static_cast<size_t>(std::stoull(value()));
+            else if (arg == "--format") config.csv = (value() == "csv");
+            else if (arg == "--cache-file") config.cacheFile = value();
+            else if (arg == "--cache-mb") config.cacheMb = static_cast<size_t>(std::stoull(value()));
+            else if (arg == "--timeout") config.limits.timeoutMs = std::max(0, std::stoi(value()));
+            else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    if (config.enginePath.empty() || config.inputPath.empty() || config.outputPath.empty()) return false;
+    if (std::filesystem::path(config.outputPath).extension() == ".csv") config.csv = true;
+    if (config.limits.depth == 0 && config.limits.nodes == 0 && config.limits.movetimeMs == 0) {
+        config.limits.depth = 12;
+    }
+    return true;
+}
+
+// Collects the indices already present in the output and drops a trailing partial record.
+std::unordered_set<long long> loadCompleted(const Config& config) {
+    std::unordered_set<long long> done;
+    std::ifstream in(config.outputPath, std::ios::binary);
+    if (!in.is_open()) return done;
+
+    std::string line;
+    std::streamoff validBytes = 0;
+    while (std::getline(in, line)) {
+        if (in.eof()) break; // no trailing newline: partial write
+        validBytes = in.tellg();
+        if (line.empty()) continue;
+        try {
+            // Failed analyses written by older versions are retried as well.
+            if (config.csv) {
+                if (line.rfind("index,", 0) == 0) continue;
+                const std::string failed = "\",,0,0,cp,0,0,";
+                if (line.size() >= failed.size() && line.compare(line.size() - failed.size(), failed.size(), failed) == 0) {
+                    continue;
+                }
+                done.insert(std::stoll(line.substr(0, line.find(','))));
+            } else {
+                json record = json::parse(line);
+                if (record.value("bestmove", "").empty() && record.value("lines", json::array()).empty()) continue;
+                done.insert(record.at("index").get<long long>());
+            }
+        } catch (...) {
+            continue;
+        }
+    }
+    in.close();
+    std::error_code ec;
+    if (static_cast<std::uintmax_t>(validBytes) != std::filesystem::file_size(config.outputPath, ec) && !ec) {
+        std::filesystem::resize_file(config.outputPath, static_cast<std::uintmax_t>(validBytes), ec);
+    }
+    return done;
+}
+
+std::string joinPv(const std::vector<std::string>& pv) {
+    std::string text;
+    for (const auto& mv : pv) {
+        if (!text.empty()) text.push_back(' ');
+        text += mv;
+    }
+    return text;
+}
+
+void writeRecord(std::ostream& out, const Config& config, const Pending& pending, const AnalysisResult& result) {
+    const std::string id = pending.record.id();
+    if (config.csv) {
+        for (const auto& line : result.lines) {
+            out << pending.index << ",\"" << pending.record.fen << "\",\"" << id << "\"," << result.bestMove << ','
+                << line.multiPv << ',' << line.depth << ',' << (line.mate ? "mate" : "cp") << ',' << line.score << ','
+                << line.nodes << ',' << joinPv(line.pv) << '\n';
+        }
+        if (result.lines.empty()) {
+            out << pending.index << ",\"" << pending.record.fen << "\",\"" << id << "\"," << result.bestMove
+                << ",0,0,cp,0,0,\n";
+        }
+        return;
+    }
+
+    json j;
+    j["index"] = pending.index;
+    j["fen"] = pending.record.fen;
+    if (!id.empty()) j["id"] = id;
+    j["bestmove"] = result.bestMove;
+    j["nodes"] = result.nodes;
+    json lines = json::array();
+    for (const auto& line : result.lines) {
+        json l;
+        l["multipv"] = line.multiPv;
+        l["depth"] = line.depth;
+        l[line.mate ? "mate" : "cp"] = line.score;
+        l["pv"] = joinPv(line.pv);
+        lines.push_back(l);
+    }
+    j["lines"] = lines;
+    out << j.dump() << '\n';
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 2;
+    }
+
+    std::ifstream input(config.inputPath);
+    if (!input.is_open()) {
+        std::cerr << "Could not open input: " << config.inputPath << "\n";
+        return 1;
+    }
+
+    auto completed = loadCompleted(config);
+    bool writeHeader = config.csv && !std::filesystem::exists(config.outputPath);
+    std::ofstream output(config.outputPath, std::ios::app | std::ios::binary);
+    if (!output.is_open()) {
+        std::cerr << "Could not open output: " << config.outputPath << "\n";
+        return 1;
+    }
+    if (writeHeader) output << "index,fen,id,bestmove,multipv,depth,score_type,score,nodes,pv\n";
+
+    // Persistent cache shared across runs (and with other processes using the same file).
+    EvalCache evalCache;
+    if (!config.cacheFile.empty() && !evalCache.open(config.cacheFile, config.cacheMb * 1024 * 1024)) {
+        std::cerr << "Could not open cache file: " << config.cacheFile << "\n";
+    }
+
+    EnginePool pool(config.enginePath, config.workers);
+    if (pool.size() == 0) {
+        std::cerr << "Failed to start engine at: " << config.enginePath << "\n";
+        return 1;
+    }
+    if (evalCache.isOpen()) pool.setCache(&evalCache, config.limits.depth);
+    std::cerr << "Analysing with " << pool.size() << " engine(s), " << completed.size()
+              << " position(s) already done.\n";
+
+    // Identical positions within a run are searched once.
+    std::unordered_map<std::string, std::shared_future<AnalysisResult>> cache;
+    std::deque<Pending> inFlight;
+    const size_t window = static_cast<size_t>(pool.size()) * 4;
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    long long written = 0;
+    long long failed = 0;
+
+    auto flushOldest = [&]() {
+        Pending& oldest = inFlight.front();
+        const AnalysisResult& result = oldest.result.get();
+        if (result.bestMove.empty() && result.lines.empty()) {
+            ++failed; // left out of the output so that a re-run retries it
+        } else {
+            writeRecord(output, config, oldest, result);
+            ++written;
+        }
+        inFlight.pop_front();
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            output.flush();
+            double seconds = std::chrono::duration<double>(now - start).count();
+            std::cerr << "\r" << written << " analysed, " << static_cast<long long>(written / seconds) << " pos/s"
+                      << std::flush;
+            lastReport = now;
+        }
+    };
+
+    std::string line;
+    long long index = -1;
+    while (std::getline(input, line)) {
+        auto record = parseEpd(line);
+        if (!record) continue;
+        ++index;
+        if (completed.count(index)) continue;
+
+        std::string key = record->fen.substr(0, record->fen.rfind(' ', record->fen.rfind(' ') - 1));
+        auto cached = cache.find(key);
+        std::shared_future<AnalysisResult> result;
+        if (cached != cache.end()) {
+            result = cached->second;
+        } else {
+            result = pool.submit(AnalysisRequest{record->fen, {}, config.limits}).share();
+            if (cache.size() >= config.cacheLimit) cache.clear();
+            cache.emplace(std::move(key), result);
+        }
+        inFlight.push_back(Pending{index, std::move(*record), std::move(result)});
+        if (inFlight.size() >= window) flushOldest();
+    }
+    while (!inFlight.empty()) flushOldest();
+    output.flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "\rDone: " << written << " position(s) in " << seconds << " s\n";
+    if (failed > 0) std::cerr << failed << " position(s) failed; run again to retry them.\n";
+    pool.shutdown();
+    return 0;
+}
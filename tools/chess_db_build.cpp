@@ -0,0 +1,68 @@
+// Builds a position-indexed game database from PGN files.
+//
+// Usage: chess_db_build <out.cdb> <file.pgn>... [--quiet]
+//
+// Games whose moves cannot be replayed are skipped and counted. The index is sorted in memory
+// before writing, so the input has to fit in RAM at roughly 16 bytes per ply.
+#include "GameDatabase.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+void printUsage() {
+    std::cerr << "Usage: chess_db_build <out.cdb> <file.pgn>... [--quiet]\n";
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    std::vector<std::string> inputs;
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quiet") {
+            quiet = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            printUsage();
+            return 2;
+        } else if (outputPath.empty()) {
+            outputPath = arg;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (outputPath.empty() || inputs.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    GameDatabaseBuilder builder;
+    size_t skipped = 0;
+    for (const auto& path : inputs) {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 2;
+        }
+        PgnReader reader(input);
+        PgnGame pgn;
+        while (reader.next(pgn)) {
+            if (!builder.addGame(pgn)) ++skipped;
+            if (!quiet && reader.gamesRead() % 10000 == 0) {
+                std::cerr << "\rRead " << builder.gameCount() << " games" << std::flush;
+            }
+        }
+    }
+    if (!builder.write(outputPath)) {
+        std::cerr << "Cannot write " << outputPath << "\n";
+        return 2;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (!quiet) std::cerr << '\n';
+    std::cerr << builder.gameCount() << " games indexed, " << skipped << " skipped in " << seconds << " s\n";
+    return 0;
+}
@@ -0,0 +1,439 @@
+// Load generator for chess_server: many concurrent connections playing random legal games.
+//
+// Usage: chess_loadgen [--host ADDR] [--port N] [--unix PATH] [--connections N] [--threads N]
+//                      [--duration S] [--rate R] [--undo PCT] [--state PCT] [--save PCT]
+//                      [--max-plies N] [--seed N]
+//
+// Each connection opens a game with "new" and then issues move/undo/state/save requests in the
+// given mix, choosing moves from its own copy of the game; finished games are closed and replaced.
+// With --rate the load is open loop: every connection has a fixed schedule adding up to R
+// requests/s, and latency is measured from the scheduled send time, so a stalled server shows up
+// as queueing delay instead of quietly lowering the offered load. Without --rate each connection
+// sends its next request as soon as the previous reply arrives.
+#include "Game.h"
+#include "LatencyHistogram.h"
+#include "UciEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+enum class Op { New, Move, Undo, State, Save, Close, Count };
+const char* const kOpNames[] = {"new", "move", "undo", "state", "save", "close"};
+constexpr size_t kOps = static_cast<size_t>(Op::Count);
+
+struct Config {
+    std::string host = "127.0.0.1";
+    int port = 7878;
+    std::string unixPath;
+    int connections = 1000;
+    int threads = 4;
+    double durationSeconds = 10.0;
+    double rate = 0.0; // requests/s over all connections; 0 runs closed loop
+    int undoPercent = 10;
+    int statePercent = 15;
+    int savePercent = 5;
+    int maxPlies = 200;
+    uint64_t seed = 1;
+};
+
+struct Results {
+    LatencyHistogram latency[kOps]; // nanoseconds
+    uint64_t errors = 0;
+    uint64_t gamesFinished = 0;
+
+    void merge(const Results& other) {
+        for (size_t i = 0; i < kOps; ++i) latency[i].merge(other.latency[i]);
+        errors += other.errors;
+        gamesFinished += other.gamesFinished;
+    }
+};
+
+struct Client {
+    int fd = -1;
+    Game game;
+    std::string id;
+    std::string input;
+    std::string output;
+    Op pending = Op::New;
+    bool waiting = false;
+    MoveCoords lastMove{};
+    Clock::time_point intended; // when the in-flight request was due to be sent
+    Clock::time_point due;      // open loop: when the next request is due
+};
+
+void printUsage() {
+    std::cerr << "Usage: chess_loadgen [--host ADDR] [--port N] [--unix PATH] [--connections N] [--threads N]\n"
+              << "                     [--duration S] [--rate R] [--undo PCT] [--state PCT] [--save PCT]\n"
+              << "                     [--max-plies N] [--seed N]\n";
+}
+
+bool parseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (arg == "--host") config.host = value();
+            else if (arg == "--port") config.port = std::stoi(value());
+            else if (arg == "--unix") config.unixPath = value();
+            else if (arg == "--connections") config.connections = std::max(1, std::stoi(value()));
+            else if (arg == "--threads") config.threads = std::max(1, std::stoi(value()));
+            else if (arg == "--duration") config.durationSeconds = std::stod(value());
+            else if (arg == "--rate") config.rate = std::max(0.0, std::stod(value()));
+            else if (arg == "--undo") config.undoPercent = std::stoi(value());
+            else if (arg == "--state") config.statePercent = std::stoi(value());
+            else if (arg == "--save") config.savePercent = std::stoi(value());
+            else if (arg == "--max-plies") config.maxPlies = std::max(1, std::stoi(value()));
+            else if (arg == "--seed") config.seed = std::stoull(value());
+            else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    return config.undoPercent >= 0 && config.statePercent >= 0 && config.savePercent >= 0 &&
+           config.undoPercent + config.statePercent + config.savePercent <= 100;
+}
+
+int connectToServer(const Config& config) {
+    int fd;
+    if (!config.unixPath.empty()) {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, config.unixPath.c_str(), sizeof(address.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(config.port));
+        if (inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1 ||
+            connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+    return fd;
+}
+
+// Drives one share of the connections with its own epoll set until the deadline passes and
+// every in-flight request has been answered (or a grace period runs out).
+class Worker {
+public:
+    Worker(const Config& config, int connections, uint64_t seed) : config(config), clients(connections), rng(seed) {}
+
+    bool connectAll() {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        for (size_t i = 0; i < clients.size(); ++i) {
+            int fd = connectToServer(config);
+            if (fd < 0) return false;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            clients[i].fd = fd;
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+        return true;
+    }
+
+    void run(Clock::time_point start, Clock::time_point deadline) {
+        // Each connection carries an equal share of the rate, with start times spread over one
+        // interval so the connections do not fire in lockstep.
+        interval = config.rate > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+                                         static_cast<double>(config.connections) / config.rate))
+                                   : Clock::duration::zero();
+        std::uniform_int_distribution<Clock::rep> offset(0, std::max<Clock::rep>(0, interval.count() - 1));
+        for (size_t i = 0; i < clients.size(); ++i) {
+            clients[i].due = start + Clock::duration(offset(rng));
+            timers.push({clients[i].due, i});
+        }
+
+        std::vector<epoll_event> events(256);
+        Clock::time_point stop = deadline + std::chrono::seconds(5);
+        while (true) {
+            Clock::time_point now = Clock::now();
+            fireTimers(now, deadline);
+            if (now >= deadline && inFlight == 0) break;
+            if (now >= stop) break;
+            Clock::time_point wake = timers.empty() || now >= deadline ? stop : std::min(stop, timers.top().first);
+            int timeout = static_cast<int>(
+                std::chrono::ceil<std::chrono::milliseconds>(std::max(Clock::duration::zero(), wake - now)).count());
+            int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeout);
+            for (int i = 0; i < count; ++i) {
+                Client& client = clients[events[static_cast<size_t>(i)].data.u64];
+                if (events[static_cast<size_t>(i)].events & EPOLLOUT) flush(client);
+                if (events[static_cast<size_t>(i)].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    readReplies(client, deadline);
+                }
+            }
+        }
+        for (auto& client : clients) {
+            if (client.fd >= 0) close(client.fd);
+        }
+        close(epollFd);
+    }
+
+    Results results;
+
+private:
+    using Timer = std::pair<Clock::time_point, size_t>;
+
+    void fireTimers(Clock::time_point now, Clock::time_point deadline) {
+        while (!timers.empty() && (timers.top().first <= now || now >= deadline)) {
+            size_t index = timers.top().second;
+            timers.pop();
+            if (clients[index].fd < 0) continue;
+            if (now < deadline) send(clients[index], clients[index].due);
+            else schedule(index, now, deadline);
+        }
+    }
+
+    // Called when a connection is idle: sends now in closed loop, or at its next slot in open loop.
+    // After the deadline the connection only closes its game, so the server is left clean.
+    void schedule(size_t index, Clock::time_point now, Clock::time_point deadline) {
+        Client& client = clients[index];
+        if (now >= deadline) {
+            if (!client.id.empty()) send(client, now, true);
+            return;
+        }
+        if (interval == Clock::duration::zero()) {
+            send(client, now);
+        } else if (client.due <= now) {
+            send(client, client.due); // behind schedule: the wait so far counts as latency
+        } else {
+            timers.push({client.due, index});
+        }
+    }
+
+    void send(Client& client, Clock::time_point intended, bool closing = false) {
+        if (client.fd < 0) return;
+        std::string line = closing ? closeRequest(client) : nextRequest(client);
+        client.intended = intended;
+        client.due += interval;
+        client.waiting = true;
+        ++inFlight;
+        client.output += line;
+        flush(client);
+    }
+
+    std::string closeRequest(Client& client) {
+        client.pending = Op::Close;
+        return "close " + client.id + "\n";
+    }
+
+    std::string nextRequest(Client& client) {
+        if (client.id.empty()) {
+            client.pending = Op::New;
+            return "new\n";
+        }
+        auto moves = client.game.getLegalMoves();
+        if (moves.empty() || client.game.getMoveCount() >= config.maxPlies) return closeRequest(client);
+        int roll = std::uniform_int_distribution<int>(0, 99)(rng);
+        if (roll < config.undoPercent && !client.game.getMoveHistory().empty()) {
+            client.pending = Op::Undo;
+            return "undo " + client.id + "\n";
+        }
+        roll -= config.undoPercent;
+        if (roll >= 0 && roll < config.statePercent) {
+            client.pending = Op::State;
+            return "state " + client.id + "\n";
+        }
+        roll -= config.statePercent;
+        if (roll >= 0 && roll < config.savePercent) {
+            client.pending = Op::Save;
+            return "save " + client.id + "\n";
+        }
+        client.pending = Op::Move;
+        client.lastMove = moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(rng)];
+        return "move " + client.id + " " + toUci(client.lastMove) + "\n";
+    }
+
+    void flush(Client& client) {
+        bool blocked = false;
+        while (!client.output.empty()) {
+            ssize_t sent = ::send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+            if (sent > 0) {
+                client.output.erase(0, static_cast<size_t>(sent));
+            } else if (sent < 0 && errno == EINTR) {
+                continue;
+            } else {
+                blocked = sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                if (!blocked) fail(client);
+                break;
+            }
+        }
+        epoll_event event{};
+        event.events = EPOLLIN | (blocked ? EPOLLOUT : 0u);
+        event.data.u64 = static_cast<uint64_t>(&client - clients.data());
+        if (client.fd >= 0) epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+    }
+
+    void readReplies(Client& client, Clock::time_point deadline) {
+        char buffer[4096];
+        while (client.fd >= 0) {
+            ssize_t got = read(client.fd, buffer, sizeof(buffer));
+            if (got > 0) {
+                client.input.append(buffer, static_cast<size_t>(got));
+                continue;
+            }
+            if (got < 0 && errno == EINTR) continue;
+            if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) fail(client);
+            break;
+        }
+        for (size_t newline; client.waiting && (newline = client.input.find('\n')) != std::string::npos;) {
+            std::string reply = client.input.substr(0, newline);
+            client.input.erase(0, newline + 1);
+            complete(client, reply, deadline);
+        }
+    }
+
+    void complete(Client& client, const std::string& reply, Clock::time_point deadline) {
+        Clock::time_point now = Clock::now();
+        client.waiting = false;
+        --inFlight;
+        bool measured = client.intended < deadline;
+        if (measured) {
+            results.latency[static_cast<size_t>(client.pending)].record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - client.intended).count()));
+        }
+        bool ok = reply.compare(0, 3, "ok ") == 0 || reply == "ok";
+        if (!ok) {
+            // Out of step with the server; start a fresh game.
+            if (measured) ++results.errors;
+            client.id.clear();
+        } else {
+            switch (client.pending) {
+            case Op::New:
+                client.id = reply.substr(3);
+                client.game.start();
+                break;
+            case Op::Move:
+                client.game.makeMove(client.lastMove.fromX, client.lastMove.fromY, client.lastMove.toX,
+                                     client.lastMove.toY, client.lastMove.promotion.value_or(PieceType::Queen));
+                break;
+            case Op::Undo:
+                client.game.undoMove();
+                break;
+            case Op::Close:
+                client.id.clear();
+                if (measured) ++results.gamesFinished;
+                break;
+            default:
+                break;
+            }
+        }
+        schedule(static_cast<size_t>(&client - clients.data()), now, deadline);
+    }
+
+    void fail(Client& client) {
+        if (client.fd < 0) return;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+        close(client.fd);
+        client.fd = -1;
+        if (client.waiting) {
+            client.waiting = false;
+            --inFlight;
+        }
+        ++results.errors;
+    }
+
+    const Config& config;
+    std::vector<Client> clients;
+    std::mt19937_64 rng;
+    int epollFd = -1;
+    size_t inFlight = 0;
+    Clock::duration interval{};
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+};
+
+void raiseFileLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+void report(const Results& results, double seconds) {
+    std::cout << std::left << std::setw(8) << "op" << std::right << std::setw(10) << "count" << std::setw(12)
+              << "req/s" << std::setw(11) << "p50 us" << std::setw(11) << "p99 us" << std::setw(11) << "p999 us"
+              << std::setw(11) << "max us" << '\n';
+    LatencyHistogram all;
+    auto row = [&](const char* name, const LatencyHistogram& h) {
+        std::cout << std::left << std::setw(8) << name << std::right << std::setw(10) << h.count() << std::fixed
+                  << std::setprecision(0) << std::setw(12) << static_cast<double>(h.count()) / seconds
+                  << std::setprecision(1) << std::setw(11) << h.percentile(0.50) / 1000.0 << std::setw(11)
+                  << h.percentile(0.99) / 1000.0 << std::setw(11) << h.percentile(0.999) / 1000.0 << std::setw(11)
+                  << h.max() / 1000.0 << '\n';
+    };
+    for (size_t i = 0; i < kOps; ++i) {
+        if (results.latency[i].count() == 0) continue;
+        row(kOpNames[i], results.latency[i]);
+        all.merge(results.latency[i]);
+    }
+    row("all", all);
+    std::cout << "errors " << results.errors << ", games finished " << results.gamesFinished << '\n';
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 2;
+    }
+    raiseFileLimit();
+    config.threads = std::min(config.threads, config.connections);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < config.threads; ++t) {
+        int share = config.connections / config.threads + (t < config.connections % config.threads ? 1 : 0);
+        workers.push_back(std::make_unique<Worker>(config, share, config.seed * 1000003 + static_cast<uint64_t>(t)));
+        if (!workers.back()->connectAll()) {
+            std::cerr << "Cannot connect to the server: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    std::cerr << "Connected " << config.connections << " client(s) on " << config.threads << " thread(s), "
+              << (config.rate > 0 ? "open loop at " + std::to_string(static_cast<long long>(config.rate)) + " req/s"
+                                  : std::string("closed loop"))
+              << std::endl;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline =
+        start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.durationSeconds));
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) threads.emplace_back([&, w = worker.get()] { w->run(start, deadline); });
+    for (auto& thread : threads) thread.join();
+
+    Results total;
+    for (const auto& worker : workers) total.merge(worker->results);
+    report(total, config.durationSeconds);
+    return 0;
+}
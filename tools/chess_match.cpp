@@ -0,0 +1,247 @@
+// Headless engine-vs-engine matches with games played in parallel.
+//
+// Usage: chess_match --engine <spec> --engine <spec> [--games N] [--concurrency N]
+//                    [--book file.epd] [--pgn out.pgn] [--maxplies N] [--sprt elo0 elo1]
+//
+// An engine spec is a list of key=value pairs, e.g. "name=sf5 cmd=/usr/games/stockfish skill=5 movetime=100"
+// or "name=native cmd=native depth=3". Each book opening is played twice with colors reversed.
+// Statistics are reported from the first engine's point of view.
+#include "EnginePlayer.h"
+#include "Epd.h"
+#include "Game.h"
+#include "MatchStats.h"
+#include "Pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Config {
+    std::vector<EngineSpec> engines;
+    int games = 100;
+    int concurrency = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::string bookPath;
+    std::string pgnPath = "match.pgn";
+    int maxPlies = 400;
+    bool useSprt = false;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+};
+
+enum class Outcome { WhiteWins, BlackWins, Draw };
+
+struct GameRecord {
+    int round = 0;
+    int firstEngineColor = 0; // 0 = white
+    Outcome outcome = Outcome::Draw;
+    std::string termination;
+    PgnGame pgn;
+};
+
+bool parseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (arg == "--engine") {
+                auto spec = EngineSpec::parse(value());
+                if (!spec) return false;
+                config.engines.push_back(*spec);
+            } else if (arg == "--games") config.games = std::max(1, std::stoi(value()));
+            else if (arg == "--concurrency") config.concurrency = std::max(1, std::stoi(value()));
+            else if (arg == "--book") config.bookPath = value();
+            else if (arg == "--pgn") config.pgnPath = value();
+            else if (arg == "--maxplies") config.maxPlies = std::max(1, std::stoi(value()));
+            else if (arg == "--sprt") {
+                config.useSprt = true;
+                config.elo0 = std::stod(value());
+                config.elo1 = std::stod(value());
+            } else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    return config.engines.size() == 2;
+}
+
+GameRecord playGame(EnginePlayer& first, EnginePlayer& second, const std::string& openingFen, int round,
+                    int maxPlies) {
+    GameRecord record;
+    record.round = round;
+    record.firstEngineColor = (round - 1) % 2;
+    EnginePlayer* white = record.firstEngineColor == 0 ? &first : &second;
+    EnginePlayer* black = record.firstEngineColor == 0 ? &second : &first;
+
+    Game game;
+    if (openingFen.empty() || !game.setFen(openingFen)) game.start();
+    std::string startFen = openingFen.empty() ? "" : game.fen();
+    record.pgn.blackMovesFirst = !game.isWhiteTurn();
+    record.pgn.firstMoveNumber = game.getMoveCount() / 2 + 1;
+
+    white->newGame();
+    black->newGame();
+
+    std::vector<std::string> uciMoves;
+
+    while (true) {
+        if (game.isCheckmate()) {
+            record.outcome = game.isWhiteTurn() ? Outcome::BlackWins : Outcome::WhiteWins;
+            record.termination = "checkmate";
+            break;
+        }
+        if (game.isStalemate()) {
+            record.termination = "stalemate";
+            break;
+        }
+        if (game.getBoard().hasInsufficientMaterial()) {
+            record.termination = "insufficient material";
+            break;
+        }
+        if (game.getHalfmoveClock() >= 100) {
+            record.termination = "fifty move rule";
+            break;
+        }
+        if (static_cast<int>(uciMoves.size()) >= maxPlies) {
+            record.termination = "adjudication";
+            break;
+        }
+
+        EnginePlayer* mover = game.isWhiteTurn() ? white : black;
+        AnalysisResult result = mover->think(game, startFen, uciMoves);
+        auto mv = parseUci(result.bestMove);
+        std::string san = mv ? toSan(game, *mv) : "";
+        if (san.empty()) {
+            record.outcome = game.isWhiteTurn() ? Outcome::BlackWins : Outcome::WhiteWins;
+            record.termination = result.bestMove.empty() ? "no move returned" : "illegal move " + result.bestMove;
+            break;
+        }
+
+        game.makeMove(mv->fromX, mv->fromY, mv->toX, mv->toY, mv->promotion.value_or(PieceType::Queen));
+        uciMoves.push_back(result.bestMove);
+        record.pgn.sanMoves.push_back(san);
+
+        if (game.getRepetitionCount() >= 3) {
+            record.termination = "3-fold repetition";
+            break;
+        }
+    }
+
+    switch (record.outcome) {
+        case Outcome::WhiteWins: record.pgn.result = "1-0"; break;
+        case Outcome::BlackWins: record.pgn.result = "0-1"; break;
+        case Outcome::Draw: record.pgn.result = "1/2-1/2"; break;
+    }
+    record.pgn.tags = {
+        {"Event", "chess_match"},
+        {"Site", "?"},
+        {"Date", "????.??.??"},
+        {"Round", std::to_string(round)},
+        {"White", white->spec().name},
+        {"Black", black->spec().name},
+        {"Result", record.pgn.result},
+    };
+    if (!startFen.empty()) {
+        record.pgn.tags.emplace_back("SetUp", "1");
+        record.pgn.tags.emplace_back("FEN", startFen);
+    }
+    record.pgn.tags.emplace_back("PlyCount", std::to_string(uciMoves.size()));
+    record.pgn.tags.emplace_back("Termination", record.termination);
+    return record;
+}
+
+std::vector<std::string> loadBook(const std::string& path) {
+    std::vector<std::string> openings;
+    if (path.empty()) return openings;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (auto record = parseEpd(line)) openings.push_back(record->fen);
+    }
+    return openings;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        std::cerr << "Usage: chess_match --engine <spec> --engine <spec> [--games N] [--concurrency N]\n"
+                  << "                   [--book file.epd] [--pgn out.pgn] [--maxplies N] [--sprt elo0 elo1]\n";
+        return 2;
+    }
+
+    auto openings = loadBook(config.bookPath);
+    if (!config.bookPath.empty() && openings.empty()) {
+        std::cerr << "No usable positions in book: " << config.bookPath << "\n";
+        return 1;
+    }
+
+    std::ofstream pgn(config.pgnPath, std::ios::app);
+    if (!pgn.is_open()) {
+        std::cerr << "Could not open PGN output: " << config.pgnPath << "\n";
+        return 1;
+    }
+
+    std::atomic<int> nextRound{1};
+    std::atomic<bool> stop{false};
+    std::mutex resultMutex;
+    MatchScore score;
+
+    auto worker = [&]() {
+        EnginePlayer first(config.engines[0]);
+        EnginePlayer second(config.engines[1]);
+        if (!first.start() || !second.start()) {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            std::cerr << "Failed to start engines; worker exiting.\n";
+            return;
+        }
+        while (!stop) {
+            int round = nextRound++;
+            if (round > config.games) break;
+            std::string opening = openings.empty() ? "" : openings[static_cast<size_t>((round - 1) / 2) % openings.size()];
+            GameRecord record = playGame(first, second, opening, round, config.maxPlies);
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            bool firstIsWhite = record.firstEngineColor == 0;
+            if (record.outcome == Outcome::Draw) {
+                ++score.draws;
+            } else if ((record.outcome == Outcome::WhiteWins) == firstIsWhite) {
+                ++score.wins;
+            } else {
+                ++score.losses;
+            }
+            writePgn(pgn, record.pgn);
+            pgn.flush();
+
+            EloEstimate elo = estimateElo(score);
+            std::cout << "Game " << std::setw(5) << score.games() << "/" << config.games << "  "
+                      << config.engines[0].name << " vs " << config.engines[1].name << ": +" << score.wins << " ="
+                      << score.draws << " -" << score.losses << "  Elo " << std::fixed << std::setprecision(1)
+                      << elo.elo << " +/- " << elo.errorMargin << "  LOS " << std::setprecision(3) << elo.los;
+            if (config.useSprt) {
+                SprtResult test = sprt(score, config.elo0, config.elo1);
+                std::cout << "  LLR " << std::setprecision(2) << test.llr << " [" << test.lowerBound << ", "
+                          << test.upperBound << "]";
+                if (test.decision != SprtDecision::Continue) {
+                    std::cout << (test.decision == SprtDecision::AcceptH1 ? "  H1 accepted" : "  H0 accepted");
+                    stop = true;
+                }
+            }
+            std::cout << std::endl;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config.concurrency; ++i) threads.emplace_back(worker);
+    for (auto& t : threads) t.join();
+
+    EloEstimate elo = estimateElo(score);
+    std::cout << "Finished: " << score.games() << " games, score " << std::setprecision(3) << score.score()
+              << ", Elo " << std::setprecision(1) << elo.elo << " +/- " << elo.errorMargin << "\n";
+    return 0;
+}
@@ -0,0 +1,209 @@
+// Validates PGN files by replaying every game.
+//
+// Usage: chess_pgn_check <file.pgn> [--workers N] [--output report.txt] [--quiet]
+//
+// A reader thread splits the input into games and hands them out in batches over a bounded queue;
+// each worker replays its games with its own Game; a writer puts the reports back into input order.
+// Reported problems: moves that are illegal or ambiguous, a Result tag that disagrees with the
+// movetext, and final positions whose checkmate/stalemate does not match the result.
+// The exit status is 1 if any game has a problem.
+#include "BoundedQueue.h"
+#include "Pgn.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr size_t kBatchSize = 64;
+
+struct Config {
+    std::string inputPath;
+    std::string outputPath;
+    int workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bool quiet = false;
+};
+
+struct Batch {
+    size_t firstIndex = 0;
+    std::vector<PgnGame> games;
+};
+
+struct Report {
+    size_t firstIndex = 0;
+    size_t games = 0;
+    size_t plies = 0;
+    size_t badGames = 0;
+    std::vector<std::string> problems; // one line per problem, already formatted
+};
+
+void printUsage() {
+    std::cerr << "Usage: chess_pgn_check <file.pgn> [--workers N] [--output report.txt] [--quiet]\n";
+}
+
+bool parseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (arg == "--workers") config.workers = std::max(1, std::stoi(value()));
+            else if (arg == "--output") config.outputPath = value();
+            else if (arg == "--quiet") config.quiet = true;
+            else if (arg.rfind("--", 0) == 0) return false;
+            else config.inputPath = arg;
+        } catch (...) {
+            return false;
+        }
+    }
+    return !config.inputPath.empty();
+}
+
+std::string tag(const PgnGame& pgn, const char* name) {
+    for (const auto& t : pgn.tags) {
+        if (t.first == name) return t.second;
+    }
+    return "";
+}
+
+// Checks one game and appends its problems to `out`.
+void checkGame(Game& game, const PgnGame& pgn, size_t index, Report& out) {
+    std::string label = "game " + std::to_string(index + 1);
+    std::string white = tag(pgn, "White"), black = tag(pgn, "Black");
+    if (!white.empty() || !black.empty()) label += " (" + white + " - " + black + ")";
+
+    // replayPgn fails the same way for a bad FEN and a bad first move, so tell them apart here.
+    std::string fen = tag(pgn, "FEN");
+    PositionSetup setup;
+    if (!fen.empty() && !Game::parseFen(fen, setup)) {
+        out.problems.push_back(label + ": invalid FEN tag");
+        return;
+    }
+
+    bool replayed = replayPgn(game, pgn);
+    size_t played = game.getMoveHistory().size();
+    out.plies += played;
+    if (!replayed) {
+        if (played >= pgn.sanMoves.size()) { // a later, broken FEN tag
+            out.problems.push_back(label + ": invalid FEN tag");
+            return;
+        }
+        int number = pgn.firstMoveNumber + static_cast<int>((played + (pgn.blackMovesFirst ? 1 : 0)) / 2);
+        bool blackMove = (played % 2 == 1) != pgn.blackMovesFirst;
+        out.problems.push_back(label + ": illegal move " + std::to_string(number) + (blackMove ? "... " : ". ") +
+                               pgn.sanMoves[played]);
+        return;
+    }
+
+    std::string resultTag = tag(pgn, "Result");
+    if (!resultTag.empty() && resultTag != pgn.result) {
+        out.problems.push_back(label + ": Result tag " + resultTag + " but movetext ends with " + pgn.result);
+    }
+    if (game.isCheckmate()) {
+        std::string expected = game.isWhiteTurn() ? "0-1" : "1-0";
+        if (pgn.result != expected) {
+            out.problems.push_back(label + ": checkmate on the board but result is " + pgn.result);
+        }
+    } else if (game.isStalemate()) {
+        if (pgn.result != "1/2-1/2") {
+            out.problems.push_back(label + ": stalemate on the board but result is " + pgn.result);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 2;
+    }
+    std::ifstream input(config.inputPath, std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot open " << config.inputPath << "\n";
+        return 2;
+    }
+    std::ofstream reportFile;
+    if (!config.outputPath.empty()) {
+        reportFile.open(config.outputPath);
+        if (!reportFile) {
+            std::cerr << "Cannot write " << config.outputPath << "\n";
+            return 2;
+        }
+    }
+    std::ostream& report = config.outputPath.empty() ? std::cout : reportFile;
+
+    auto started = std::chrono::steady_clock::now();
+    BoundedQueue<Batch> batches(static_cast<size_t>(config.workers) * 4);
+    BoundedQueue<Report> reports(static_cast<size_t>(config.workers) * 4);
+
+    std::thread reader([&]() {
+        PgnReader pgnReader(input);
+        Batch batch;
+        size_t index = 0;
+        PgnGame pgn;
+        while (pgnReader.next(pgn)) {
+            if (batch.games.empty()) batch.firstIndex = index;
+            batch.games.push_back(std::move(pgn));
+            pgn = PgnGame();
+            ++index;
+            if (batch.games.size() == kBatchSize) {
+                batches.push(std::move(batch));
+                batch = Batch();
+            }
+        }
+        if (!batch.games.empty()) batches.push(std::move(batch));
+        batches.close();
+    });
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.workers; ++i) {
+        workers.emplace_back([&]() {
+            Game game;
+            while (auto batch = batches.pop()) {
+                Report result;
+                result.firstIndex = batch->firstIndex;
+                result.games = batch->games.size();
+                for (size_t j = 0; j < batch->games.size(); ++j) {
+                    size_t before = result.problems.size();
+                    checkGame(game, batch->games[j], batch->firstIndex + j, result);
+                    if (result.problems.size() != before) ++result.badGames;
+                }
+                reports.push(std::move(result));
+            }
+        });
+    }
+    std::thread closer([&]() {
+        for (auto& worker : workers) worker.join();
+        reports.close();
+    });
+
+    // Batches finish out of order; hold them until the next one in input order arrives.
+    std::map<size_t, Report> waiting;
+    size_t nextIndex = 0, games = 0, plies = 0, badGames = 0;
+    while (auto result = reports.pop()) {
+        waiting.emplace(result->firstIndex, std::move(*result));
+        for (auto it = waiting.begin(); it != waiting.end() && it->first == nextIndex; it = waiting.erase(it)) {
+            const Report& ready = it->second;
+            for (const auto& line : ready.problems) report << line << '\n';
+            nextIndex += ready.games;
+            games += ready.games;
+            plies += ready.plies;
+            badGames += ready.badGames;
+        }
+        if (!config.quiet) {
+            std::cerr << "\rChecked " << games << " games" << std::flush;
+        }
+    }
+    reader.join();
+    closer.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (!config.quiet) std::cerr << '\n';
+    std::cerr << games << " games, " << plies << " plies, " << badGames << " with problems in " << seconds
+              << " s (" << static_cast<long long>(seconds > 0 ? games / seconds : 0) << " games/s)\n";
+    return badGames > 0 ? 1 : 0;
+}
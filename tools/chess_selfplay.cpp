@@ -0,0 +1,220 @@
+// Self-play generator of training positions.
+//
+// Usage: chess_selfplay --output <prefix> [--games N] [--threads N] [--engine <spec>]
+//                       [--random-plies N] [--maxplies N] [--shard-size N] [--seed N]
+//
+// Every worker plays whole games against itself: a few uniformly random opening moves, then
+// engine moves under the spec's limits (default "cmd=native nodes=5000", see chess_match for the
+// spec syntax). Positions after the opening are kept when the side to move is not in check and the
+// chosen move is not a capture, and only the first time a position occurs across the whole run.
+// Records (see TrainingData.h) are written when their game ends, into shards of --shard-size records.
+// A game the engine fails in (no answer, illegal move) is dropped with its records, and the
+// engine is restarted.
+#include "EnginePlayer.h"
+#include "Game.h"
+#include "TrainingData.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Config {
+    std::string outputPrefix;
+    long long games = 1000;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    EngineSpec engine = *EngineSpec::parse("cmd=native nodes=5000");
+    int randomPlies = 8;
+    int maxPlies = 400;
+    size_t shardSize = 1000000;
+    unsigned seed = 1;
+};
+
+// Mate scores are stored as this many centipawns minus the distance to mate.
+constexpr int kMateValue = 30000;
+
+void printUsage() {
+    std::cerr << "Usage: chess_selfplay --output <prefix> [--games N] [--threads N] [--engine <spec>]\n"
+              << "                      [--random-plies N] [--maxplies N] [--shard-size N] [--seed N]\n";
+}
+
+bool parseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (arg == "--output") config.outputPrefix = value();
+            else if (arg == "--games") config.games = std::max(1LL, std::stoll(value()));
+            else if (arg == "--threads") config.threads = std::max(1, std::stoi(value()));
+            else if (arg == "--engine") {
+                auto spec = EngineSpec::parse(value());
+                if (!spec) return false;
+                config.engine = *spec;
+            } else if (arg == "--random-plies") config.randomPlies = std::max(0, std::stoi(value()));
+            else if (arg == "--maxplies") config.maxPlies = std::max(1, std::stoi(value()));
+            else if (arg == "--shard-size") config.shardSize = static_cast<size_t>(std::max(1LL, std::stoll(value())));
+            else if (arg == "--seed") config.seed = static_cast<unsigned>(std::stoul(value()));
+            else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    return !config.outputPrefix.empty();
+}
+
+bool isCapture(const Game& game, const MoveCoords& move) {
+    const Board& board = game.getBoard();
+    if (board.getPieceAt(move.toX, move.toY)) return true;
+    const auto& piece = board.getPieceAt(move.fromX, move.fromY);
+    return piece && piece->getType() == PieceType::Pawn && move.fromX != move.toX;
+}
+
+// Plays random legal moves; false if the game ended on the way.
+bool playRandomOpening(Game& game, int plies, std::mt19937& rng, std::vector<std::string>& uciMoves) {
+    for (int i = 0; i < plies; ++i) {
+        auto moves = game.getLegalMoves();
+        if (moves.empty()) return false;
+        const MoveCoords& move = moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(rng)];
+        game.makeMove(move.fromX, move.fromY, move.toX, move.toY, move.promotion.value_or(PieceType::Queen));
+        uciMoves.push_back(toUci(move));
+    }
+    return !game.getLegalMoves().empty();
+}
+
+// Plays one game and returns the kept positions with their results filled in. A game ends as a
+// draw only by adjudication (stalemate, insufficient material, fifty-move rule, repetition, ply
+// cap); if the engine fails to answer or plays an illegal move, the game has no result and
+// nullopt is returned.
+std::optional<std::vector<TrainingRecord>> playGame(EnginePlayer& player, const Config& config, std::mt19937& rng,
+                                     PositionDeduper& seen) {
+    Game game;
+    std::vector<std::string> uciMoves;
+    do {
+        game.start();
+        uciMoves.clear();
+    } while (!playRandomOpening(game, config.randomPlies, rng, uciMoves));
+    player.newGame();
+
+    std::vector<TrainingRecord> records;
+    std::vector<bool> whiteToMove;
+    std::vector<uint64_t> claimed; // hashes this game added to `seen`
+    auto abandon = [&]() {
+        for (uint64_t hash : claimed) seen.erase(hash);
+        return std::nullopt;
+    };
+    int result = 0; // from white's point of view
+    while (true) {
+        if (game.isCheckmate()) {
+            result = game.isWhiteTurn() ? -1 : 1;
+            break;
+        }
+        if (game.isStalemate() || game.getBoard().hasInsufficientMaterial() || game.getHalfmoveClock() >= 100 ||
+            game.getRepetitionCount() >= 3 || static_cast<int>(uciMoves.size()) >= config.maxPlies) {
+            break;
+        }
+        AnalysisResult analysis = player.think(game, "", uciMoves);
+        auto move = parseUci(analysis.bestMove);
+        if (!move || analysis.lines.empty()) return abandon();
+
+        const PvLine& line = analysis.lines.front();
+        Color mover = game.getCurrentPlayer();
+        if (!game.isInCheck(mover) && !isCapture(game, *move) && seen.insert(game.getPositionHash())) {
+            claimed.push_back(game.getPositionHash());
+            TrainingRecord record;
+            record.position = game.getPosition();
+            record.score = line.mate ? (line.score > 0 ? kMateValue - line.score : -kMateValue - line.score)
+                                     : line.score;
+            record.ply = static_cast<int>(uciMoves.size());
+            records.push_back(record);
+            whiteToMove.push_back(mover == Color::White);
+        }
+
+        if (game.makeMove(move->fromX, move->fromY, move->toX, move->toY, move->promotion.value_or(PieceType::Queen)) !=
+            MoveStatus::Ok) {
+            return abandon();
+        }
+        uciMoves.push_back(analysis.bestMove);
+    }
+    for (size_t i = 0; i < records.size(); ++i) records[i].result = whiteToMove[i] ? result : -result;
+    return records;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 2;
+    }
+
+    TrainingDataWriter writer(config.outputPrefix, config.shardSize);
+    PositionDeduper seen;
+    std::atomic<long long> nextGame{0};
+    std::atomic<long long> finishedGames{0};
+    std::atomic<long long> droppedGames{0};
+    std::atomic<bool> failed{false};
+    std::mutex progressMutex;
+    auto started = std::chrono::steady_clock::now();
+    auto lastReport = started;
+
+    auto worker = [&](unsigned index) {
+        EnginePlayer player(config.engine);
+        if (!player.start()) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            std::cerr << "Failed to start engine " << config.engine.command << "; worker exiting.\n";
+            return;
+        }
+        std::mt19937 rng(config.seed * 7919u + index);
+        while (!failed && nextGame++ < config.games) {
+            auto records = playGame(player, config, rng, seen);
+            if (!records) {
+                ++droppedGames;
+                // Dropped games still count towards --games, so a broken engine cannot loop forever.
+                ++finishedGames;
+                if (!player.start()) {
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    std::cerr << "\nEngine " << config.engine.command << " failed and did not restart; worker exiting.\n";
+                    return;
+                }
+                continue;
+            }
+            if (!writer.write(*records)) {
+                failed = true;
+                break;
+            }
+            long long games = ++finishedGames;
+
+            std::lock_guard<std::mutex> lock(progressMutex);
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::seconds(2) || games == config.games) {
+                lastReport = now;
+                double hours = std::chrono::duration<double>(now - started).count() / 3600.0;
+                size_t positions = writer.recordsWritten();
+                std::cerr << "\rGames " << games << "/" << config.games << ", positions " << positions << " ("
+                          << static_cast<long long>(hours > 0 ? positions / hours : 0) << "/hour)" << std::flush;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config.threads; ++i) threads.emplace_back(worker, static_cast<unsigned>(i));
+    for (auto& t : threads) t.join();
+    writer.close();
+
+    std::cerr << '\n';
+    if (failed) {
+        std::cerr << "Could not write shards to " << config.outputPrefix << "-*.bin\n";
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (droppedGames > 0) std::cerr << droppedGames << " game(s) dropped after engine failures\n";
+    std::cout << finishedGames - droppedGames << " games, " << writer.recordsWritten() << " positions in " << writer.shardCount()
+              << " shard(s), " << seconds << " s\n";
+    return 0;
+}
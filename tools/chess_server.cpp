@@ -0,0 +1,574 @@
+// Game server speaking a line protocol over TCP and/or a Unix socket (Linux, epoll).
+//
+// Usage: chess_server [--port N] [--bind ADDR] [--unix PATH] [--workers N] [--engine-threads N]
+//                     [--engine <spec>] [--max-resident N] [--spill-dir DIR] [--save-dir DIR]
+//
+// One request per line, one reply line per request, in order per connection:
+//   new                      -> ok <id>
+//   move <id> <uci>          -> ok <status> <fen>
+//   undo <id>                -> ok <status> <fen>
+//   state <id>               -> ok <status> <fen>
+//   engine <id>              -> ok <uci> <status> <fen>      (the engine moves for the side to move)
+//   save <id>                -> ok <path>                    (binary save under --save-dir)
+//   close <id>               -> ok
+//   quit                     -> ok, then the server closes the connection
+// Failures reply "error <reason>". <status> is one of ongoing, check, checkmate, stalemate.
+//
+// The event loop only moves bytes: complete lines go to a fixed set of worker threads, which run
+// them against a GameSessionManager and hand replies back through an eventfd. Engine searches run
+// on their own threads, so a slow search holds up neither the loop nor the workers.
+#include "BinarySave.h"
+#include "BoundedQueue.h"
+#include "EnginePlayer.h"
+#include "GameSessionManager.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+constexpr size_t kMaxLineLength = 4096;
+constexpr size_t kMaxConnections = 65536;
+// epoll user data for the non-client descriptors; client ids start above these.
+constexpr uint64_t kWakeId = 1;
+constexpr uint64_t kTcpListenerId = 2;
+constexpr uint64_t kUnixListenerId = 3;
+constexpr uint64_t kFirstConnectionId = 16;
+
+struct Config {
+    std::string bindAddress = "127.0.0.1";
+    int port = 7878;
+    std::string unixPath;
+    int workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int engineThreads = 2;
+    EngineSpec engine = *EngineSpec::parse("cmd=native depth=3");
+    GameSessionManager::Options sessions;
+    std::string saveDirectory = "saves";
+};
+
+struct Request {
+    uint64_t connection = 0;
+    std::string line;
+};
+
+struct Reply {
+    uint64_t connection = 0;
+    std::string text;
+    bool close = false;
+};
+
+struct EngineJob {
+    uint64_t connection = 0;
+    SessionId session = 0;
+    std::string fen;
+    uint64_t hash = 0;
+};
+
+struct Connection {
+    int fd = -1;
+    std::string input;
+    std::string output;
+    std::deque<std::string> pending; // complete lines not yet handed to a worker
+    bool busy = false;               // a request of this connection is being processed
+    bool closing = false;            // close once the output is flushed
+    bool wantsWrite = false;
+};
+
+std::atomic<int> wakeFd{-1};
+std::atomic<bool> stopRequested{false};
+
+void handleSignal(int) {
+    stopRequested = true;
+    uint64_t one = 1;
+    int fd = wakeFd.load();
+    if (fd >= 0) (void)!write(fd, &one, sizeof(one));
+}
+
+void printUsage() {
+    std::cerr << "Usage: chess_server [--port N] [--bind ADDR] [--unix PATH] [--workers N] [--engine-threads N]\n"
+              << "                    [--engine <spec>] [--max-resident N] [--spill-dir DIR] [--save-dir DIR]\n";
+}
+
+bool parseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (arg == "--port") config.port = std::stoi(value());
+            else if (arg == "--bind") config.bindAddress = value();
+            else if (arg == "--unix") config.unixPath = value();
+            else if (arg == "--workers") config.workers = std::max(1, std::stoi(value()));
+            else if (arg == "--engine-threads") config.engineThreads = std::max(1, std::stoi(value()));
+            else if (arg == "--engine") {
+                auto spec = EngineSpec::parse(value());
+                if (!spec) return false;
+                config.engine = *spec;
+            } else if (arg == "--max-resident") config.sessions.maxResident = std::stoull(value());
+            else if (arg == "--spill-dir") config.sessions.spillDirectory = value();
+            else if (arg == "--save-dir") config.saveDirectory = value();
+            else return false;
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string status(GameStatus value) {
+    switch (value) {
+    case GameStatus::Checkmate: return "checkmate";
+    case GameStatus::Stalemate: return "stalemate";
+    case GameStatus::Check: return "check";
+    default: return "ongoing";
+    }
+}
+
+// Session games publish a snapshot after every change, so replies are built from that.
+std::string describe(const GameSnapshot& snapshot) {
+    return status(snapshot.status) + " " + snapshot.fen;
+}
+
+std::string describe(const Game& game) {
+    return describe(*game.snapshot());
+}
+
+class Server {
+public:
+    explicit Server(Config config)
+        : config(std::move(config)),
+          manager(this->config.sessions),
+          requests(kMaxConnections),
+          engineJobs(1024) {}
+
+    bool listen();
+    void run();
+
+private:
+    // Event loop side.
+    void acceptClients(int listener);
+    void readClient(uint64_t id, Connection& connection);
+    void dispatch(uint64_t id, Connection& connection);
+    void flush(uint64_t id, Connection& connection);
+    void closeClient(uint64_t id);
+    void deliverReplies();
+
+    // Worker side.
+    void workerLoop();
+    void engineLoop();
+    void janitorLoop();
+    std::optional<std::string> handle(uint64_t connection, const std::string& line, bool& close);
+    void post(Reply reply);
+
+    Config config;
+    GameSessionManager manager;
+    BoundedQueue<Request> requests;
+    BoundedQueue<EngineJob> engineJobs;
+
+    int epollFd = -1;
+    int tcpListener = -1;
+    int unixListener = -1;
+    std::unordered_map<uint64_t, Connection> connections;
+    uint64_t nextConnectionId = kFirstConnectionId;
+
+    std::mutex repliesMutex;
+    std::vector<Reply> replies;
+
+    std::mutex janitorMutex;
+    std::condition_variable janitorWake;
+    bool stopping = false;
+};
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool Server::listen() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) return false;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeId;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    if (config.port > 0) {
+        tcpListener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int yes = 1;
+        setsockopt(tcpListener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(config.port));
+        if (inet_pton(AF_INET, config.bindAddress.c_str(), &address.sin_addr) != 1 ||
+            bind(tcpListener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(tcpListener, SOMAXCONN) != 0 || !setNonBlocking(tcpListener)) {
+            std::cerr << "Cannot listen on " << config.bindAddress << ":" << config.port << ": " << std::strerror(errno)
+                      << "\n";
+            return false;
+        }
+        event.data.u64 = kTcpListenerId;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, tcpListener, &event);
+    }
+    if (!config.unixPath.empty()) {
+        unixListener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (config.unixPath.size() >= sizeof(address.sun_path)) return false;
+        std::strcpy(address.sun_path, config.unixPath.c_str());
+        unlink(config.unixPath.c_str());
+        if (bind(unixListener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(unixListener, SOMAXCONN) != 0 || !setNonBlocking(unixListener)) {
+            std::cerr << "Cannot listen on " << config.unixPath << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+        event.data.u64 = kUnixListenerId;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, unixListener, &event);
+    }
+    if (tcpListener < 0 && unixListener < 0) {
+        std::cerr << "Nothing to listen on: give --port or --unix.\n";
+        return false;
+    }
+    return true;
+}
+
+void Server::acceptClients(int listener) {
+    while (true) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN, or an error we cannot act on
+        if (connections.size() >= kMaxConnections) {
+            ::close(fd);
+            continue;
+        }
+        if (listener == tcpListener) {
+            int yes = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        }
+        uint64_t id = nextConnectionId++;
+        connections[id].fd = fd;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = id;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void Server::readClient(uint64_t id, Connection& connection) {
+    char buffer[16384];
+    while (true) {
+        ssize_t got = read(connection.fd, buffer, sizeof(buffer));
+        if (got > 0) {
+            connection.input.append(buffer, static_cast<size_t>(got));
+            continue;
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (got < 0 && errno == EINTR) continue;
+        closeClient(id); // peer closed or the socket failed
+        return;
+    }
+
+    size_t start = 0;
+    for (size_t newline; (newline = connection.input.find('\n', start)) != std::string::npos; start = newline + 1) {
+        size_t end = newline;
+        if (end > start && connection.input[end - 1] == '\r') --end;
+        if (end > start) connection.pending.emplace_back(connection.input, start, end - start);
+    }
+    connection.input.erase(0, start);
+    if (connection.input.size() > kMaxLineLength) {
+        connection.output += "error line too long\n";
+        connection.closing = true;
+        connection.pending.clear();
+        connection.input.clear();
+        flush(id, connection);
+        return;
+    }
+    dispatch(id, connection);
+}
+
+void Server::dispatch(uint64_t id, Connection& connection) {
+    if (connection.busy || connection.closing || connection.pending.empty()) return;
+    Request request{id, std::move(connection.pending.front())};
+    connection.pending.pop_front();
+    // At most one request per connection is queued and connections are capped at the queue's
+    // capacity, so this never has to wait.
+    connection.busy = requests.tryPush(request);
+    if (!connection.busy) {
+        connection.output += "error server overloaded\n";
+        flush(id, connection);
+    }
+}
+
+void Server::flush(uint64_t id, Connection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t sent = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.output.erase(0, static_cast<size_t>(sent));
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            closeClient(id);
+            return;
+        }
+    }
+    if (connection.output.empty() && connection.closing && !connection.busy) {
+        closeClient(id);
+        return;
+    }
+    bool wantsWrite = !connection.output.empty();
+    if (wantsWrite != connection.wantsWrite) {
+        connection.wantsWrite = wantsWrite;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP | (wantsWrite ? EPOLLOUT : 0u);
+        event.data.u64 = id;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+}
+
+void Server::closeClient(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    ::close(it->second.fd);
+    connections.erase(it);
+}
+
+void Server::deliverReplies() {
+    uint64_t count;
+    while (read(wakeFd, &count, sizeof(count)) > 0) {
+    }
+    std::vector<Reply> ready;
+    {
+        std::lock_guard<std::mutex> lock(repliesMutex);
+        ready.swap(replies);
+    }
+    for (auto& reply : ready) {
+        auto it = connections.find(reply.connection);
+        if (it == connections.end()) continue; // the client went away meanwhile
+        Connection& connection = it->second;
+        connection.busy = false;
+        connection.output += reply.text;
+        connection.output += '\n';
+        if (reply.close) connection.closing = true;
+        flush(reply.connection, connection);
+        auto again = connections.find(reply.connection);
+        if (again != connections.end()) dispatch(reply.connection, again->second);
+    }
+}
+
+void Server::post(Reply reply) {
+    {
+        std::lock_guard<std::mutex> lock(repliesMutex);
+        replies.push_back(std::move(reply));
+    }
+    uint64_t one = 1;
+    (void)!write(wakeFd, &one, sizeof(one));
+}
+
+std::optional<std::string> Server::handle(uint64_t connection, const std::string& line, bool& close) {
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+    if (command == "new") return "ok " + std::to_string(manager.create());
+    if (command == "quit") {
+        close = true;
+        return "ok";
+    }
+
+    SessionId id = 0;
+    if (!(in >> id)) return "error usage: " + command + " <id> ...";
+    std::string reply = "error no such game";
+    if (command == "move") {
+        std::string text;
+        in >> text;
+        auto move = parseUci(text);
+        if (!move) return "error bad move " + text;
+        manager.withGame(id, [&](Game& game) {
+            MoveStatus result =
+                game.makeMove(move->fromX, move->fromY, move->toX, move->toY, move->promotion.value_or(PieceType::Queen));
+            reply = result == MoveStatus::Ok ? "ok " + describe(game)
+                                             : "error illegal move " + text + ": " + moveStatusMessage(result);
+        });
+    } else if (command == "undo") {
+        manager.withGame(id, [&](Game& game) {
+            if (game.getMoveHistory().empty()) {
+                reply = "error nothing to undo";
+                return;
+            }
+            game.undoMove();
+            reply = "ok " + describe(game);
+        });
+    } else if (command == "state") {
+        // Readers only look up the snapshot; they never wait for the game itself.
+        if (auto snapshot = manager.snapshot(id)) reply = "ok " + describe(*snapshot);
+    } else if (command == "engine") {
+        auto snapshot = manager.snapshot(id);
+        if (!snapshot) return reply;
+        if (snapshot->status == GameStatus::Checkmate || snapshot->status == GameStatus::Stalemate) {
+            return "error game over";
+        }
+        EngineJob job{connection, id, snapshot->fen, snapshot->hash};
+        if (!engineJobs.tryPush(job)) return "error engine busy";
+        return std::nullopt; // the engine thread replies
+    } else if (command == "save") {
+        std::vector<uint8_t> bytes;
+        manager.withGame(id, [&](Game& game) { bytes = encodeBinarySave(game); });
+        if (bytes.empty()) return reply;
+        std::string path = (std::filesystem::path(config.saveDirectory) / (std::to_string(id) + ".bin")).string();
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        bool written = file && std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        if (file && std::fclose(file) != 0) written = false;
+        return written ? "ok " + path : "error cannot write " + path;
+    } else if (command == "close") {
+        return manager.close(id) ? "ok" : reply;
+    } else {
+        return "error unknown command " + command;
+    }
+    return reply;
+}
+
+void Server::workerLoop() {
+    while (auto request = requests.pop()) {
+        Reply reply{request->connection, "", false};
+        if (auto text = handle(request->connection, request->line, reply.close)) {
+            reply.text = std::move(*text);
+            post(std::move(reply));
+        }
+    }
+}
+
+void Server::engineLoop() {
+    EnginePlayer player(config.engine);
+    bool started = player.start();
+    Game game;
+    while (auto job = engineJobs.pop()) {
+        Reply reply{job->connection, "error engine unavailable", false};
+        if (started && game.setFen(job->fen)) {
+            player.newGame();
+            AnalysisResult result = player.think(game, job->fen, {});
+            auto move = parseUci(result.bestMove);
+            reply.text = "error engine returned no move";
+            if (move) {
+                bool found = manager.withGame(job->session, [&](Game& live) {
+                    if (live.getPositionHash() != job->hash) {
+                        reply.text = "error position changed during the search";
+                        return;
+                    }
+                    MoveStatus played = live.makeMove(move->fromX, move->fromY, move->toX, move->toY,
+                                                      move->promotion.value_or(PieceType::Queen));
+                    reply.text = played == MoveStatus::Ok ? "ok " + result.bestMove + " " + describe(live)
+                                                          : "error engine played an illegal move";
+                });
+                if (!found) reply.text = "error no such game";
+            }
+        }
+        post(std::move(reply));
+    }
+}
+
+void Server::janitorLoop() {
+    std::unique_lock<std::mutex> lock(janitorMutex);
+    while (!janitorWake.wait_for(lock, std::chrono::seconds(10), [&] { return stopping; })) {
+        lock.unlock();
+        manager.evictIdle();
+        lock.lock();
+    }
+}
+
+void Server::run() {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config.workers; ++i) threads.emplace_back([this] { workerLoop(); });
+    std::vector<std::thread> engines;
+    for (int i = 0; i < config.engineThreads; ++i) engines.emplace_back([this] { engineLoop(); });
+    std::thread janitor([this] { janitorLoop(); });
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::cerr << "chess_server ready";
+    if (tcpListener >= 0) std::cerr << " on " << config.bindAddress << ":" << config.port;
+    if (unixListener >= 0) std::cerr << " on " << config.unixPath;
+    std::cerr << " with " << config.workers << " worker(s), " << config.engineThreads << " engine thread(s)"
+              << std::endl;
+
+    std::vector<epoll_event> events(256);
+    bool running = true;
+    while (running) {
+        int count = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0 && errno != EINTR) break;
+        for (int i = 0; i < count; ++i) {
+            uint64_t id = events[static_cast<size_t>(i)].data.u64;
+            uint32_t flags = events[static_cast<size_t>(i)].events;
+            if (id == kWakeId) {
+                deliverReplies();
+                if (stopRequested) running = false;
+            } else if (id == kTcpListenerId) {
+                acceptClients(tcpListener);
+            } else if (id == kUnixListenerId) {
+                acceptClients(unixListener);
+            } else {
+                auto it = connections.find(id);
+                if (it == connections.end()) continue;
+                if (flags & EPOLLOUT) flush(id, it->second);
+                it = connections.find(id);
+                if (it != connections.end() && (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                    readClient(id, it->second);
+                }
+            }
+        }
+    }
+
+    std::cerr << "Shutting down" << std::endl;
+    requests.close();
+    for (auto& thread : threads) thread.join();
+    engineJobs.close();
+    for (auto& thread : engines) thread.join();
+    {
+        std::lock_guard<std::mutex> lock(janitorMutex);
+        stopping = true;
+    }
+    janitorWake.notify_all();
+    janitor.join();
+    while (!connections.empty()) closeClient(connections.begin()->first);
+    if (tcpListener >= 0) ::close(tcpListener);
+    if (unixListener >= 0) {
+        ::close(unixListener);
+        unlink(config.unixPath.c_str());
+    }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 2;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(config.saveDirectory, error);
+    Server server(std::move(config));
+    if (!server.listen()) return 1;
+    server.run();
+    return 0;
+}
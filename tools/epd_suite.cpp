@@ -0,0 +1,290 @@
+// Runs EPD test suites (WAC, STS, ...) and reports how many positions are solved.
+//
+// Usage: epd_suite <suite.epd>... [--engine <path>] [--workers N] [--depth D] [--nodes N]
+//                  [--movetime MS] [--quiet]
+//
+// Without --engine the built-in searcher is used. A position counts as solved when the final best
+// move is one of its "bm" moves (or none of its "am" moves). Time to solution is measured from the
+// start of the search to the iteration after which the best move stayed correct. Positions run in
+// parallel, one searcher or engine process per worker.
+#include "Epd.h"
+#include "Pgn.h"
+#include "Search.h"
+#include "UciEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+    std::vector<std::string> inputPaths;
+    std::string enginePath;
+    int workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    SearchLimits limits;
+    bool quiet = false;
+};
+
+struct Problem {
+    std::string suite;
+    std::string id;
+    std::string fen;
+    std::vector<std::string> bestMoves;  // UCI
+    std::vector<std::string> avoidMoves; // UCI
+};
+
+struct Outcome {
+    bool solved = false;
+    std::string played;
+    double seconds = 0;
+    double solvedAfter = 0; // seconds until the best move settled on a solution
+    long long nodes = 0;
+    long long solvedNodes = 0;
+};
+
+void printUsage() {
+    std::cerr << "Usage: epd_suite <suite.epd>... [--engine <path>] [--workers N] [--depth D] [--nodes N]\n"
+              << "                 [--movetime MS] [--quiet]\n";
+}
+
+bool parseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string { return (i + 1 < argc) ? argv[++i] : ""; };
+        try {
+            if (arg == "--engine") config.enginePath = value();
+            else if (arg == "--workers") config.workers = std::max(1, std::stoi(value()));
+            else if (arg == "--depth") config.limits.depth = std::stoi(value());
+            else if (arg == "--nodes") config.limits.nodes = std::stoll(value());
+            else if (arg == "--movetime") config.limits.movetimeMs = std::stoi(value());
+            else if (arg == "--quiet") config.quiet = true;
+            else if (arg.rfind("--", 0) == 0) return false;
+            else config.inputPaths.push_back(arg);
+        } catch (...) {
+            return false;
+        }
+    }
+    if (config.inputPaths.empty()) return false;
+    if (config.limits.depth == 0 && config.limits.nodes == 0 && config.limits.movetimeMs == 0) {
+        config.limits.movetimeMs = 1000;
+    }
+    return true;
+}
+
+// Suites write solutions in SAN; a few use coordinates. Returns the moves as UCI strings.
+std::vector<std::string> resolveMoves(Game& game, const std::vector<std::string>& moves) {
+    std::vector<std::string> resolved;
+    for (const auto& text : moves) {
+        if (auto move = parseSan(game, text)) {
+            resolved.push_back(toUci(*move));
+        } else if (auto uci = parseUci(text)) {
+            resolved.push_back(toUci(*uci));
+        }
+    }
+    return resolved;
+}
+
+bool loadSuite(const std::string& path, std::vector<Problem>& problems) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string suite = path.substr(path.find_last_of("/\\") + 1);
+    Game game;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        auto record = parseEpd(line);
+        if (!record || !game.setFen(record->fen)) continue;
+        Problem problem;
+        problem.suite = suite;
+        problem.id = record->id().empty() ? suite + ":" + std::to_string(lineNumber) : record->id();
+        problem.fen = record->fen;
+        problem.bestMoves = resolveMoves(game, record->operandList("bm"));
+        problem.avoidMoves = resolveMoves(game, record->operandList("am"));
+        if (problem.bestMoves.empty() && problem.avoidMoves.empty()) {
+            std::cerr << suite << ":" << lineNumber << ": no usable bm/am operation, skipped\n";
+            continue;
+        }
+        problems.push_back(std::move(problem));
+    }
+    return true;
+}
+
+bool isSolution(const Problem& problem, const std::string& move) {
+    if (move.empty()) return false;
+    if (!problem.bestMoves.empty()) {
+        return std::find(problem.bestMoves.begin(), problem.bestMoves.end(), move) != problem.bestMoves.end();
+    }
+    return std::find(problem.avoidMoves.begin(), problem.avoidMoves.end(), move) == problem.avoidMoves.end();
+}
+
+// Tracks when the reported best move last switched to a solution.
+class SolutionClock {
+public:
+    SolutionClock(const Problem& problem) : problem(problem), started(Clock::now()) {}
+
+    void report(const std::string& move, long long nodes) {
+        bool correct = isSolution(problem, move);
+        if (correct && !wasCorrect) {
+            since = std::chrono::duration<double>(Clock::now() - started).count();
+            sinceNodes = nodes;
+        }
+        wasCorrect = correct;
+    }
+
+    Outcome finish(const std::string& move, long long nodes) {
+        report(move, nodes);
+        Outcome outcome;
+        outcome.played = move;
+        outcome.solved = wasCorrect;
+        outcome.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        outcome.nodes = nodes;
+        if (outcome.solved) {
+            outcome.solvedAfter = since;
+            outcome.solvedNodes = sinceNodes;
+        }
+        return outcome;
+    }
+
+private:
+    const Problem& problem;
+    Clock::time_point started;
+    bool wasCorrect = false;
+    double since = 0;
+    long long sinceNodes = 0;
+};
+
+Outcome solveNative(Searcher& searcher, Game& game, const Problem& problem, const SearchLimits& limits) {
+    game.setFen(problem.fen);
+    SolutionClock clock(problem);
+    searcher.setIterationCallback([&](const SearchResult& iteration) {
+        clock.report(iteration.best ? toUci(*iteration.best) : "", iteration.nodes);
+    });
+    SearchResult result = searcher.search(game, limits);
+    return clock.finish(result.best ? toUci(*result.best) : "", result.nodes);
+}
+
+Outcome solveUci(UciEngine& engine, const Problem& problem, const SearchLimits& limits) {
+    engine.send("ucinewgame\n");
+    SolutionClock clock(problem);
+    AnalysisResult result = engine.analyse(problem.fen, {}, limits, [&](const PvLine& line) {
+        if (line.multiPv == 1 && !line.pv.empty()) clock.report(line.pv.front(), line.nodes);
+    });
+    return clock.finish(result.bestMove, result.nodes);
+}
+
+std::string formatSeconds(double seconds) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(seconds < 10 ? 3 : 1) << seconds << "s";
+    return out.str();
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage();
+        return 2;
+    }
+    std::vector<Problem> problems;
+    for (const auto& path : config.inputPaths) {
+        if (!loadSuite(path, problems)) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 2;
+        }
+    }
+    if (problems.empty()) {
+        std::cerr << "No positions to run.\n";
+        return 2;
+    }
+    int workerCount = std::min(config.workers, static_cast<int>(problems.size()));
+
+    std::vector<Outcome> outcomes(problems.size());
+    std::atomic<size_t> next{0};
+    std::atomic<bool> engineFailed{false};
+    std::mutex outputMutex;
+    auto reportOne = [&](size_t index) {
+        if (config.quiet) return;
+        const Problem& problem = problems[index];
+        const Outcome& outcome = outcomes[index];
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << std::left << std::setw(24) << problem.id << std::right << (outcome.solved ? "  solved " : "  FAILED ")
+                  << std::setw(6) << (outcome.played.empty() ? "-" : outcome.played);
+        if (outcome.solved) std::cout << "  after " << formatSeconds(outcome.solvedAfter) << ", " << outcome.solvedNodes << " nodes";
+        else if (!problem.bestMoves.empty()) std::cout << "  expected " << problem.bestMoves.front();
+        std::cout << '\n';
+    };
+
+    auto started = Clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back([&]() {
+            std::unique_ptr<UciEngine> engine;
+            Searcher searcher;
+            Game game;
+            if (!config.enginePath.empty()) {
+                engine = std::make_unique<UciEngine>();
+                if (!engine->start(config.enginePath, 20)) {
+                    engineFailed = true;
+                    return;
+                }
+            }
+            for (size_t index = next++; index < problems.size(); index = next++) {
+                outcomes[index] = engine ? solveUci(*engine, problems[index], config.limits)
+                                         : solveNative(searcher, game, problems[index], config.limits);
+                reportOne(index);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    double wall = std::chrono::duration<double>(Clock::now() - started).count();
+    if (engineFailed && next.load() < problems.size()) {
+        std::cerr << "Failed to start engine at: " << config.enginePath << "\n";
+        return 1;
+    }
+
+    // Per-suite and overall totals.
+    struct Totals {
+        size_t positions = 0, solved = 0;
+        double searchSeconds = 0, solveSeconds = 0;
+        long long nodes = 0;
+    };
+    std::vector<std::pair<std::string, Totals>> suites;
+    Totals all;
+    for (size_t i = 0; i < problems.size(); ++i) {
+        if (suites.empty() || suites.back().first != problems[i].suite) suites.push_back({problems[i].suite, {}});
+        for (Totals* totals : {&suites.back().second, &all}) {
+            ++totals->positions;
+            totals->searchSeconds += outcomes[i].seconds;
+            totals->nodes += outcomes[i].nodes;
+            if (outcomes[i].solved) {
+                ++totals->solved;
+                totals->solveSeconds += outcomes[i].solvedAfter;
+            }
+        }
+    }
+    auto printTotals = [](const std::string& name, const Totals& totals) {
+        std::cout << std::left << std::setw(24) << name << std::right << std::setw(5) << totals.solved << " / "
+                  << std::setw(5) << totals.positions << std::fixed << std::setprecision(1) << std::setw(7)
+                  << 100.0 * static_cast<double>(totals.solved) / static_cast<double>(totals.positions) << "%"
+                  << "  avg solve " << formatSeconds(totals.solved ? totals.solveSeconds / static_cast<double>(totals.solved) : 0)
+                  << "  " << static_cast<long long>(totals.searchSeconds > 0 ? totals.nodes / totals.searchSeconds : 0)
+                  << " nodes/s\n";
+    };
+    if (!config.quiet) std::cout << '\n';
+    for (const auto& suite : suites) printTotals(suite.first, suite.second);
+    if (suites.size() > 1) printTotals("total", all);
+    std::cout << all.nodes << " nodes in " << formatSeconds(wall) << " wall time with " << workerCount << " worker(s), "
+              << static_cast<long long>(wall > 0 ? all.nodes / wall : 0) << " nodes/s overall\n";
+    return 0;
+}
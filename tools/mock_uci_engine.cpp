@@ -0,0 +1,198 @@
+// Minimal UCI engine for tests and benchmarks. It plays random legal moves (or a fixed script)
+// and can be told to print a configurable amount of "info" output and to delay each search.
+//
+// Options (via "setoption name <Name> value <v>" or "--name=value" on the command line):
+//   Mode      random | script        (default: random)
+//   Script    comma separated UCI moves returned in order by successive "go" commands
+//   InfoLines number of "info" lines printed before each bestmove   (default: 0)
+//   DelayMs   milliseconds to sleep before answering "go"           (default: 0)
+//   Seed      seed for the random move choice                       (default: 1)
+//   MultiPV   number of PV lines reported per depth                 (default: 1)
+//   CrashAfter searches answered before the process exits on "go" (default: 0, never)
+#include "Game.h"
+#include "UciEngine.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct MockOptions {
+    bool scripted = false;
+    std::vector<std::string> script;
+    int infoLines = 0;
+    int delayMs = 0;
+    unsigned seed = 1;
+    int multiPv = 1;
+    int crashAfter = 0;
+};
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// UCI option names are case-insensitive.
+std::string lowercase(std::string text) {
+    for (auto& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+void applyOption(MockOptions& options, const std::string& optionName, const std::string& value) {
+    std::string name = lowercase(optionName);
+    try {
+        if (name == "mode") {
+            options.scripted = (value == "script");
+        } else if (name == "script") {
+            options.script = splitList(value);
+            options.scripted = true;
+        } else if (name == "infolines") {
+            options.infoLines = std::stoi(value);
+        } else if (name == "delayms") {
+            options.delayMs = std::stoi(value);
+        } else if (name == "seed") {
+            options.seed = static_cast<unsigned>(std::stoul(value));
+        } else if (name == "multipv") {
+            options.multiPv = std::max(1, std::stoi(value));
+        } else if (name == "crashafter") {
+            options.crashAfter = std::max(0, std::stoi(value));
+        }
+    } catch (...) {
+        // Unknown values are ignored, like a real engine would.
+    }
+}
+
+// Returns false if the position could not be set up.
+bool setPosition(Game& game, std::stringstream& ss) {
+    std::string token;
+    ss >> token;
+    game.start();
+    if (token == "fen") {
+        std::string fen;
+        while (ss >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+        if (!game.setFen(fen)) return false;
+    } else if (token == "startpos") {
+        ss >> token;
+    } else {
+        return false;
+    }
+    if (token != "moves") return true;
+    std::vector<std::string> moves;
+    while (ss >> token) moves.push_back(token);
+    game.applyMoves(moves);
+    return true;
+}
+
+int goDepth(std::stringstream& ss) {
+    std::string token;
+    while (ss >> token) {
+        if (token == "depth" && ss >> token) {
+            try { return std::max(1, std::stoi(token)); } catch (...) { return 1; }
+        }
+    }
+    return 1;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    MockOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (arg.rfind("--", 0) == 0 && eq != std::string::npos) {
+            applyOption(options, arg.substr(2, eq - 2), arg.substr(eq + 1));
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+    Game game;
+    game.start();
+    std::mt19937 rng(options.seed);
+    size_t scriptIndex = 0;
+    int searches = 0;
+    bool positionKnown = true;
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::stringstream ss(line);
+        std::string command;
+        ss >> command;
+
+        if (command == "uci") {
+            std::cout << "id name MockUciEngine\n"
+                      << "id author 2Q1K\n"
+                      << "option name Mode type combo default random var random var script\n"
+                      << "option name Script type string default <empty>\n"
+                      << "option name InfoLines type spin default 0 min 0 max 1000000\n"
+                      << "option name DelayMs type spin default 0 min 0 max 600000\n"
+                      << "option name Seed type spin default 1 min 0 max 2147483647\n"
+                      << "option name MultiPV type spin default 1 min 1 max 500\n"
+                      << "option name CrashAfter type spin default 0 min 0 max 1000000\n"
+                      << "option name Skill Level type spin default 20 min 0 max 20\n"
+                      << "uciok" << std::endl;
+        } else if (command == "isready") {
+            std::cout << "readyok" << std::endl;
+        } else if (command == "setoption") {
+            std::string token, name, value;
+            ss >> token; // "name"
+            while (ss >> token && token != "value") {
+                name += name.empty() ? token : " " + token;
+            }
+            std::getline(ss, value);
+            if (!value.empty() && value.front() == ' ') value.erase(0, 1);
+            applyOption(options, name, value);
+            if (lowercase(name) == "seed") rng.seed(options.seed);
+        } else if (command == "ucinewgame") {
+            game.start();
+            positionKnown = true;
+            scriptIndex = 0;
+        } else if (command == "position") {
+            positionKnown = setPosition(game, ss);
+        } else if (command == "go") {
+            if (options.crashAfter > 0 && searches++ == options.crashAfter) std::_Exit(3);
+            if (options.delayMs > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.delayMs));
+            }
+            for (int i = 0; i < options.infoLines; ++i) {
+                std::cout << "info depth " << (i % 30 + 1) << " seldepth " << (i % 30 + 5)
+                          << " multipv 1 score cp " << (i % 50) << " nodes " << (i * 1000 + 1)
+                          << " nps 1000000 time " << i << " pv e2e4 e7e5 g1f3\n";
+            }
+
+            std::string best = "(none)";
+            if (options.scripted) {
+                if (scriptIndex < options.script.size()) best = options.script[scriptIndex++];
+            } else if (positionKnown) {
+                auto moves = game.getLegalMoves();
+                if (!moves.empty()) {
+                    std::shuffle(moves.begin(), moves.end(), rng);
+                    best = toUci(moves.front());
+                    int depth = goDepth(ss);
+                    int slots = std::min(options.multiPv, static_cast<int>(moves.size()));
+                    for (int d = 1; d <= depth; ++d) {
+                        for (int k = 1; k <= slots; ++k) {
+                            std::cout << "info depth " << d << " multipv " << k << " score cp " << (50 - 10 * k)
+                                      << " nodes " << d * 100 + k << " pv " << toUci(moves[k - 1]) << '\n';
+                        }
+                    }
+                }
+            }
+            std::cout << "bestmove " << best << std::endl;
+        } else if (command == "quit") {
+            break;
+        }
+    }
+    return 0;
+}